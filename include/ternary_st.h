@@ -1,6 +1,7 @@
 #ifndef _tst_search_tree_h_
 #define _tst_search_tree_h_  1
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,6 +10,56 @@
 struct node_tst;
 typedef struct node_tst node_tst;
 
+/* forward-reference arena-backed tree handle and typedef */
+struct tst_arena;
+typedef struct tst_arena tst_arena;
+
+/* forward-reference compact (32-bit index node) tree and typedef */
+struct tst_cpt;
+typedef struct tst_cpt tst_cpt;
+
+/* forward-reference frozen (read-only) tree and typedef */
+struct tst_frozen;
+typedef struct tst_frozen tst_frozen;
+
+/* forward-reference prefix cursor and typedef */
+struct tst_cursor;
+typedef struct tst_cursor tst_cursor;
+
+/* forward-reference concurrent tree handle and typedef */
+struct tst_conc;
+typedef struct tst_conc tst_conc;
+
+/* forward-reference persistent (versioned) tree handle and typedef */
+struct tst_pers;
+typedef struct tst_pers tst_pers;
+
+/* forward-reference sharded (first byte dispatch) tree handle and typedef */
+struct tst_shard;
+typedef struct tst_shard tst_shard;
+
+/* forward-reference mapped word file handle and typedef */
+struct tst_mapped;
+typedef struct tst_mapped tst_mapped;
+
+/** 'cpy' value for keyless storage, the node for a word holds no string and
+ *  keys are rebuilt from the nodes on the path, tst_search_key(),
+ *  tst_search_prefix_key() and tst_traverse_key_fn().
+ */
+#define TST_NOKEY 2
+
+/** longest key in chars (bytes for tst_ins_del_len()) inserted by
+ *  tst_ins_del(), tst_ins_del_len(), tst_map_put(), tst_wide_ins_del(),
+ *  tst_burst_ins_del(), tst_build_sorted() and tst_build_parallel(), a
+ *  longer key is not inserted (error, NULL returned). tst_free(),
+ *  tst_traverse_fn(), tst_nodes(), tst_stats(), tst_search_prefix(),
+ *  tst_search_prefix_key() and tst_traverse_key_fn() walk the tree on an
+ *  explicit stack (keys rebuilt from the path are held in full), the
+ *  other walks recurse once per key char and rely on this limit.
+ *  tst_pc_ins_del(), tst_cpt_ins_del(), tst_conc_ins_del() and
+ *  tst_pers_ins_del() keep a limit of 127 chars (NULL returned).
+ */
+#define TST_KEYMAX 4096
 
 /** tst_ins_del() ins/del copy or reference of 's' from ternary search tree.
  *  insert all nodes required for 's' in tree at eqkid node of leaf. if 'del'
@@ -16,6 +67,9 @@ typedef struct node_tst node_tst;
  *  with node->key set to the nul-chracter after final node in search path. if
  *  'cpy' is non-zero allocate storage for 's', otherwise save pointer to 's'.
  *  if 's' already exists in tree, increment node->refcnt. (to be used for del).
+ *  if 'cpy' is TST_NOKEY no string is stored, the key is only held by the
+ *  path (see tst_search_key()) and the node for 's' is returned in place of
+ *  the address of 's'.
  *  returns address of 's' in tree on successful insert (or on delete if refcnt
  *  non-zero), NULL on allocation failure on insert, or on successful removal
  *  of 's' from tree.
@@ -27,13 +81,41 @@ void *tst_ins_del (node_tst **root, char * const *s, const int del, const int cp
  */
 void *tst_search (const node_tst *p, const char *s);
 
+/** tst_search_cmp(), number of nodes compared in tst_search() for 's'
+ *  (found or not), a measure of the lookup cost of the tree shape.
+ */
+size_t tst_search_cmp (const node_tst *p, const char *s);
+
+/** tst_build_sorted() bulk load 'n' words in 's' into tree at 'root'. words
+ *  are sorted (a sorted copy of the pointers is used if 's' is not in tree
+ *  order) and the tree is built by median so each lo/hi sibling tree is
+ *  balanced, rather than the linked lists sorted input gives with
+ *  tst_ins_del(). if 'root' holds a tree, words are inserted in median
+ *  order. 'cpy' as for tst_ins_del(), duplicate words increment refcnt.
+ *  returns root of tree on success, NULL on allocation failure or invalid
+ *  word (nodes added before failure remain in an existing tree).
+ */
+void *tst_build_sorted (node_tst **root, char * const *s, const size_t n,
+                        const int cpy);
+
+/** tst_rebalance() rebalance each lo/hi sibling tree of the tree at 'root'
+ *  in place (Day-Stout-Warren), restoring logarithmic sibling search after
+ *  insert/delete churn without a rebuild. no memory is allocated, nodes are
+ *  only relinked so refcnt and stored string pointers are unchanged. the
+ *  levels of a wide tree and the buckets of a burst tree are kept, the
+ *  lo/hi levels above and below them balanced.
+ *  returns the (new) root.
+ */
+node_tst *tst_rebalance (node_tst **root);
+
 /** tst_search_prefix() fills ptr array 'a' with words prefixed with 's'.
  *  once the node containing the first prefix matching 's' is found
  *  tst_suggest() is called to traverse the ternary_tree beginning
  *  at the node filling 'a' with pointers to all words that contain
  *  the prefix upto 'max' words updating 'n' with the number of words
- *  in 'a'. a pointer to the first node is returned on success
- *  NULL otherwise.
+ *  in 'a'. for a TST_NOKEY tree 'a' holds NULL for each word (see
+ *  tst_search_prefix_key() for the keys). a pointer to the first node is
+ *  returned on success NULL otherwise.
  */
 void *tst_search_prefix (const node_tst *root, const char *s,
                         char **a, int *n, const int max);
@@ -47,12 +129,48 @@ void print_word (const void *node, void *data);
  */
 void tst_traverse_fn (const node_tst *p, void(fn)(const void *, void *), void *data);
 
+/** tst_search_key(), find of 's' in tree rebuilding the key from the nodes
+ *  on the path into 'buf' of 'bufsz' chars, for keyless trees (TST_NOKEY)
+ *  as well as trees holding words. returns 'buf' on success, NULL if not
+ *  found or if the key does not fit in 'buf'.
+ */
+char *tst_search_key (const node_tst *p, const char *s, char *buf,
+                        const size_t bufsz);
+
+/** tst_search_prefix_key() as tst_search_prefix() rebuilding the keys of
+ *  the words prefixed with 's' from the tree path. keys are stored one
+ *  after the other in 'buf' of 'bufsz' chars with pointers in 'a', up to
+ *  'max' keys or until 'buf' is full. returns non-NULL on success, NULL
+ *  otherwise.
+ */
+void *tst_search_prefix_key (const node_tst *root, const char *s,
+                            char *buf, const size_t bufsz,
+                            char **a, int *n, const int max);
+
+/** tst_traverse_key_fn(), traverse tree calling 'fn' on each word with the
+ *  key rebuilt from the tree path. prototype for 'fn' is
+ *  void fn(const void *node, const char *key, void *data). data can be NULL
+ *  if unused.
+ */
+void tst_traverse_key_fn (const node_tst *p,
+                        void(fn)(const void *, const char *, void *), void *data);
+
+/* tst_traverse_fn(), tst_free_all() and tst_free() handle both plain and
+ * path-compressed trees.
+ */
+
 /** free the ternary search tree rooted at p, data storage internal. */
 void tst_free_all (node_tst *p);
 
 /** free the ternary search tree rooted at p, data storage external. */
 void tst_free (node_tst *p);
 
+/** tst_nodes() returns number of nodes in tree rooted at 'p' (plain,
+ *  path-compressed, wide or burst, a node per key of a wide level and per
+ *  word of a bucket).
+ */
+size_t tst_nodes (const node_tst *p);
+
 /** access functions tst_get_key(), tst_get_refcnt, & tst_get_string().
  *  provide access to struct members through opague pointers availale
  *  to program.
@@ -61,5 +179,628 @@ char tst_get_key (const node_tst *node);
 unsigned tst_get_refcnt (const node_tst *node);
 char *tst_get_string (const node_tst *node);
 
-#endif
+/** tst_arena_create() allocate arena-backed tree handle. nodes (and copies of
+ *  words for 'cpy' inserts) are carved from slabs of 'slabsz' bytes (default
+ *  used if 0). returns pointer to new handle, NULL on allocation failure.
+ */
+tst_arena *tst_arena_create (size_t slabsz);
+
+/** tst_arena_ins_del() as tst_ins_del() for tree held by arena 'a'. nodes
+ *  removed on delete are placed on a free list and reused by later inserts,
+ *  storage for copied words is only released by tst_arena_destroy().
+ */
+void *tst_arena_ins_del (tst_arena *a, char * const *s, const int del,
+                            const int cpy);
+
+/** tst_arena_root() returns root of tree held by arena 'a' for use with the
+ *  read-only functions, tst_search(), tst_search_prefix(), etc.. (nodes must
+ *  not be inserted or freed other than through the tst_arena functions)
+ */
+node_tst *tst_arena_root (const tst_arena *a);
+
+/** tst_arena_rebalance() tst_rebalance() tree held by arena 'a'. */
+node_tst *tst_arena_rebalance (tst_arena *a);
+
+/** tst_arena_destroy() free all nodes and data held by arena 'a' in one call,
+ *  (one free per slab, no traversal of the tree).
+ */
+void tst_arena_destroy (tst_arena *a);
+
+/** compact tree, nodes held in one pool with 32-bit lokid/eqkid/hikid
+ *  indexes (16 byte node), words referenced through a string table.
+ *  tst_cpt_create() allocate empty compact tree. returns pointer to new
+ *  tree, NULL on allocation failure.
+ */
+tst_cpt *tst_cpt_create (void);
+
+/** tst_cpt_ins_del() ins/del copy or reference of 's' from compact tree 't'.
+ *  same semantics as tst_ins_del(). the refcnt of a word saturates at
+ *  2^24 - 1, a further insert returns the word uncounted. returns address
+ *  of 's' in tree on successful insert (or on delete if refcnt non-zero),
+ *  NULL on allocation failure on insert, or on successful removal of 's'
+ *  from tree.
+ */
+void *tst_cpt_ins_del (tst_cpt *t, char * const *s, const int del, const int cpy);
+
+/** tst_cpt_search(), non-recursive find of a string in compact tree.
+ *  returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_cpt_search (const tst_cpt *t, const char *s);
+
+/** tst_cpt_search_prefix() fills ptr array 'a' with words prefixed with 's',
+ *  as tst_search_prefix(). returns non-NULL on success, NULL otherwise.
+ */
+void *tst_cpt_search_prefix (const tst_cpt *t, const char *s,
+                            char **a, int *n, const int max);
+
+/** tst_cpt_size() returns bytes allocated for node pool and string table
+ *  of compact tree 't' (storage of copied words not included).
+ */
+size_t tst_cpt_size (const tst_cpt *t);
+
+/** tst_cpt_free() free compact tree 't', if 'freedata' is non-zero the
+ *  copies of words stored in the tree are freed as well.
+ */
+void tst_cpt_free (tst_cpt *t, const int freedata);
+
+/** tst_freeze() compile tree rooted at 'root' into a frozen (read-only) tree
+ *  held in one node array in cache friendly order, with a copy of all words.
+ *  'root' is not modified and can be freed. returns pointer to frozen tree,
+ *  NULL on allocation failure, if tree exceeds 32-bit node/string indexes
+ *  or if tree is path-compressed (see tst_pc_ins_del()), keyless, wide or
+ *  burst (see tst_wide_ins_del(), tst_burst_ins_del()).
+ */
+tst_frozen *tst_freeze (const node_tst *root);
+
+/** tst_frozen_search(), find of a string in frozen tree.
+ *  returns pointer to copy of 's' in frozen tree on success, NULL otherwise.
+ */
+void *tst_frozen_search (const tst_frozen *f, const char *s);
+
+/** tst_frozen_prefix() fills ptr array 'a' with words in frozen tree
+ *  prefixed with 's', up to 'max' words updating 'n' with the number of
+ *  words in 'a', as tst_search_prefix(). returns pointer to the node for
+ *  the last char of the prefix on success, NULL otherwise.
+ */
+void *tst_frozen_prefix (const tst_frozen *f, const char *s,
+                        char **a, int *n, const int max);
+
+/** tst_frozen_save() write frozen tree 'f' to image file 'path'. the image
+ *  holds offsets only (no pointers) and can be mapped by tst_frozen_map().
+ *  returns 0 on success, -1 on error.
+ */
+int tst_frozen_save (const tst_frozen *f, const char *path);
+
+/** tst_save() freeze tree rooted at 'root' and write image file 'path'.
+ *  returns 0 on success, -1 on error.
+ */
+int tst_save (const node_tst *root, const char *path);
+
+/** tst_frozen_map() map image file 'path' written by tst_frozen_save()
+ *  read-only and shared, nodes and strings are used in place with no
+ *  deserialization, so processes mapping the same image share one copy
+ *  through the page cache. only the header is validated, images are
+ *  trusted. returns pointer to frozen tree, NULL on error.
+ */
+tst_frozen *tst_frozen_map (const char *path);
+
+/** tst_frozen_free() free (or unmap) frozen tree 'f'. */
+void tst_frozen_free (tst_frozen *f);
+
+/** tst_pc_ins_del() ins/del copy or reference of 's' from path-compressed
+ *  tree at 'root', same semantics as tst_ins_del(). the unique tail of
+ *  each word is held in one leaf node rather than a node per char. the
+ *  tree must only be modified through tst_pc_ins_del(), tst_pc_search()
+ *  and tst_pc_search_prefix() are used for lookup, tst_traverse_fn(),
+ *  tst_free() and tst_free_all() handle both kinds of tree.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on allocation failure on insert, or on successful
+ *  removal of 's' from tree.
+ */
+void *tst_pc_ins_del (node_tst **root, char * const *s, const int del,
+                        const int cpy);
+
+/** tst_pc_search(), non-recursive find of a string in path-compressed tree.
+ *  returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_pc_search (const node_tst *p, const char *s);
+
+/** tst_pc_search_prefix() fills ptr array 'a' with words prefixed with 's'
+ *  in path-compressed tree, as tst_search_prefix(). returns non-NULL on
+ *  success, NULL otherwise.
+ */
+void *tst_pc_search_prefix (const node_tst *root, const char *s,
+                            char **a, int *n, const int max);
+
+/** tst_cursor_open() open cursor on words in tree at 'root' prefixed with
+ *  'prefix' (all words if 'prefix' is empty). words are returned in sorted
+ *  (traversal) order by tst_cursor_next(), a page at a time. the tree must
+ *  not be modified while the cursor is open. returns pointer to cursor
+ *  (with no words if no word has 'prefix'), NULL on allocation failure or
+ *  if a wide level or bucket (see tst_wide_ins_del(), tst_burst_ins_del())
+ *  is met.
+ */
+tst_cursor *tst_cursor_open (const node_tst *root, const char *prefix);
+
+/** tst_cursor_next() fill ptr array 'a' with up to 'max' of the next words
+ *  of cursor 'c', continuing from the last word returned. no recursion,
+ *  the walk is resumed from the cursor stack so each page costs time in
+ *  proportion to the page only. returns the number of words in 'a' (0 when
+ *  all words have been returned), -1 on allocation failure or if a wide
+ *  level or bucket is met.
+ */
+int tst_cursor_next (tst_cursor *c, char **a, const int max);
+
+/** tst_cursor_close() free cursor 'c'. */
+void tst_cursor_close (tst_cursor *c);
+
+/** tst_topk_ins_del() ins/del copy or reference of 's' from ternary search
+ *  tree as tst_ins_del() (not TST_NOKEY), also keeping the subtree max of
+ *  the nodes on the path in the same descent: the refcnt of a node not
+ *  holding a word is set to the max refcnt of the words below its eqkid,
+ *  for tst_topk_prefix(). returns as tst_ins_del().
+ */
+void *tst_topk_ins_del (node_tst **root, char * const *s, const int del,
+                        const int cpy);
+
+/** tst_topk_index() set the subtree max of each node not holding a word in
+ *  tree at 'root' (built by tst_build_sorted(), tst_pc_ins_del() or
+ *  modified by tst_ins_del()), as kept by tst_topk_ins_del(). returns 0 on
+ *  success, -1 on allocation failure or for a wide or burst tree.
+ */
+int tst_topk_index (node_tst *root);
+
+/** tst_topk_prefix() fills ptr array 'a' with the (up to) 'k' words with the
+ *  largest refcnt prefixed with 's' (all words if 's' is empty), largest
+ *  first, updating 'n' with the number of words in 'a'. best-first search
+ *  on the subtree max held by each node (tree kept by tst_topk_ins_del()
+ *  or indexed by tst_topk_index()), a subtree is only entered when its
+ *  max can place a word in the top 'k', so a short prefix does not
+ *  enumerate all matches. returns pointer to the node for the prefix on
+ *  success, NULL if not found, on allocation failure or for a wide or
+ *  burst tree (see tst_wide_ins_del()).
+ */
+void *tst_topk_prefix (const node_tst *root, const char *s,
+                        char **a, int *n, const int k);
+
+/** tst_search_fuzzy() fills ptr array 'out' with up to 'max' words within
+ *  Levenshtein distance 'maxdist' of 's', in sorted (traversal) order. the
+ *  tree is walked with one edit-distance row per depth and a branch is
+ *  pruned once the min of its row exceeds 'maxdist'. returns number of
+ *  words in 'out', -1 on allocation failure.
+ */
+int tst_search_fuzzy (const node_tst *root, const char *s, const int maxdist,
+                        char **out, const int max);
+
+/** tst_search_fuzzy_prefix() as tst_search_fuzzy() for completion, fills
+ *  'out' with words having a prefix within distance 'maxdist' of 's'.
+ */
+int tst_search_fuzzy_prefix (const node_tst *root, const char *s,
+                            const int maxdist, char **out, const int max);
+
+/** tst_search_pattern() fills ptr array 'a' with words matching pattern
+ *  'pat', where '?' matches any one char and '*' any run of chars (empty
+ *  included), up to 'max' words in sorted (traversal) order, updating 'n'
+ *  with the number of words in 'a'. literal chars are found by descent so
+ *  they prune the tree, only wildcards visit every sibling. 'pat' is
+ *  limited to 63 chars. returns 'a' if a word matches, NULL otherwise.
+ */
+void *tst_search_pattern (const node_tst *root, const char *pat,
+                            char **a, int *n, const int max);
+
+/** tst_search_batch() find each of 'n' strings 'keys' in tree at 'root',
+ *  storing pointer to word (as tst_search()) or NULL in 'results[i]' for
+ *  keys[i]. up to 32 lookups are advanced a node at a time in turn and
+ *  the next node of each is prefetched, so cache misses of independent
+ *  keys overlap rather than each lookup waiting on its own chain of misses.
+ *  a finished lookup is replaced by the next key. for a tree that fits in
+ *  cache a loop of tst_search() is faster. returns number of keys found.
+ */
+size_t tst_search_batch (const node_tst *root, const char * const *keys,
+                        const size_t n, void **results);
+
+/** tst_conc_create() allocate concurrent tree handle, words inserted by
+ *  copy if 'cpy' is non-zero, otherwise by reference. returns pointer to
+ *  new handle, NULL on failure.
+ */
+tst_conc *tst_conc_create (const int cpy);
+
+/** tst_conc_register() register calling reader thread with 'c'.
+ *  returns reader id for tst_conc_read_begin/end(), -1 if CONCRDR (64)
+ *  readers are registered.
+ */
+int tst_conc_register (tst_conc *c);
+
+/** tst_conc_unregister() release reader 'id' (outside a read section). */
+void tst_conc_unregister (tst_conc *c, const int id);
+
+/** tst_conc_read_begin() enter read section for reader 'id'. nodes and
+ *  words found by tst_conc_search() and tst_conc_search_prefix() remain
+ *  valid until tst_conc_read_end(). never blocks.
+ */
+void tst_conc_read_begin (tst_conc *c, const int id);
 
+/** tst_conc_read_end() leave read section for reader 'id'. */
+void tst_conc_read_end (tst_conc *c, const int id);
+
+/** tst_conc_ins_del() ins/del 's' in concurrent tree 'c', same semantics
+ *  as tst_ins_del() with storage set by tst_conc_create(). writers are
+ *  serialized, new nodes are linked with a single release store and nodes
+ *  and copied words removed by a delete are freed only once no reader can
+ *  hold them, so readers never see a partial update or freed memory.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on allocation failure on insert, or on successful
+ *  removal of 's' from tree.
+ */
+void *tst_conc_ins_del (tst_conc *c, char * const *s, const int del);
+
+/** tst_conc_search() as tst_search() on concurrent tree 'c', called within
+ *  a read section. returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_conc_search (const tst_conc *c, const char *s);
+
+/** tst_conc_search_prefix() as tst_search_prefix() on concurrent tree 'c',
+ *  called within a read section. returns non-NULL on success, NULL
+ *  otherwise.
+ */
+void *tst_conc_search_prefix (const tst_conc *c, const char *s,
+                                char **a, int *n, const int max);
+
+/** tst_conc_destroy() free concurrent tree 'c', all nodes, retired nodes
+ *  and copied words (no reader may be in a read section).
+ */
+void tst_conc_destroy (tst_conc *c);
+
+/** tst_pers_create() allocate persistent tree handle, words inserted by
+ *  copy if 'cpy' is non-zero, otherwise by reference. returns pointer to
+ *  new handle, NULL on allocation failure.
+ */
+tst_pers *tst_pers_create (const int cpy);
+
+/** tst_pers_ins_del() ins/del 's' in the current version of persistent tree
+ *  'h', same semantics as tst_ins_del() with storage set by
+ *  tst_pers_create(). each shared node on the path of 's' is copied before
+ *  it is changed, so snapshots taken with tst_snapshot() are unaffected.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on failure on insert, or on successful removal
+ *  of 's' from tree.
+ */
+void *tst_pers_ins_del (tst_pers *h, char * const *s, const int del);
+
+/** tst_pers_root() returns root of the current version of 'h' for use with
+ *  the read-only functions, valid until the next tst_pers_ins_del().
+ */
+node_tst *tst_pers_root (const tst_pers *h);
+
+/** tst_snapshot() returns root of an immutable version of 'h' as it is now,
+ *  in O(1) (the root gains an owner, later edits copy what they change).
+ *  the snapshot is read with the read-only functions (tst_search(),
+ *  tst_search_prefix(), tst_traverse_fn(), ...) and released with
+ *  tst_snapshot_release(). returns NULL for an empty tree or if the root is
+ *  shared by USHRT_MAX + 1 versions.
+ */
+node_tst *tst_snapshot (tst_pers *h);
+
+/** tst_snapshot_release() release snapshot 'snap' of 'h', nodes no longer
+ *  used by any version are freed.
+ */
+void tst_snapshot_release (tst_pers *h, node_tst *snap);
+
+/** tst_pers_destroy() release the current version of 'h' and free the
+ *  handle (snapshots must be released first).
+ */
+void tst_pers_destroy (tst_pers *h);
+
+/** tst_shard_create() allocate sharded tree handle.
+ *  returns pointer to new handle, NULL on failure.
+ */
+tst_shard *tst_shard_create (void);
+
+/** tst_shard_ins_del() tst_ins_del() 's' in the shard for its first byte,
+ *  holding the lock of that shard only (exclusive), so writers of words
+ *  with different first bytes do not block each other. returns as
+ *  tst_ins_del().
+ */
+void *tst_shard_ins_del (tst_shard *t, char * const *s, const int del,
+                        const int cpy);
+
+/** tst_shard_search() tst_search() for 's' in the shard for its first
+ *  byte, holding the lock of that shard shared with other readers. a word
+ *  stored by copy is only valid while no other thread deletes it. returns
+ *  pointer to 's' on success, NULL otherwise.
+ */
+void *tst_shard_search (tst_shard *t, const char *s);
+
+/** tst_shard_search_prefix() tst_search_prefix() for 's' in the shard for
+ *  its first byte, holding the lock shared as tst_shard_search(). returns
+ *  non-NULL on success, NULL otherwise.
+ */
+void *tst_shard_search_prefix (tst_shard *t, const char *s,
+                                char **a, int *n, const int max);
+
+/** tst_shard_traverse_fn() tst_traverse_fn() each shard in turn, holding
+ *  the lock of the shard being traversed (shared). shards are visited in
+ *  signed char order of their byte, so words are in the same order as for
+ *  one tree.
+ */
+void tst_shard_traverse_fn (tst_shard *t, void (fn)(const void *, void *),
+                            void *data);
+
+/** tst_shard_destroy() free all shards, words stored by copy as well if
+ *  'freedata' is non-zero (tst_free_all()), then the handle.
+ */
+void tst_shard_destroy (tst_shard *t, const int freedata);
+
+/** tst_build_parallel() bulk load 'n' words in 's' into empty tree at
+ *  'root' on 'nthreads' threads (1 - 64). words are distributed to buckets
+ *  by their first two chars and the buckets sorted in parallel (unless 's'
+ *  is in tree order), then the top of the tree is laid out by median, the
+ *  same as tst_build_sorted(), down to ranges of about n / (8 * nthreads)
+ *  words, each built as an independent subtree by a worker. the tree is
+ *  identical to the one tst_build_sorted() builds (node for node, refcnt
+ *  included). 'cpy' as for tst_ins_del(). if 'root' holds a tree,
+ *  tst_build_sorted() adds the words. returns root of tree on success,
+ *  NULL on allocation failure or invalid word.
+ */
+void *tst_build_parallel (node_tst **root, char * const *s, const size_t n,
+                            const int cpy, const int nthreads);
+
+/** tst_ins_del_len() ins/del key of 'len' bytes at '*s' as tst_ins_del(),
+ *  the key may hold any byte (nul included), up to TST_KEYMAX (4096)
+ *  bytes (a longer key is refused, NULL returned). a copy ('cpy' non-zero)
+ *  is nul-terminated after 'len' bytes. a key holding no nul or 0x01 byte
+ *  is held the same as the string inserted with tst_ins_del(), so text
+ *  keys may be searched with either. deleting a key not in the tree leaves
+ *  the tree unchanged and returns NULL (unlike tst_ins_del(), which inserts
+ *  it). returns as tst_ins_del().
+ */
+void *tst_ins_del_len (node_tst **root, char * const *s, const size_t len,
+                        const int del, const int cpy);
+
+/** tst_search_len() find key of 'len' bytes at 's' (see tst_ins_del_len()).
+ *  returns pointer to stored key on success (node for TST_NOKEY), NULL
+ *  otherwise.
+ */
+void *tst_search_len (const node_tst *p, const char *s, const size_t len);
+
+/** tst_search_prefix_len() fills ptr array 'a' with keys prefixed with the
+ *  'len' bytes at 's' (every key if 'len' is 0) in sorted order, with the
+ *  length of each in 'lens' (if not NULL), up to 'max' keys, updating 'n'
+ *  with the number of keys in 'a'. for a TST_NOKEY tree 'a' holds NULL for
+ *  each key. returns non-NULL on success, NULL if no key has the prefix.
+ */
+void *tst_search_prefix_len (const node_tst *root, const char *s,
+                            const size_t len, char **a, size_t *lens,
+                            int *n, const int max);
+
+/** tst_load_mapped() map word file 'path' (one word per line, LF or CRLF
+ *  line ends, empty lines skipped) private and writable, split the lines
+ *  in place and insert each word by reference into the empty tree at
+ *  'root' in file order, so the load allocates nodes only, no storage per
+ *  word. pages are copied by the kernel as lines are terminated, the file
+ *  is never written. the words live in the mapping, so the tree is freed
+ *  and the file unmapped together by tst_mapped_free(), and 'root' must
+ *  remain valid until then (words may be added or deleted by reference in
+ *  the meantime). returns pointer to mapping handle, NULL on error (tree
+ *  left empty).
+ */
+tst_mapped *tst_load_mapped (const char *path, node_tst **root);
+
+/** tst_mapped_words() returns number of words inserted by tst_load_mapped()
+ *  (duplicates included).
+ */
+size_t tst_mapped_words (const tst_mapped *m);
+
+/** tst_mapped_free() free the tree at 'root' given to tst_load_mapped()
+ *  (words held by reference, root set NULL), then unmap the word file.
+ */
+void tst_mapped_free (tst_mapped *m);
+
+/** buckets of the tst_stats() histograms, the last counts values of
+ *  TST_HISTMAX - 1 and above.
+ */
+#define TST_HISTMAX 32
+
+/** tree statistics filled by tst_stats(). */
+typedef struct tst_stats_t {
+    size_t nodes,           /* nodes in tree */
+           words,           /* distinct words (terminal nodes) */
+           sibtrees,        /* lo/hi sibling trees (and wide levels) */
+           wide,            /* wide levels (see tst_wide_ins_del()) */
+           buckets,         /* buckets (see tst_burst_ins_del()) */
+           node_bytes,      /* bytes of nodes */
+           str_bytes,       /* bytes of words, strlen + 1 each */
+           depth_max,       /* most eqkid links from root to a word */
+           sib_max,         /* height of tallest sibling tree */
+           worst_cmps;      /* most nodes compared to reach a word */
+    const char *worst;      /* word on the worst path (NULL if keyless) */
+    double avg_cmps;        /* mean nodes compared per word */
+    size_t eq_depth[TST_HISTMAX],   /* words at each eqkid depth */
+           sib_height[TST_HISTMAX]; /* sibling trees of each height */
+} tst_stats_t;
+
+/** tst_stats() fill 'st' with the statistics of tree at 'root' (plain,
+ *  path-compressed, keyless, wide or burst): node and word counts, bytes
+ *  of nodes and of the words held (the caller's for a tree by reference),
+ *  the number of words at each eqkid depth (key length), the number of
+ *  lo/hi sibling trees of each height, and the worst-case search path, the
+ *  most nodes compared to reach a word, with the word (NULL if keyless).
+ *  avg_cmps is the mean nodes compared per word. returns 'st', NULL on
+ *  allocation failure.
+ */
+tst_stats_t *tst_stats (const node_tst *root, tst_stats_t *st);
+
+/** tst_stats_print() print statistics 'st' from tst_stats() to 'fp'. */
+void tst_stats_print (const tst_stats_t *st, FILE *fp);
+
+/** hot-path counters of one operation: calls, nodes visited and key
+ *  tests made. each node visited is tested for a char equal to its key,
+ *  then for the nul ending the key (equal) or for the lo/hi branch, and a
+ *  prefix search also tests the prefix length at each equal node and
+ *  checks each word found below the prefix.
+ */
+typedef struct tst_opcount_t {
+    unsigned long long calls, nodes, cmps;
+} tst_opcount_t;
+
+/** hot-path counters of tst_search(), tst_search_prefix() and
+ *  tst_ins_del(), kept per thread when the library is built with
+ *  -DTST_STATS (make stats=-DTST_STATS), compiled out otherwise.
+ */
+typedef struct tst_counters_t {
+    tst_opcount_t search, prefix, insdel;
+} tst_counters_t;
+
+/** tst_counters_get() copy hot-path counters of the calling thread to 'c',
+ *  all zero unless the library is built with -DTST_STATS.
+ */
+void tst_counters_get (tst_counters_t *c);
+
+/** tst_counters_reset() zero hot-path counters of the calling thread. */
+void tst_counters_reset (void);
+
+/** tst_wide_ins_del() ins/del copy or reference of 's' from wide tree at
+ *  'root', same semantics as tst_ins_del() (TST_NOKEY is not supported,
+ *  nodes in wide levels move). a sibling level reaching 'min' nodes on
+ *  insert is replaced by a wide node, a wide node left with fewer than
+ *  'min / 2' keys on delete is replaced by a balanced lo/hi level ('min' 0
+ *  never changes a level). the tree must only be modified through
+ *  tst_wide_ins_del(), tst_wide_search() and tst_wide_search_prefix() are
+ *  used for lookup, tst_traverse_fn(), tst_nodes(), tst_stats(),
+ *  tst_search_fuzzy(), tst_search_pattern(), tst_rebalance(), tst_free()
+ *  and tst_free_all() handle wide trees, the other walks fail with an
+ *  error. subtree max is not maintained.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on allocation failure on insert, or on successful
+ *  removal of 's' from tree.
+ */
+void *tst_wide_ins_del (node_tst **root, char * const *s, const int del,
+                        const int cpy, const int min);
+
+/** tst_widen() replace each sibling level of 'min' (> 0) or more nodes in
+ *  plain tree (by copy or reference) at 'root' by a wide node, making it a
+ *  wide tree (see tst_wide_ins_del()). returns 0 on success, -1 on
+ *  allocation failure (the tree is valid, some levels left lo/hi).
+ */
+int tst_widen (node_tst **root, const int min);
+
+/** tst_wide_search(), non-recursive find of a string in wide tree.
+ *  returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_wide_search (const node_tst *p, const char *s);
+
+/** tst_wide_search_prefix() fills ptr array 'a' with words prefixed with
+ *  's' in wide tree, as tst_search_prefix(). returns non-NULL on success,
+ *  NULL otherwise.
+ */
+void *tst_wide_search_prefix (const node_tst *root, const char *s,
+                                char **a, int *n, const int max);
+
+/** tst_burst_ins_del() ins/del copy or reference of 's' from burst tree at
+ *  'root', same semantics as tst_ins_del() (TST_NOKEY is not supported).
+ *  the words below a prefix are held in one bucket, a sorted run of their
+ *  suffixes, while there are at most 'max' of them, a bucket growing past
+ *  'max' words bursts into a level of nodes with a bucket below each, and
+ *  a subtree left with at most 'max / 2' words by a delete is gathered back
+ *  into a bucket ('max' 0 gives a plain tree). the tree must only be modified
+ *  through tst_burst_ins_del(), tst_burst_search() and
+ *  tst_burst_search_prefix() are used for lookup, tst_traverse_fn() (with
+ *  a word node for each word), tst_nodes(), tst_stats(), tst_search_fuzzy(),
+ *  tst_search_pattern(), tst_rebalance(), tst_free() and tst_free_all()
+ *  handle burst trees, the other walks fail with an error. subtree max is
+ *  not maintained.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on allocation failure on insert, or on successful
+ *  removal of 's' from tree.
+ */
+void *tst_burst_ins_del (node_tst **root, char * const *s, const int del,
+                        const int cpy, const int max);
+
+/** tst_burst_search(), non-recursive find of a string in burst tree.
+ *  returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_burst_search (const node_tst *p, const char *s);
+
+/** tst_burst_search_prefix() fills ptr array 'a' with words prefixed with
+ *  's' in burst tree, as tst_search_prefix(). returns non-NULL on success,
+ *  NULL otherwise.
+ */
+void *tst_burst_search_prefix (const node_tst *root, const char *s,
+                                char **a, int *n, const int max);
+
+/** value held with each key of a map (see tst_map_put()). */
+typedef union tst_value {
+    uint64_t u;
+    int64_t i;
+    double d;
+    void *ptr;
+} tst_value;
+
+/** tst_map_put() set value of 's' in map at 'root' to 'val', adding 's'
+ *  (by copy or reference per 'cpy', or TST_NOKEY for the value alone) if
+ *  not in the map. a map is a plain tree whose word nodes hold a value
+ *  after the node, so the read-only functions (tst_search(),
+ *  tst_search_prefix(), tst_traverse_fn(), ...) work on it, and it is freed
+ *  with tst_free() or tst_free_all(). keys must be added with tst_map_put()
+ *  or tst_map_upsert() (a word node added by tst_ins_del() has no value)
+ *  and removed with tst_map_del(). returns pointer to the value, valid
+ *  until 's' is removed, NULL on allocation failure.
+ */
+tst_value *tst_map_put (node_tst **root, char * const *s, const int cpy,
+                        const tst_value val);
+
+/** tst_map_upsert() find 's' in map at 'root', adding it with a zero value
+ *  if not found (see tst_map_put()), 'found' (if not NULL) set to 1 if 's'
+ *  was in the map, 0 if added. one walk for find or add, the caller
+ *  updates or initializes the value through the pointer returned. returns
+ *  pointer to the value, NULL on allocation failure.
+ */
+tst_value *tst_map_upsert (node_tst **root, char * const *s, const int cpy,
+                            int *found);
+
+/** tst_map_get() returns pointer to the value of 's' in map at 'root', NULL
+ *  if not found.
+ */
+const tst_value *tst_map_get (const node_tst *root, const char *s);
+
+/** tst_map_update() returns pointer to the value of 's' in map at 'root'
+ *  to update in place, NULL if not found (nothing added).
+ */
+tst_value *tst_map_update (node_tst *root, const char *s);
+
+/** tst_map_value() returns pointer to the value of word node 'node' of a
+ *  map, as passed to the tst_traverse_fn() callback.
+ */
+tst_value *tst_map_value (const void *node);
+
+/** tst_map_del() remove 's' from map at 'root' whatever its refcnt, the
+ *  stored copy freed for a map by copy ('cpy' as added), the value copied
+ *  to 'val' if not NULL. returns 0 on success, -1 if not found.
+ */
+int tst_map_del (node_tst **root, const char *s, const int cpy,
+                    tst_value *val);
+
+/** tst_longest_prefix() find the longest word in tree at 'root' (plain,
+ *  path-compressed or keyless) that is a prefix of the first 'len' chars of
+ *  'text' (the text ends at a nul before 'len'), in one descent. 'mlen' (if
+ *  not NULL) set to the length of the word. returns word node of the word
+ *  (see tst_get_string(), tst_map_value()), NULL if no word is a prefix or
+ *  if a wide level or bucket (see tst_wide_ins_del(), tst_burst_ins_del())
+ *  is met.
+ */
+const node_tst *tst_longest_prefix (const node_tst *root, const char *text,
+                                    const size_t len, size_t *mlen);
+
+/** tst_longest_scan() split the first 'len' chars of 'text' into longest
+ *  matches of words in tree at 'root' (see tst_longest_prefix()), calling
+ *  'fn' with the word node, offset and length of each match and 'data'.
+ *  the scan resumes after each match, and one char on from a position with
+ *  no match (the empty word is not a match), and stops if a wide level or
+ *  bucket is met. returns number of matches.
+ */
+size_t tst_longest_scan (const node_tst *root, const char *text,
+                        const size_t len,
+                        void (fn)(const node_tst *, size_t, size_t, void *),
+                        void *data);
+
+#endif
@@ -1,57 +1,141 @@
-#include "ternary_st.h"
-
-/** max word length to store in ternary search tree, stack size */
-#define WRDMAX 128
-#define STKMAX (WRDMAX * 2)
-
-/** ternary search tree node. */
-typedef struct node_tst {
-    char key;               /* char key for node (null for node with string) */
-    unsigned refcnt;        /* refcnt tracks occurrence of word (for delete) */
-    struct node_tst *lokid, /* ternary low child pointer */
-                    *eqkid, /* ternary equal child pointer */
-                    *hikid; /* ternary high child pointer */
-} node_tst;
-
-/** struct to use for static stack to remove nodes. */
-typedef struct tst_stack {
-    void *data[STKMAX];
-    size_t idx;
-} tst_stack;
+#include "ternary_st_priv.h"
+
+/** initialize stack 's' to use the slots held in the struct. */
+void tst_stack_init (tst_stack *s)
+{
+    s->data = s->buf;
+    s->idx = 0;
+    s->max = STKMAX;
+}
+
+/** make room for 'n' more slots on stack 's', moving the stack to the heap
+ *  (doubling) when the STKMAX slots in the struct are full. returns 0 on
+ *  success, -1 on allocation failure (stack unchanged).
+ */
+int tst_stack_reserve (tst_stack *s, const size_t n)
+{
+    size_t max = s->max;
+    void **tmp;
+
+    if (n <= s->max - s->idx)
+        return 0;
+    while (n > max - s->idx)
+        max *= 2;
+    tmp = s->data == s->buf ? malloc (max * sizeof *tmp)
+                            : realloc (s->data, max * sizeof *tmp);
+    if (!tmp) {
+        fprintf (stderr, "error: tst_stack_reserve(), memory exhausted.\n");
+        return -1;
+    }
+    if (s->data == s->buf)
+        memcpy (tmp, s->buf, sizeof s->buf);
+    s->data = tmp;
+    s->max = max;
+
+    return 0;
+}
 
 /** stack push/pop to store node pointers to delete word from tree.
  *  on delete, store all nodes from root to leaf containing word to
- *  allow word removal and reordering of tree.
+ *  allow word removal and reordering of tree. push returns 'node', NULL
+ *  on allocation failure (so a NULL entry is pushed after
+ *  tst_stack_reserve()).
  */
-static void *tst_stack_push (tst_stack *s, void *node)
+void *tst_stack_push (tst_stack *s, void *node)
 {
-    if (s->idx >= STKMAX)
+    if (tst_stack_reserve (s, 1))
         return NULL;
 
     return (s->data[(s->idx)++] = node);
 }
 
-static void *tst_stack_pop (tst_stack *s)
+void *tst_stack_pop (tst_stack *s)
 {
     if (!s->idx) return NULL;
 
-    void *node = s->data[--(s->idx)];
-    s->data[s->idx] = NULL;
+    return s->data[--(s->idx)];
+}
+
+/** release heap slots of stack 's' (if grown). */
+void tst_stack_free (tst_stack *s)
+{
+    if (s->data != s->buf)
+        free (s->data);
+    s->data = s->buf;
+    s->idx = 0;
+    s->max = STKMAX;
+}
+
+/** replace 'victim' with 'repl' in the link of 'parent' (lokid, eqkid or
+ *  hikid) that holds victim, or as root if victim has no parent.
+ */
+static void tst_relink (node_tst **root, node_tst *parent, node_tst *victim,
+                        node_tst *repl)
+{
+    if (!parent)
+        *root = repl;
+    else if (victim == parent->lokid)
+        parent->lokid = repl;
+    else if (victim == parent->hikid)
+        parent->hikid = repl;
+    else
+        parent->eqkid = repl;
+}
+
+/** remove 'victim' from the lo/hi tree of its siblings, 'parent' is the
+ *  node linking to victim (NULL if root), victim->eqkid must be unused.
+ *  if both lo & hi children, check if lokid->hikid present, if not, move
+ *  hikid to lokid->hikid and replace node with lokid. if lokid->hikid
+ *  present, check hikid->lokid. If not present, then move lokid to
+ *  hikid->lokid and replace node with hikid. if neither rotation is
+ *  possible, replace node with its in-order predecessor (rightmost node in
+ *  the lokid tree). with one or no child, replace node with the child.
+ */
+void tst_del_node (node_tst **root, tst_arena *a, node_tst *parent,
+                    node_tst *victim)
+{
+    node_tst *repl;
+
+    if (victim->lokid && victim->hikid) {   /* victim has both lokid/hikid */
+        if (!victim->lokid->hikid) {        /* check for hikid in lo tree */
+            victim->lokid->hikid = victim->hikid;
+            repl = victim->lokid;
+        }
+        else if (!victim->hikid->lokid) {   /* check for lokid in hi tree */
+            victim->hikid->lokid = victim->lokid;
+            repl = victim->hikid;
+        }
+        else {                              /* in-order predecessor */
+            node_tst *pp = victim->lokid;
+            repl = pp->hikid;
+            while (repl->hikid) {
+                pp = repl;
+                repl = repl->hikid;
+            }
+            pp->hikid = repl->lokid;        /* detach predecessor */
+            repl->lokid = victim->lokid;
+            repl->hikid = victim->hikid;
+        }
+    }
+    else        /* only lokid, only hikid or no children */
+        repl = victim->lokid ? victim->lokid : victim->hikid;
 
-    return node;
+    tst_relink (root, parent, victim, repl);
+    tst_node_free (a, victim);
 }
 
-/** delete current data-node and parent, update 'node' to new parent.
+/** tst_del_word() delete current data-node and parent, update 'node' to new parent.
  *  before delete the current refcnt is checked, if non-zero, occurrences
  *  of the word remain in buffer the node is not deleted, if refcnt zero,
  *  the node is deleted. if 'freedata = 1' the copy of word allocated and
  *  stored as the node->eqkid is freed, if 'freedata = 0', node->eqkid is
- *  stored elsewhere and not freed, root node updated if changed. returns
+ *  stored elsewhere and not freed, root node updated if changed. nodes are
+ *  released to arena 'a' if given, otherwise freed. returns
  *  NULL on success (deleted), otherwise returns the address of victim
  *  if refcnt non-zero.
  */
-static void *tst_del_word (node_tst **root, node_tst *node, tst_stack *stk,
-                            const int freedata)
+void *tst_del_word (node_tst **root, tst_arena *a, node_tst *node,
+                    tst_stack *stk, const int freedata)
 {
     node_tst *victim = node,            /* begin deletion w/victim */
              *parent = tst_stack_pop (stk); /* parent to victim */
@@ -60,156 +144,74 @@ static void *tst_del_word (node_tst **root, node_tst *node, tst_stack *stk,
         return victim;
 
     if (!victim->key && freedata)       /* check key nul & data ours */
-        free (victim->eqkid);           /* free string (data) */
+        tst_str_free (a, victim->eqkid);  /* free string (data) */
 
     /* remove unique suffix chain - parent & victim nodes
      * have no children. simple remove until the first parent
      * found with children.
      */
-    while (!parent->lokid && !parent->hikid &&
+    while (parent && !parent->lokid && !parent->hikid &&
            !victim->lokid && !victim->hikid) {
         parent->eqkid = NULL;
-        free (victim);
+        tst_node_free (a, victim);
         victim = parent;
         parent = tst_stack_pop (stk);
-        if (!parent) {                  /* last word & root node */
-            free (victim);
-            return (void*)(*root = NULL);
-        }
     }
 
-    /* check if victim is prefix for others (victim has lo/hi node).
-     * if both lo & hi children, check if lokid->hikid present, if not,
-     * move hikid to lokid->hikid, replace node with lokid and free node.
-     * if lokid->hikid present, check hikid->lokid. If not present, then
-     * move lokid to hikid->lokid, replace node with hikid free node.
+    /* victim - no children, but was parent->eqkid and parent->lo/hikid
+     * exists, parent left without eqkid becomes victim.
      */
-    if (victim->lokid && victim->hikid) {   /* victim has both lokid/hikid */
-        if (!victim->lokid->hikid) {        /* check for hikid in lo tree */
-            /* rotate victim->hikid to victim->lokid->hikid, and
-             * rotate victim->lokid to place of victim.
-             */
-            victim->lokid->hikid = victim->hikid;
-            if (!parent)
-                *root = victim->lokid;
-            else if (victim == parent->lokid)
-                parent->lokid = victim->lokid;
-            else if (victim == parent->hikid)
-                parent->hikid = victim->lokid;
-            else
-                parent->eqkid = victim->lokid;
-            free (victim);
-            victim = NULL;
-        }
-        else if (!victim->hikid->lokid) {   /* check for lokid in hi tree */
-            /* opposite rotation */
-            victim->hikid->lokid = victim->lokid;
-            if (!parent)
-                *root = victim->hikid;
-            else if (victim == parent->lokid)
-                parent->lokid = victim->hikid;
-            else if (victim == parent->hikid)
-                parent->hikid = victim->hikid;
-            else
-                parent->eqkid = victim->hikid;
-            free (victim);
-            victim = NULL;
-        }
-        else    /* can't rotate, return, leaving victim->eqkid NULL */
-            return NULL;
-    }
-    else if (victim->lokid) {   /* only lokid, replace victim with lokid */
-        parent->eqkid = victim->lokid;
-        free (victim);
-        victim = NULL;
+    if (parent && victim == parent->eqkid &&
+            !victim->lokid && !victim->hikid) {
+        parent->eqkid = NULL;           /* set eqkid NULL */
+        tst_node_free (a, victim);      /* free current victim */
+        victim = parent;                /* set parent = victim */
+        parent = tst_stack_pop (stk);   /* get new parent */
     }
-    else if (victim->hikid) {   /* only hikid, replace victim with hikid */
-        parent->eqkid = victim->hikid;
-        free (victim);
-        victim = NULL;
+
+    /* remove victim from sibling tree rotating lokid or hikid in its place,
+     * (root updated if victim was root, NULL if last word removed)
+     */
+    tst_del_node (root, a, parent, victim);
+
+    return NULL;    /* return NULL on successful free */
+}
+
+/** tst_bst_max() returns max refcnt of the nodes in sibling tree at 'p'. */
+unsigned tst_bst_max (const node_tst *p)
+{
+    unsigned max = 0;
+
+    for (; p; p = p->hikid) {
+        unsigned lo = tst_bst_max (p->lokid);
+        if (lo > max)
+            max = lo;
+        if (p->refcnt > max)
+            max = p->refcnt;
     }
-    else {  /* victim - no children, but parent has other children */
-        if (victim == parent->lokid) {      /* if parent->lokid - trim */
-            parent->lokid = NULL;
-            free (victim);
-            victim = NULL;
-        }
-        else if (victim == parent->hikid) { /* if parent->hikid - trim */
-            parent->hikid = NULL;
-            free (victim);
-            victim = NULL;
-        }
-        else {  /* victim was parent->eqkid, but parent->lo/hikid exists */
-            parent->eqkid = NULL;               /* set eqkid NULL */
-            free (victim);                      /* free current victim */
-            victim = parent;                    /* set parent = victim */
-            parent = tst_stack_pop (stk);       /* get new parent */
-            /* if both victim hi/lokid are present */
-            if (victim->lokid && victim->hikid) {
-                /* same checks and rotations as above */
-                if (!victim->lokid->hikid) {
-                    victim->lokid->hikid = victim->hikid;
-                    if (!parent)
-                        *root = victim->lokid;
-                    else if (victim == parent->lokid)
-                        parent->lokid = victim->lokid;
-                    else if (victim == parent->hikid)
-                        parent->hikid = victim->lokid;
-                    else
-                        parent->eqkid = victim->lokid;
-                    free (victim);
-                    victim = NULL;
-                }
-                else if (!victim->hikid->lokid) {
-                    victim->hikid->lokid = victim->lokid;
-                    if (!parent)
-                        *root = victim->hikid;
-                    else if (victim == parent->lokid)
-                        parent->lokid = victim->hikid;
-                    else if (victim == parent->hikid)
-                        parent->hikid = victim->hikid;
-                    else
-                        parent->eqkid = victim->hikid;
-                    free (victim);
-                    victim = NULL;
-                }
-                else
-                    return NULL;
-            }
-            /* if only lokid, rewire to parent */
-            else if (victim->lokid) {
-                if (parent) {   /* if parent exists, rewire */
-                    if (victim == parent->lokid)
-                        parent->lokid = victim->lokid;
-                    else if (victim == parent->hikid)
-                        parent->hikid = victim->lokid;
-                    else
-                        parent->eqkid = victim->lokid;
-                }
-                else            /* we are new root node, update root */
-                    *root = victim->lokid;  /* make last node root */
-                free (victim);
-                victim = NULL;
-            }
-            /* if only hikid, rewire to parent */
-            else if (victim->hikid) {
-                if (parent) {   /* if parent exists, rewire */
-                    if (victim == parent->lokid)
-                        parent->lokid = victim->hikid;
-                    else if (victim == parent->hikid)
-                        parent->hikid = victim->hikid;
-                    else
-                        parent->eqkid = victim->hikid;
-                }
-                else            /* we are new root node, update root */
-                    *root = victim->hikid;  /* make last node root */
-                free (victim);
-                victim = NULL;
-            }
+
+    return max;
+}
+
+/** tst_max_path() recompute subtree max of the nodes above word node 'word'
+ *  (refcnt changed) whose eqkid is on delete path 'stk' (every node from
+ *  root, not popped), bottom-up, stopping at the first node with max
+ *  unchanged.
+ */
+static void tst_max_path (const tst_stack *stk, const node_tst *word)
+{
+    const node_tst *child = word;
+
+    for (size_t i = stk->idx; i--;) {
+        node_tst *p = stk->data[i];
+        if (p->eqkid == child) {            /* sibling tree of child below */
+            unsigned max = tst_bst_max (p->eqkid);
+            if (max == p->refcnt)
+                break;
+            p->refcnt = max;
         }
+        child = p;
     }
-
-    return victim;  /* return NULL on successful free, *node otherwise */
 }
 
 /** tst_ins_del() ins/del copy or reference of 's' from ternary search tree.
@@ -218,54 +220,120 @@ static void *tst_del_word (node_tst **root, node_tst *node, tst_stack *stk,
  *  with node->key set to the nul-chracter after final node in search path. if
  *  'cpy' is non-zero allocate storage for 's', otherwise save pointer to 's'.
  *  if 's' already exists in tree, increment node->refcnt. (to be used for del).
+ *  if 'cpy' is TST_NOKEY no string is stored, the key is only held by the
+ *  path (see tst_search_key()) and the node for 's' is returned in place of
+ *  the address of 's'.
  *  returns address of 's' in tree on successful insert (or on delete if refcnt
  *  non-zero), NULL on allocation failure on insert, or on successful removal
  *  of 's' from tree.
  */
 void *tst_ins_del (node_tst **root, char * const *s, const int del, const int cpy)
+{
+    return tst_ins_del_a (root, NULL, s, del, cpy);
+}
+
+static void *tst_ins_del_stk (node_tst **root, tst_arena *a, char * const *s,
+                            const int del, const int cpy, const int max,
+                            tst_stack *stk);
+
+/** tst_ins_del_a() tst_ins_del() with node storage from arena 'a', (calloc
+ *  and free are used for node and string storage if 'a' is NULL).
+ */
+void *tst_ins_del_a (node_tst **root, tst_arena *a, char * const *s,
+                        const int del, const int cpy)
+{
+    tst_stack stk;
+    void *ret;
+
+    if (!root || !*s) return NULL;          /* validate parameters */
+
+    tst_stack_init (&stk);
+    ret = tst_ins_del_stk (root, a, s, del, cpy, 0, &stk);
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_topk_ins_del() ins/del copy or reference of 's' as tst_ins_del(),
+ *  keeping the subtree max (see tst_topk_prefix()) in the same descent.
+ */
+void *tst_topk_ins_del (node_tst **root, char * const *s, const int del,
+                        const int cpy)
+{
+    tst_stack stk;
+    void *ret;
+
+    if (!root || !*s || cpy == TST_NOKEY) return NULL;
+
+    tst_stack_init (&stk);
+    ret = tst_ins_del_stk (root, NULL, s, del, cpy, 1, &stk);
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_ins_del_a() with path held on 'stk' (for delete, or if 'max' is
+ *  non-zero to keep the subtree max), any length of word.
+ */
+static void *tst_ins_del_stk (node_tst **root, tst_arena *a, char * const *s,
+                            const int del, const int cpy, const int max,
+                            tst_stack *stk)
 {
     int diff;
     const char *p = *s;
-    tst_stack stk = { .data = {NULL}, .idx = 0 };
     node_tst *curr, **pcurr;
 
-    if (!root || !*s) return NULL;          /* validate parameters */
-    if (strlen (*s) + 1 > STKMAX / 2)       /* limit length to 1/2 STKMAX */
-        return NULL;                        /* 128 char word lenght is plenty */
-
+    TST_COUNT (insdel, calls);
     pcurr = root;                           /* start at root */
     while ((curr = *pcurr)) {               /* iterate to insertion node  */
+        TST_COUNT (insdel, nodes);
+        TST_COUNT (insdel, cmps);           /* equal test */
         diff = *p - curr->key;              /* get ASCII diff for >, <, = */
         if (diff == 0) {                    /* if char equal to node->key */
+            TST_COUNT (insdel, cmps);       /* nul test */
             if (*p++ == 0) {                /* check if word is duplicate */
                 if (del) {                  /* delete instead of insert   */
                     (curr->refcnt)--;       /* decrement reference count  */
+                    if (max)                /* before path can be freed */
+                        tst_max_path (stk, curr);
                     /* chk refcnt, del 's', return NULL on successful del */
-                    return tst_del_word (root, curr, &stk, cpy);
+                    return tst_del_word (root, a, curr, stk, cpy);
                 }
-                else
+                else {
                     curr->refcnt++;         /* increment refcnt if word exists */
+                    if (max)
+                        tst_max_path (stk, curr);
+                }
+                if (cpy == TST_NOKEY)       /* no string, return node */
+                    return (void *)curr;
                 return (void *)curr->eqkid; /* pointer to word / NULL on del  */
             }
             pcurr = &(curr->eqkid);         /* get next eqkid pointer address */
         }
         else if (diff < 0) {                /* if char less than node->key */
+            TST_COUNT (insdel, cmps);       /* lo/hi test */
             pcurr = &(curr->lokid);         /* get next lokid pointer address */
         }
         else {                              /* if char greater than node->key */
+            TST_COUNT (insdel, cmps);       /* lo/hi test */
             pcurr = &(curr->hikid);         /* get next hikid pointer address */
         }
-        if (del)
-            tst_stack_push (&stk, curr);    /* push node on stack for del */
+        if ((del || max) && !tst_stack_push (stk, curr))    /* path */
+            return NULL;
     }
 
     /* if not duplicate, insert remaining chars into tree rooted at curr */
+    if ((size_t)(p - *s) + strlen (p) > TST_KEYMAX) {
+        fprintf (stderr, "error: tst_insert(), key exceeds TST_KEYMAX.\n");
+        return NULL;
+    }
     for (;;) {
         /* allocate memory for node, and fill. use calloc (or include
          * string.h and initialize w/memset) to avoid valgrind warning
          * "Conditional jump or move depends on uninitialised value(s)"
+         * (arena nodes are returned zeroed as well)
          */
-        if (!(*pcurr = calloc (1, sizeof **pcurr))) {
+        if (!(*pcurr = tst_node_alloc (a))) {
             fprintf (stderr, "error: tst_insert(), memory exhausted.\n");
             return NULL;
         }
@@ -281,9 +349,11 @@ void *tst_ins_del (node_tst **root, char * const *s, const int del, const int cp
          * space for data, copy data as final eqkid, and return.
          */
         if (*p++ == 0) {
+            if (cpy == TST_NOKEY)   /* keyless, key is the path to curr */
+                return (void *)curr;
             if (cpy) {  /* allocate storage for 's' */
                 size_t len = strlen (*s);
-                char *eqdata = malloc (len + 1);
+                char *eqdata = tst_str_alloc (a, len + 1);
                 if (!eqdata)
                     return NULL;
                 memcpy (eqdata, *s, len + 1);
@@ -306,38 +376,151 @@ void *tst_search (const node_tst *p, const char *s)
 {
     const node_tst *curr = p;
 
+    TST_COUNT (search, calls);
     while (curr) {                          /* loop over each char in 's' */
         int diff = *s - curr->key;          /* calculate the difference */
+        TST_COUNT (search, nodes);
+        TST_COUNT (search, cmps);           /* equal test */
         if (diff == 0) {                    /* handle the equal case */
+            TST_COUNT (search, cmps);       /* nul test */
             if (*s == 0)    /* if *s = curr->key = nul-char, 's' found */
                 return (void *)curr->eqkid; /* return pointer to 's' */
             s++;
             curr = curr->eqkid;
         }
-        else if (diff < 0)                  /* handle the less than case */
+        else if (diff < 0) {                /* handle the less than case */
+            TST_COUNT (search, cmps);       /* lo/hi test */
             curr = curr->lokid;
-        else
+        }
+        else {
+            TST_COUNT (search, cmps);       /* lo/hi test */
             curr = curr->hikid;             /* handle the greater than case */
+        }
     }
     return NULL;
 }
 
+/** tst_search_cmp(), number of nodes compared in tst_search() for 's'
+ *  (found or not), a measure of the lookup cost of the tree shape.
+ */
+size_t tst_search_cmp (const node_tst *p, const char *s)
+{
+    const node_tst *curr = p;
+    size_t ncmp = 0;
+
+    while (curr) {
+        int diff = *s - curr->key;
+        ncmp++;
+        if (diff == 0) {
+            if (*s == 0)
+                break;
+            s++;
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+    return ncmp;
+}
+
+/** in-order walk of tree at 'p' on an explicit stack, so any depth of tree
+ *  is walked, calling 'fn' with each word node and 'data' until 'fn'
+ *  returns non-zero. the stack holds the sibling trees still to walk, a
+ *  word node to pass to 'fn' is pushed below a NULL entry. room for the
+ *  entries of a node is reserved before they are pushed. returns 0 on
+ *  success, -1 on allocation failure (walk stopped).
+ */
+static int tst_walk (const node_tst *p, int (fn)(const node_tst *, void *),
+                    void *data)
+{
+    tst_stack stk;
+    int ret = 0;
+
+    tst_stack_init (&stk);
+    if (p)
+        tst_stack_push (&stk, (void *)p);   /* slots in struct */
+    while (stk.idx) {
+        if (!(p = tst_stack_pop (&stk))) {  /* word node next */
+            if (fn (tst_stack_pop (&stk), data))
+                break;
+        }
+        else if (p->flags & TST_WIDE) {     /* level nodes, last pushed first */
+            const tst_wnode *w = (const tst_wnode *)p;
+            if ((ret = tst_stack_reserve (&stk, w->n)))
+                break;
+            for (unsigned i = w->n; i--;)
+                tst_stack_push (&stk, (void *)&w->ent[i]);
+        }
+        else if (p->flags & TST_BUCKET) {   /* bucket, word nodes in order */
+            const tst_bucket *b = (const tst_bucket *)p;
+            if ((ret = tst_stack_reserve (&stk, 2 * (size_t)b->n)))
+                break;
+            for (unsigned i = b->n; i--;) {
+                tst_stack_push (&stk, (void *)&b->ent[i]);
+                tst_stack_push (&stk, NULL);
+            }
+        }
+        else {
+            if ((ret = tst_stack_reserve (&stk, 4)))
+                break;
+            if (p->hikid)
+                tst_stack_push (&stk, p->hikid);
+            if (TST_WORD (p)) {
+                tst_stack_push (&stk, (void *)p);
+                tst_stack_push (&stk, NULL);
+            }
+            else if (p->eqkid)
+                tst_stack_push (&stk, p->eqkid);
+            if (p->lokid)
+                tst_stack_push (&stk, p->lokid);
+        }
+    }
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** prefix match state for tst_suggest(). */
+typedef struct tst_match {
+    char c;                 /* nchr'th char of a matching word */
+    size_t nchr;
+    char **a;
+    int *n, max;
+} tst_match;
+
+/** tst_walk() callback of tst_suggest(), add word node 'p' if it matches,
+ *  returns non-zero once 'a' is full.
+ */
+static int tst_suggest_word (const node_tst *p, void *data)
+{
+    tst_match *m = data;
+
+    TST_COUNT (prefix, cmps);               /* word check */
+    if (!p->eqkid)                          /* keyless, below prefix */
+        m->a[(*m->n)++] = NULL;
+    else if (*(((char*)p->eqkid) + m->nchr - 1) == m->c)
+        m->a[(*m->n)++] = (char *)p->eqkid;
+
+    return *m->n == m->max;
+}
+
 /** fill ptr array 'a' with strings matching prefix at node 'p'.
  *  the 'a' array will hold pointers to stored strings with prefix
  *  matching the string passed to tst_matching, ending in 'c', the
- *  nchr'th char in in each matched string.
+ *  nchr'th char in in each matched string. a keyless word (TST_NOKEY)
+ *  has no string to check, so 'p' must be below the prefix for a keyless
+ *  tree, NULL is stored for each word. the walk is iterative (tst_walk()),
+ *  so words of any length are found.
  */
 void tst_suggest (const node_tst *p, const char c, const size_t nchr,
                     char **a, int *n, const int max)
 {
-    if (!p || *n == max)
-        return;
-    tst_suggest (p->lokid, c, nchr, a, n, max);
-    if (p->key)
-        tst_suggest (p->eqkid, c, nchr, a, n, max);
-    else if (*(((char*)p->eqkid) + nchr - 1) == c)
-            a[(*n)++] = (char *)p->eqkid;
-    tst_suggest (p->hikid, c, nchr, a, n, max);
+    tst_match m = { .c = c, .nchr = nchr, .a = a, .n = n, .max = max };
+
+    if (*n < max)
+        tst_walk (p, tst_suggest_word, &m);
 }
 
 /** tst_search_prefix fills ptr array 'a' with words prefixed with 's'.
@@ -362,27 +545,39 @@ void *tst_search_prefix (const node_tst *root, const char *s,
     start = s;  /* reset start to s */
     *n = 0;     /* initialize n - 0 */
 
+    TST_COUNT (prefix, calls);
+
     /* Loop while we haven't hit a NULL node or returned */
     while (curr) {
 
         int diff = *s - curr->key;          /* calculate the difference */
+        TST_COUNT (prefix, nodes);
+        TST_COUNT (prefix, cmps);           /* equal test */
         if (diff == 0) {                    /* handle the equal case */
+            TST_COUNT (prefix, cmps);       /* prefix length test */
             /* check if prefix number of chars reached */
             if ((size_t)(s - start) == nchr - 1) {
-                /* call tst_suggest to fill a with pointer to matching words */
-                tst_suggest (curr, curr->key, nchr, a, n, max);
+                /* call tst_suggest to fill a with pointer to matching words
+                 * below the prefix (a sibling word cannot be told from a
+                 * matching one in a keyless tree) */
+                tst_suggest (curr->eqkid, curr->key, nchr, a, n, max);
                 return (void*)curr;
             }
+            TST_COUNT (prefix, cmps);       /* nul test */
             if (*s == 0)    /* no matching prefix found in tree */
                 return (void *)curr->eqkid;
 
             s++;
             curr = curr->eqkid;
         }
-        else if (diff < 0)                  /* handle the less than case */
+        else if (diff < 0) {                /* handle the less than case */
+            TST_COUNT (prefix, cmps);       /* lo/hi test */
             curr = curr->lokid;
-        else
+        }
+        else {
+            TST_COUNT (prefix, cmps);       /* lo/hi test */
             curr = curr->hikid;             /* handle the greater than case */
+        }
     }
     return NULL;
 }
@@ -395,46 +590,364 @@ void print_word (const void *node, void *data)
     if (data) {} /* suppress warning, data unused in print */
 }
 
+/** word callback and data of tst_traverse_fn(). */
+typedef struct tst_visit {
+    void (*fn)(const void *, void *);
+    void *data;
+} tst_visit;
+
+/** tst_walk() callback of tst_traverse_fn(), never stops the walk. */
+static int tst_visit_word (const node_tst *p, void *data)
+{
+    tst_visit *v = data;
+
+    v->fn (p, v->data);
+
+    return 0;
+}
+
 /** tst_traverse_fn(), traverse tree calling 'fn' on each word.
  *  prototype for 'fn' is void fn(const void *, void *). data can
- *  be NULL if unused.
+ *  be NULL if unused. the walk is iterative, so words of any length are
+ *  visited (the traversal stops early only on allocation failure).
  */
 void tst_traverse_fn (const node_tst *p, void(fn)(const void *, void *), void *data)
 {
-    if (!p)
-        return;
-    tst_traverse_fn (p->lokid, fn, data);
-    if (p->key)
-        tst_traverse_fn (p->eqkid, fn, data);
-    else
-        fn (p, data);
-    tst_traverse_fn (p->hikid, fn, data);
+    tst_visit v = { .fn = fn, .data = data };
+
+    tst_walk (p, tst_visit_word, &v);
+}
+
+/** tst_search_key(), find of 's' in tree rebuilding the key from the nodes
+ *  on the path into 'buf' of 'bufsz' chars, for keyless trees (TST_NOKEY)
+ *  as well as trees holding words. returns 'buf' on success, NULL if not
+ *  found or if the key does not fit in 'buf'.
+ */
+char *tst_search_key (const node_tst *p, const char *s, char *buf,
+                        const size_t bufsz)
+{
+    const node_tst *curr = p;
+    size_t d = 0;
+
+    while (curr) {
+        int diff = *s - curr->key;
+        if (diff == 0) {
+            if (curr->flags & TST_LEAF) {   /* leaf, word held in node */
+                const char *word = (char *)curr->eqkid;
+                size_t len = strlen (word) + 1;
+                if (strcmp (s, word + d) || len > bufsz)
+                    return NULL;
+                return memcpy (buf, word, len);
+            }
+            if (d == bufsz)                 /* key exceeds buf */
+                return NULL;
+            buf[d++] = curr->key;
+            if (*s == 0)
+                return buf;
+            s++;
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+    return NULL;
+}
+
+/** state to rebuild keys of words from the tree path. */
+typedef struct tst_keys {
+    char key[TST_PATHMAX + 1];  /* chars on path to current node */
+    char *out, *end;        /* next free char, end of caller buffer */
+    char **a;               /* pointers to keys in caller buffer */
+    int n, max;             /* number of keys stored, max keys */
+} tst_keys;
+
+/** in-order walk of tree at 'p' at depth 'd' of 'key' (TST_PATHMAX + 1
+ *  chars, the path above 'p' in the first 'd') on an explicit stack as
+ *  tst_walk(), rebuilding the key of each word from the path, calling 'fn'
+ *  with each word node, its key (the word held by a compressed leaf) and
+ *  'data' until 'fn' returns non-zero. the stack holds a node and its depth
+ *  times 2 for each entry, plus 1 if the node itself is next rather than
+ *  its sibling tree. returns 0 on success, -1 on allocation failure or for
+ *  a wide level or bucket (walk stopped).
+ */
+static int tst_walk_key (const node_tst *p, size_t d, char *key,
+                        int (fn)(const node_tst *, const char *, void *),
+                        void *data)
+{
+    tst_stack stk;
+    int ret = 0;
+
+    tst_stack_init (&stk);
+    if (p) {                                /* slots in struct */
+        tst_stack_push (&stk, (void *)p);
+        tst_stack_push (&stk, (void *)(uintptr_t)(2 * d));
+    }
+    while (stk.idx) {
+        uintptr_t tag = (uintptr_t)tst_stack_pop (&stk);
+        p = tst_stack_pop (&stk);
+        d = tag / 2;
+        if (p->flags & TST_LEVEL) {
+            fprintf (stderr, "error: tst_walk_key(), wide or burst tree.\n");
+            ret = -1;
+            break;
+        }
+        if ((ret = tst_stack_reserve (&stk, 6)))
+            break;
+        if (!(tag & 1)) {                   /* sibling tree, node in order */
+            if (p->hikid) {
+                tst_stack_push (&stk, p->hikid);
+                tst_stack_push (&stk, (void *)(uintptr_t)(2 * d));
+            }
+            tst_stack_push (&stk, (void *)p);
+            tst_stack_push (&stk, (void *)(uintptr_t)(2 * d + 1));
+            if (p->lokid) {
+                tst_stack_push (&stk, p->lokid);
+                tst_stack_push (&stk, (void *)(uintptr_t)(2 * d));
+            }
+        }
+        else if (TST_WORD (p)) {
+            const char *k = key;
+            if (p->key)                     /* leaf, word held in node */
+                k = (char *)p->eqkid;
+            else
+                key[d] = 0;
+            if (fn (p, k, data))
+                break;
+        }
+        else if (p->eqkid && d < TST_PATHMAX) {
+            key[d] = p->key;
+            tst_stack_push (&stk, p->eqkid);
+            tst_stack_push (&stk, (void *)(uintptr_t)(2 * (d + 1)));
+        }
+    }
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_walk_key() callback of tst_search_prefix_key(), store key of word
+ *  in caller buffer of 'data', returns non-zero once 'max' keys are stored
+ *  or the buffer is full.
+ */
+static int tst_suggest_key (const node_tst *p, const char *key, void *data)
+{
+    tst_keys *k = data;
+    size_t len = strlen (key) + 1;
+
+    (void)p;
+    if ((size_t)(k->end - k->out) < len)
+        return 1;                           /* buf full */
+    memcpy (k->out, key, len);
+    k->a[k->n++] = k->out;
+    k->out += len;
+
+    return k->n == k->max;
+}
+
+/** tst_search_prefix_key() as tst_search_prefix() rebuilding the keys of
+ *  the words prefixed with 's' from the tree path. keys are stored one
+ *  after the other in 'buf' of 'bufsz' chars with pointers in 'a', up to
+ *  'max' keys or until 'buf' is full. returns non-NULL on success, NULL
+ *  otherwise.
+ */
+void *tst_search_prefix_key (const node_tst *root, const char *s,
+                            char *buf, const size_t bufsz,
+                            char **a, int *n, const int max)
+{
+    const node_tst *curr = root;
+    tst_keys k = { .out = buf, .end = buf + bufsz, .a = a, .n = 0, .max = max };
+    size_t d = 0;
+
+    *n = 0;
+    if (!*s) return NULL;
+
+    while (curr) {
+        int diff = *s - curr->key;
+        if (diff == 0) {
+            if (TST_WORD (curr))            /* word or leaf on prefix path */
+                break;
+            if (d == TST_PATHMAX)           /* no key is longer */
+                return NULL;
+            k.key[d++] = curr->key;
+            if (!*++s)                      /* prefix found */
+                break;
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+    if (!curr)
+        return NULL;
+
+    if (curr->flags & TST_LEAF) {           /* prefix ends within tail */
+        const char *word = (char *)curr->eqkid;
+        size_t len = strlen (word) + 1;
+        if (strncmp (s, word + d, strlen (s)))
+            return NULL;
+        if (max > 0 && len <= bufsz) {
+            memcpy (buf, word, len);
+            a[k.n++] = buf;
+        }
+    }
+    else if (k.n < max)
+        tst_walk_key (curr->eqkid, d, k.key, tst_suggest_key, &k);
+    *n = k.n;
+
+    return (void *)curr;
+}
+
+/** caller's function and data for tst_traverse_key_fn(). */
+typedef struct tst_visit_key {
+    void (*fn)(const void *, const char *, void *);
+    void *data;
+} tst_visit_key;
+
+/** tst_walk_key() callback of tst_traverse_key_fn(), never stops the walk. */
+static int tst_visit_key_word (const node_tst *p, const char *key, void *data)
+{
+    tst_visit_key *v = data;
+
+    v->fn (p, key, v->data);
+
+    return 0;
+}
+
+/** tst_traverse_key_fn(), traverse tree calling 'fn' on each word with the
+ *  key rebuilt from the tree path. prototype for 'fn' is
+ *  void fn(const void *node, const char *key, void *data). data can be NULL
+ *  if unused.
+ */
+void tst_traverse_key_fn (const node_tst *p,
+                        void(fn)(const void *, const char *, void *), void *data)
+{
+    char key[TST_PATHMAX + 1];
+    tst_visit_key v = { .fn = fn, .data = data };
+
+    tst_walk_key (p, 0, key, tst_visit_key_word, &v);
+}
+
+/** free level node 'p' (wide level or bucket, the nodes held in it), words
+ *  as well if 'freedata' is non-zero. the sibling trees below a wide level
+ *  are linked ahead of 'next' through the hikid of the last node of each,
+ *  returns the trees left to free.
+ */
+static node_tst *tst_free_level (node_tst *p, node_tst *next,
+                                const int freedata)
+{
+    if (p->flags & TST_WIDE) {
+        tst_wnode *w = (tst_wnode *)p;
+        for (unsigned i = 0; i < w->n; i++) {
+            node_tst *q = w->ent[i].eqkid, *last = q;
+            if (!w->ent[i].key) {
+                if (freedata)
+                    free (q);
+            }
+            else if (q) {
+                while (last->hikid)
+                    last = last->hikid;
+                last->hikid = next;
+                next = q;
+            }
+        }
+        free (w->ent);
+        free (w);
+    }
+    else {
+        tst_bucket *b = (tst_bucket *)p;
+        if (freedata)
+            for (unsigned i = 0; i < b->n; i++)
+                free (b->ent[i].eqkid);
+        free (b->ent);
+        free (b->sfx);
+        free (b);
+    }
+
+    return next;
+}
+
+/** free tree at 'p', words as well if 'freedata' is non-zero. a lokid is
+ *  rotated up and an eqkid moved to the empty lokid until the node at 'p'
+ *  has neither, then it is freed and its hikid is next, so any depth of
+ *  tree is freed in a loop with no stack.
+ */
+static void tst_free_tree (node_tst *p, const int freedata)
+{
+    while (p) {
+        node_tst *q = p->lokid;
+        if (p->flags & (TST_WIDE | TST_BUCKET))
+            p = tst_free_level (p, p->hikid, freedata);
+        else if (q) {                       /* rotate right */
+            p->lokid = q->hikid;
+            q->hikid = p;
+            p = q;
+        }
+        else if (!TST_WORD (p) && p->eqkid) {
+            p->lokid = p->eqkid;
+            p->eqkid = NULL;
+        }
+        else {
+            q = p->hikid;
+            if (freedata && TST_WORD (p))
+                free (p->eqkid);
+            free (p);
+            p = q;
+        }
+    }
 }
 
 /** free the ternary search tree rooted at p, data storage internal. */
 void tst_free_all (node_tst *p)
 {
-    if (p) {
-        tst_free_all (p->lokid);
-        if (p->key)
-            tst_free_all (p->eqkid);
-        tst_free_all (p->hikid);
-        if (!p->key)
-            free (p->eqkid);
-        free (p);
-    }
+    tst_free_tree (p, 1);
 }
 
 /** free the ternary search tree rooted at p, data storage external. */
 void tst_free (node_tst *p)
 {
-    if (p) {
-        tst_free (p->lokid);
-        if (p->key)
-            tst_free (p->eqkid);
-        tst_free (p->hikid);
-        free (p);
+    tst_free_tree (p, 0);
+}
+
+/** tst_nodes() returns number of nodes in tree rooted at 'p' (plain,
+ *  path-compressed, wide or burst, a node per key of a wide level and per
+ *  word of a bucket).
+ */
+size_t tst_nodes (const node_tst *p)
+{
+    tst_stack stk;
+    size_t n = 0;
+
+    tst_stack_init (&stk);
+    if (p && !tst_stack_push (&stk, (void *)p))
+        stk.idx = 0;
+    while (stk.idx) {
+        p = tst_stack_pop (&stk);
+        if (p->flags & TST_BUCKET) {
+            n += ((const tst_bucket *)p)->n;
+            continue;
+        }
+        if (p->flags & TST_WIDE) {
+            const tst_wnode *w = (const tst_wnode *)p;
+            n += w->n;
+            for (unsigned i = 0; i < w->n; i++)
+                if (w->ent[i].key && !tst_stack_push (&stk, w->ent[i].eqkid))
+                    goto done;
+            continue;
+        }
+        n++;
+        if ((p->lokid && !tst_stack_push (&stk, p->lokid)) ||
+                (p->hikid && !tst_stack_push (&stk, p->hikid)) ||
+                (!TST_WORD (p) && p->eqkid &&
+                    !tst_stack_push (&stk, p->eqkid)))
+            break;
     }
+done:
+    tst_stack_free (&stk);
+
+    return n;
 }
 
 /** access functions tst_get_key(), tst_get_refcnt, & tst_get_string().
@@ -453,7 +966,7 @@ unsigned tst_get_refcnt (const node_tst *node)
 
 char *tst_get_string (const node_tst *node)
 {
-    if (node && !node->key)
+    if (node && TST_WORD (node))
         return (char*)node->eqkid;
 
     return NULL;
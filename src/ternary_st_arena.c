@@ -0,0 +1,164 @@
+#include <stddef.h>
+
+#include "ternary_st_priv.h"
+
+/** default slab size (bytes) if 0 given to tst_arena_create() */
+#define SLABSZ (1u << 20)
+
+/** slab of storage, nodes and strings are carved from mem. */
+typedef struct tst_slab {
+    struct tst_slab *next;  /* next (older) slab in arena */
+    size_t used,            /* bytes of mem handed out */
+           size;            /* bytes of mem available */
+    max_align_t mem[];      /* storage (aligned for node_tst) */
+} tst_slab;
+
+/** arena-backed tree handle. */
+struct tst_arena {
+    node_tst *root;         /* root of tree held by arena */
+    tst_slab *slabs;        /* list of slabs, current slab first */
+    node_tst *freelist;     /* deleted nodes, chained through eqkid */
+    size_t slabsz;          /* bytes of storage per slab */
+};
+
+/** allocate slab with 'size' bytes of storage.
+ *  returns pointer to new slab, NULL on allocation failure.
+ */
+static tst_slab *tst_slab_new (size_t size)
+{
+    tst_slab *slab = malloc (sizeof *slab + size);
+
+    if (!slab) {
+        fprintf (stderr, "error: tst_slab_new(), memory exhausted.\n");
+        return NULL;
+    }
+    slab->next = NULL;
+    slab->used = 0;
+    slab->size = size;
+
+    return slab;
+}
+
+/** carve 'size' bytes aligned to 'align' from current slab of arena 'a',
+ *  adding new slab when current slab is exhausted. oversize requests are
+ *  given their own slab linked behind the current slab so it remains in use.
+ *  returns pointer to storage, NULL on allocation failure.
+ */
+static void *tst_slab_carve (tst_arena *a, size_t size, size_t align)
+{
+    tst_slab *slab = a->slabs;
+
+    if (slab) {
+        size_t off = (slab->used + align - 1) & ~(align - 1);
+        if (off + size <= slab->size) {     /* fits in current slab */
+            slab->used = off + size;
+            return (char *)slab->mem + off;
+        }
+        if (size > a->slabsz / 4) {         /* oversize, own slab */
+            tst_slab *big = tst_slab_new (size);
+            if (!big)
+                return NULL;
+            big->used = size;
+            big->next = slab->next;
+            slab->next = big;
+            return big->mem;
+        }
+    }
+
+    if (!(slab = tst_slab_new (size > a->slabsz ? size : a->slabsz)))
+        return NULL;
+    slab->next = a->slabs;                  /* new current slab */
+    a->slabs = slab;
+    slab->used = size;
+
+    return slab->mem;
+}
+
+/** tst_arena_create() allocate arena-backed tree handle. nodes (and copies of
+ *  words for 'cpy' inserts) are carved from slabs of 'slabsz' bytes (default
+ *  used if 0). returns pointer to new handle, NULL on allocation failure.
+ */
+tst_arena *tst_arena_create (size_t slabsz)
+{
+    tst_arena *a = calloc (1, sizeof *a);
+
+    if (!a) {
+        fprintf (stderr, "error: tst_arena_create(), memory exhausted.\n");
+        return NULL;
+    }
+    a->slabsz = slabsz < sizeof (node_tst) * 16 ? SLABSZ : slabsz;
+
+    return a;
+}
+
+/** tst_arena_node() returns zeroed node from free list of arena 'a' or carved
+ *  from current slab, NULL on allocation failure.
+ */
+node_tst *tst_arena_node (tst_arena *a)
+{
+    node_tst *node = a->freelist;
+
+    if (node)
+        a->freelist = node->eqkid;
+    else if (!(node = tst_slab_carve (a, sizeof *node, _Alignof (node_tst))))
+        return NULL;
+
+    memset (node, 0, sizeof *node);
+
+    return node;
+}
+
+/** tst_arena_node_free() return 'node' to free list of arena 'a'. */
+void tst_arena_node_free (tst_arena *a, node_tst *node)
+{
+    node->eqkid = a->freelist;
+    a->freelist = node;
+}
+
+/** tst_arena_str() storage for string of 'size' bytes from arena 'a'. */
+char *tst_arena_str (tst_arena *a, size_t size)
+{
+    return tst_slab_carve (a, size, 1);
+}
+
+/** tst_arena_ins_del() as tst_ins_del() for tree held by arena 'a'. nodes
+ *  removed on delete are placed on a free list and reused by later inserts,
+ *  storage for copied words is only released by tst_arena_destroy().
+ */
+void *tst_arena_ins_del (tst_arena *a, char * const *s, const int del,
+                            const int cpy)
+{
+    if (!a) return NULL;
+
+    return tst_ins_del_a (&a->root, a, s, del, cpy);
+}
+
+/** tst_arena_root() returns root of tree held by arena 'a' for use with the
+ *  read-only functions, tst_search(), tst_search_prefix(), etc..
+ */
+node_tst *tst_arena_root (const tst_arena *a)
+{
+    return a ? a->root : NULL;
+}
+
+/** tst_arena_rebalance() tst_rebalance() tree held by arena 'a'. */
+node_tst *tst_arena_rebalance (tst_arena *a)
+{
+    return a ? tst_rebalance (&a->root) : NULL;
+}
+
+/** tst_arena_destroy() free all nodes and data held by arena 'a' in one call,
+ *  (one free per slab, no traversal of the tree).
+ */
+void tst_arena_destroy (tst_arena *a)
+{
+    if (!a)
+        return;
+
+    while (a->slabs) {
+        tst_slab *victim = a->slabs;
+        a->slabs = victim->next;
+        free (victim);
+    }
+    free (a);
+}
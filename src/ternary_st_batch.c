@@ -0,0 +1,83 @@
+#include "ternary_st_priv.h"
+
+/** lookups in flight in tst_search_batch() */
+#define BATCHW 32
+
+/** prefetch node 'p' for reading (no-op without gcc/clang builtin) */
+#if defined (__GNUC__)
+#define TST_PREFETCH(p) __builtin_prefetch ((p), 0, 3)
+#else
+#define TST_PREFETCH(p) ((void)(p))
+#endif
+
+/** lookup in flight, next node to compare, rest of key and key index. */
+typedef struct tst_probe {
+    const node_tst *node;
+    const char *s;
+    size_t i;
+} tst_probe;
+
+/** tst_search_batch() find each of 'n' strings 'keys' in tree at 'root',
+ *  storing pointer to word (as tst_search()) or NULL in 'results[i]' for
+ *  keys[i]. up to 32 lookups are advanced a node at a time in turn and
+ *  the next node of each is prefetched, so cache misses of independent
+ *  keys overlap rather than each lookup waiting on its own chain of misses.
+ *  a finished lookup is replaced by the next key. for a tree that fits in
+ *  cache a loop of tst_search() is faster. returns number of keys found.
+ */
+size_t tst_search_batch (const node_tst *root, const char * const *keys,
+                        const size_t n, void **results)
+{
+    tst_probe pr[BATCHW];
+    size_t live = 0, next = 0, found = 0;
+
+    TST_PREFETCH (root);
+    for (; live < BATCHW && next < n; live++, next++) {
+        pr[live].node = root;
+        pr[live].s = keys[next];
+        pr[live].i = next;
+    }
+
+    while (live) {
+        for (size_t j = 0; j < live;) {     /* one node step per lookup */
+            tst_probe *q = pr + j;
+            const node_tst *curr = q->node;
+            void *word = NULL;
+            int done = !curr;
+
+            if (curr) {
+                int diff = *q->s - curr->key;
+                if (diff == 0) {
+                    if (*q->s == 0) {
+                        word = curr->eqkid;
+                        done = 1;
+                        found++;
+                    }
+                    else {
+                        q->s++;
+                        q->node = curr->eqkid;
+                    }
+                }
+                else
+                    q->node = diff < 0 ? curr->lokid : curr->hikid;
+            }
+            if (!done) {                    /* still searching */
+                TST_PREFETCH (q->node);
+                j++;
+                continue;
+            }
+
+            results[q->i] = word;           /* done, found or not */
+            if (next < n) {                 /* replace with next key */
+                q->node = root;
+                q->s = keys[next];
+                q->i = next++;
+                j++;
+            }
+            else
+                *q = pr[--live];
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,531 @@
+#include <stdatomic.h>
+#include <threads.h>
+
+#include "ternary_st_priv.h"
+
+/** compare strings in tree order, chars compared as (char) the same as
+ *  node->key in the tree (so order matches tst_traverse_fn()).
+ */
+static int tst_strcmp (const char *a, const char *b)
+{
+    for (; *a && *a == *b; a++, b++) {}
+
+    return (*a > *b) - (*a < *b);
+}
+
+/** qsort compare for array of pointers to strings in tree order. */
+static int tst_strcmp_ptrs (const void *a, const void *b)
+{
+    return tst_strcmp (*(char * const *)a, *(char * const *)b);
+}
+
+/** first index in [lo, hi) of sorted 's' with char at 'd' not less than
+ *  'c' (or greater than 'c' if 'past' non-zero).
+ */
+static size_t tst_bound (char * const *s, size_t lo, size_t hi, const size_t d,
+                        const char c, const int past)
+{
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        char k = s[mid][d];
+        if (k < c || (past && k == c))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/** build tree for sorted words [lo, hi) of 's' sharing first 'd' chars.
+ *  the median word selects the key at 'd' for the node, the words with a
+ *  lesser char at 'd' make up the lokid tree, the words with a greater
+ *  char the hikid tree, so each lo/hi sibling tree is balanced by the
+ *  number of words below it. duplicate words give one node with refcnt
+ *  set to the number of duplicates. 'err' set non-zero on allocation
+ *  failure (the nodes built are linked so the tree can be freed).
+ */
+static node_tst *tst_build_range (char * const *s, size_t lo, size_t hi,
+                                const size_t d, const int cpy, int *err)
+{
+    node_tst *node;
+    size_t glo, ghi;
+    char c;
+
+    if (lo >= hi)
+        return NULL;
+
+    if (!(node = tst_node_alloc (NULL))) {
+        fprintf (stderr, "error: tst_build_sorted(), memory exhausted.\n");
+        *err = 1;
+        return NULL;
+    }
+
+    c = s[lo + (hi - lo) / 2][d];
+    glo = tst_bound (s, lo, hi, d, c, 0);   /* words with char c at d */
+    ghi = tst_bound (s, glo, hi, d, c, 1);
+
+    node->key = c;
+    node->refcnt = 1;
+    node->lokid = tst_build_range (s, lo, glo, d, cpy, err);
+    node->hikid = tst_build_range (s, ghi, hi, d, cpy, err);
+
+    if (c)
+        node->eqkid = tst_build_range (s, glo, ghi, d + 1, cpy, err);
+    else {                                  /* word and duplicates */
+        node->refcnt = ghi - glo;
+        if (cpy == TST_NOKEY)
+            node->eqkid = NULL;
+        else if (cpy) {
+            char *eqdata = tst_str_alloc (NULL, d + 1);
+            if (!eqdata) {
+                *err = 1;
+                return node;
+            }
+            memcpy (eqdata, s[glo], d + 1);
+            node->eqkid = (node_tst *)eqdata;
+        }
+        else
+            node->eqkid = (node_tst *)s[glo];
+    }
+
+    return node;
+}
+
+/** insert words [lo, hi) of sorted 's' in median order into existing tree. */
+static int tst_ins_median (node_tst **root, char * const *s, size_t lo,
+                            size_t hi, const int cpy)
+{
+    size_t mid;
+
+    if (lo >= hi)
+        return 0;
+
+    mid = lo + (hi - lo) / 2;
+    if (!tst_ins_del (root, &s[mid], 0, cpy))
+        return -1;
+
+    if (tst_ins_median (root, s, lo, mid, cpy))
+        return -1;
+
+    return tst_ins_median (root, s, mid + 1, hi, cpy);
+}
+
+/** tst_build_sorted() bulk load 'n' words in 's' into tree at 'root'. words
+ *  are sorted (a sorted copy of the pointers is used if 's' is not in tree
+ *  order) and the tree is built by median so each lo/hi sibling tree is
+ *  balanced, rather than the linked lists sorted input gives with
+ *  tst_ins_del(). if 'root' holds a tree, words are inserted in median
+ *  order. 'cpy' as for tst_ins_del(), duplicate words increment refcnt.
+ *  returns root of tree on success, NULL on allocation failure or invalid
+ *  word (nodes added before failure remain in an existing tree).
+ */
+void *tst_build_sorted (node_tst **root, char * const *s, const size_t n,
+                        const int cpy)
+{
+    char **sorted = NULL;
+    char * const *w = s;
+    int err = 0;
+
+    if (!root || (!s && n))
+        return NULL;
+
+    for (size_t i = 0; i < n; i++) {        /* validate and check order */
+        if (!s[i])
+            return NULL;
+        if (strlen (s[i]) > TST_KEYMAX) {
+            fprintf (stderr, "error: tst_build_sorted(), key exceeds TST_KEYMAX.\n");
+            return NULL;
+        }
+        if (i && w == s && tst_strcmp (s[i - 1], s[i]) > 0)
+            w = NULL;
+    }
+
+    if (!w) {                               /* sort copy of pointers */
+        if (!(sorted = malloc (n * sizeof *sorted))) {
+            fprintf (stderr, "error: tst_build_sorted(), memory exhausted.\n");
+            return NULL;
+        }
+        memcpy (sorted, s, n * sizeof *sorted);
+        qsort (sorted, n, sizeof *sorted, tst_strcmp_ptrs);
+        w = sorted;
+    }
+
+    if (*root)                              /* add to existing tree */
+        err = tst_ins_median (root, w, 0, n, cpy);
+    else {
+        *root = tst_build_range (w, 0, n, 0, cpy, &err);
+        if (err) {
+            if (cpy)
+                tst_free_all (*root);
+            else
+                tst_free (*root);
+            *root = NULL;
+        }
+    }
+    free (sorted);
+
+    return err ? NULL : *root;
+}
+
+/** max worker threads for tst_build_parallel() */
+#define PARMAX 64
+
+/** number of sort buckets, one per first two chars */
+#define NBUCKET 65536
+
+/** range of sorted words at depth 'd' to build (or sort) on a worker,
+ *  the tree built is stored at 'slot'.
+ */
+typedef struct tst_par_task {
+    size_t lo, hi, d;
+    node_tst **slot;
+} tst_par_task;
+
+/** parallel build state shared by the workers. */
+typedef struct tst_par {
+    char **w;               /* words, sorted in tree order once sort done */
+    tst_par_task *task;     /* sort or build ranges, taken in order */
+    size_t ntask, taskmax;
+    size_t grain;           /* ranges up to grain words built as one task */
+    int cpy, sort;          /* storage, sort (not build) tasks */
+    atomic_size_t next;     /* next task to take */
+    atomic_int err;
+} tst_par;
+
+/** grow array at '*a' ('*max' members of 'size') by 2x. returns 0 on
+ *  success, -1 on allocation failure (array unchanged).
+ */
+static int tst_par_grow (void *a, size_t *max, const size_t size)
+{
+    size_t nmax = *max ? *max * 2 : 256;
+    void *tmp = realloc (*(void **)a, nmax * size);
+
+    if (!tmp) {
+        fprintf (stderr, "error: tst_build_parallel(), memory exhausted.\n");
+        return -1;
+    }
+    *(void **)a = tmp;
+    *max = nmax;
+
+    return 0;
+}
+
+/** add task for range [lo, hi) at depth 'd' built at 'slot'. */
+static int tst_par_add (tst_par *p, size_t lo, size_t hi, size_t d,
+                        node_tst **slot)
+{
+    if (p->ntask == p->taskmax &&
+            tst_par_grow (&p->task, &p->taskmax, sizeof *p->task))
+        return -1;
+    p->task[p->ntask++] = (tst_par_task){ lo, hi, d, slot };
+
+    return 0;
+}
+
+/** worker, take tasks in turn until none remain, sorting each range or
+ *  building it with tst_build_range() (so each subtree is the same as in
+ *  a serial build).
+ */
+static int tst_par_worker (void *arg)
+{
+    tst_par *p = arg;
+    size_t i;
+
+    while ((i = atomic_fetch_add (&p->next, 1)) < p->ntask) {
+        tst_par_task *t = &p->task[i];
+        int err = 0;
+
+        if (p->sort)
+            qsort (p->w + t->lo, t->hi - t->lo, sizeof *p->w, tst_strcmp_ptrs);
+        else {
+            *t->slot = tst_build_range (p->w, t->lo, t->hi, t->d, p->cpy, &err);
+            if (err)
+                atomic_store (&p->err, 1);
+        }
+    }
+
+    return 0;
+}
+
+/** run all tasks in 'p' on 'nthreads' threads (the caller one of them),
+ *  fewer if a thread cannot be created.
+ */
+static void tst_par_run (tst_par *p, int nthreads)
+{
+    thrd_t tid[PARMAX];
+    int nt = 0;
+
+    atomic_store (&p->next, 0);
+    while (nt < nthreads - 1 &&
+            thrd_create (&tid[nt], tst_par_worker, p) == thrd_success)
+        nt++;
+    tst_par_worker (p);
+    while (nt--)
+        thrd_join (tid[nt], NULL);
+}
+
+/** lay out sorted words [lo, hi) at depth 'd' at 'slot' as
+ *  tst_build_range() would, building the nodes over ranges larger than
+ *  grain here and adding a task for each smaller range (and for a range
+ *  whose median word ends at 'd'). returns 0 on success, -1 on failure.
+ */
+static int tst_par_plan (tst_par *p, node_tst **slot, size_t lo, size_t hi,
+                        const size_t d)
+{
+    node_tst *node;
+    size_t glo, ghi;
+    char c;
+
+    *slot = NULL;
+    if (lo >= hi)
+        return 0;
+
+    c = p->w[lo + (hi - lo) / 2][d];
+    if (hi - lo <= p->grain || !c)
+        return tst_par_add (p, lo, hi, d, slot);
+
+    if (!(*slot = node = tst_node_alloc (NULL))) {
+        fprintf (stderr, "error: tst_build_parallel(), memory exhausted.\n");
+        return -1;
+    }
+
+    glo = tst_bound (p->w, lo, hi, d, c, 0);
+    ghi = tst_bound (p->w, glo, hi, d, c, 1);
+    node->key = c;
+    node->refcnt = 1;
+
+    if (tst_par_plan (p, &node->lokid, lo, glo, d) ||
+            tst_par_plan (p, &node->hikid, ghi, hi, d))
+        return -1;
+
+    return tst_par_plan (p, &node->eqkid, glo, ghi, d + 1);
+}
+
+/** sort bucket for word 's', by first two chars in tree (signed) order. */
+static size_t tst_par_bucket (const char *s)
+{
+    unsigned hi = (unsigned char)s[0] ^ 0x80,
+             lo = s[0] ? (unsigned char)s[1] ^ 0x80 : 0x80;
+
+    return hi << 8 | lo;
+}
+
+/** sort words 's' into 'p->w', distributed to buckets by first two chars
+ *  then each bucket sorted as a task. returns 0 on success, -1 on failure.
+ */
+static int tst_par_sort (tst_par *p, char * const *s, const size_t n,
+                        const int nthreads)
+{
+    size_t *start = calloc (NBUCKET + 1, sizeof *start);
+
+    if (!start) {
+        fprintf (stderr, "error: tst_build_parallel(), memory exhausted.\n");
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++)
+        start[tst_par_bucket (s[i]) + 1]++;
+    for (size_t b = 0; b < NBUCKET; b++)    /* counts to bucket starts */
+        start[b + 1] += start[b];
+    for (size_t i = 0; i < n; i++)
+        p->w[start[tst_par_bucket (s[i])]++] = s[i];
+
+    for (size_t b = 0, lo = 0; b < NBUCKET; lo = start[b++])
+        if (start[b] - lo > 1 && tst_par_add (p, lo, start[b], 0, NULL)) {
+            free (start);
+            return -1;
+        }
+    free (start);
+
+    p->sort = 1;
+    tst_par_run (p, nthreads);
+    p->sort = 0;
+    p->ntask = 0;
+
+    return 0;
+}
+
+/** tst_build_parallel() bulk load 'n' words in 's' into empty tree at
+ *  'root' on 'nthreads' threads (1 - 64). words are distributed to buckets
+ *  by their first two chars and the buckets sorted in parallel (unless 's'
+ *  is in tree order), then the top of the tree is laid out by median, the
+ *  same as tst_build_sorted(), down to ranges of about n / (8 * nthreads)
+ *  words, each built as an independent subtree by a worker. the tree is
+ *  identical to the one tst_build_sorted() builds (node for node, refcnt
+ *  included). 'cpy' as for tst_ins_del(). if 'root' holds a tree,
+ *  tst_build_sorted() adds the words. returns root of tree on success,
+ *  NULL on allocation failure or invalid word.
+ */
+void *tst_build_parallel (node_tst **root, char * const *s, const size_t n,
+                            const int cpy, const int nthreads)
+{
+    tst_par p = { .cpy = cpy };
+    int sorted = 1;
+
+    if (!root || (!s && n))
+        return NULL;
+    if (nthreads < 1 || nthreads > PARMAX) {
+        fprintf (stderr, "error: tst_build_parallel(), threads 1 - %d.\n",
+                PARMAX);
+        return NULL;
+    }
+    if (*root)                              /* add to existing tree */
+        return tst_build_sorted (root, s, n, cpy);
+
+    for (size_t i = 0; i < n; i++) {        /* validate and check order */
+        if (!s[i])
+            return NULL;
+        if (strlen (s[i]) > TST_KEYMAX) {
+            fprintf (stderr, "error: tst_build_parallel(), key exceeds TST_KEYMAX.\n");
+            return NULL;
+        }
+        if (i && sorted && tst_strcmp (s[i - 1], s[i]) > 0)
+            sorted = 0;
+    }
+
+    p.grain = n / (8 * (size_t)nthreads);
+    if (p.grain < 64)
+        p.grain = 64;
+    atomic_init (&p.next, 0);
+    atomic_init (&p.err, 0);
+
+    if (sorted)
+        p.w = (char **)s;
+    else if (!(p.w = malloc (n * sizeof *p.w))) {
+        fprintf (stderr, "error: tst_build_parallel(), memory exhausted.\n");
+        return NULL;
+    }
+    else if (tst_par_sort (&p, s, n, nthreads))
+        atomic_store (&p.err, 1);
+
+    if (!atomic_load (&p.err)) {
+        if (tst_par_plan (&p, root, 0, n, 0))
+            atomic_store (&p.err, 1);
+        else
+            tst_par_run (&p, nthreads);
+    }
+
+    if (atomic_load (&p.err)) {
+        if (cpy)
+            tst_free_all (*root);
+        else
+            tst_free (*root);
+        *root = NULL;
+    }
+
+    if (!sorted)
+        free (p.w);
+    free (p.task);
+
+    return *root;
+}
+
+/** rotate sibling tree hanging from pseudo-root 'pr' (pr->hikid) into a
+ *  vine of hikid links (Day-Stout-Warren). returns number of nodes.
+ */
+static size_t tst_tree_to_vine (node_tst *pr)
+{
+    node_tst *tail = pr, *rest = pr->hikid;
+    size_t size = 0;
+
+    while (rest) {
+        if (!rest->lokid) {                 /* advance along vine */
+            tail = rest;
+            rest = rest->hikid;
+            size++;
+        }
+        else {                              /* rotate lokid up */
+            node_tst *tmp = rest->lokid;
+            rest->lokid = tmp->hikid;
+            tmp->hikid = rest;
+            rest = tmp;
+            tail->hikid = tmp;
+        }
+    }
+
+    return size;
+}
+
+/** left-rotate 'count' alternate nodes along the vine from 'pr'. */
+static void tst_vine_compress (node_tst *pr, size_t count)
+{
+    node_tst *scanner = pr;
+
+    for (size_t i = 0; i < count; i++) {
+        node_tst *child = scanner->hikid;
+        scanner->hikid = child->hikid;
+        scanner = scanner->hikid;
+        child->hikid = scanner->lokid;
+        scanner->lokid = child;
+    }
+}
+
+/** rotate vine of 'size' nodes from 'pr' into a balanced sibling tree. */
+static void tst_vine_to_tree (node_tst *pr, size_t size)
+{
+    size_t full = 1;
+
+    while (full <= size + 1)                /* largest 2^k - 1 <= size */
+        full *= 2;
+    full = full / 2 - 1;
+
+    tst_vine_compress (pr, size - full);    /* leaves of bottom level */
+    for (size = full; size > 1; size /= 2)
+        tst_vine_compress (pr, size / 2);
+}
+
+static void tst_rebalance_eq (node_tst *p);
+
+/** balance sibling tree at 'link' in place, then the eqkid tree of each
+ *  sibling. nodes are only relinked, key, refcnt and strings unchanged.
+ *  a wide level is a sorted array, only the trees below it are balanced,
+ *  and a bucket holds no tree.
+ */
+static void tst_rebalance_link (node_tst **link)
+{
+    node_tst pr = { .key = 0, .refcnt = 0, .lokid = NULL, .eqkid = NULL,
+                    .hikid = *link };       /* pseudo-root for rotations */
+
+    if ((*link)->flags & TST_WIDE) {
+        tst_wnode *w = (tst_wnode *)*link;
+        for (unsigned i = 0; i < w->n; i++)
+            if (w->ent[i].key && w->ent[i].eqkid)
+                tst_rebalance_link (&w->ent[i].eqkid);
+        return;
+    }
+    if ((*link)->flags & TST_BUCKET)
+        return;
+    tst_vine_to_tree (&pr, tst_tree_to_vine (&pr));
+    *link = pr.hikid;
+
+    tst_rebalance_eq (*link);
+}
+
+/** rebalance the eqkid tree of each node in sibling tree at 'p'. */
+static void tst_rebalance_eq (node_tst *p)
+{
+    if (!p)
+        return;
+    tst_rebalance_eq (p->lokid);
+    if (!TST_WORD (p) && p->eqkid)
+        tst_rebalance_link (&p->eqkid);
+    tst_rebalance_eq (p->hikid);
+}
+
+/** tst_rebalance() rebalance each lo/hi sibling tree of the tree at 'root'
+ *  in place (Day-Stout-Warren), restoring logarithmic sibling search after
+ *  insert/delete churn without a rebuild. no memory is allocated, nodes are
+ *  only relinked so refcnt and stored string pointers are unchanged. the
+ *  levels of a wide tree and the buckets of a burst tree are kept, the
+ *  lo/hi levels above and below them balanced.
+ *  returns the (new) root.
+ */
+node_tst *tst_rebalance (node_tst **root)
+{
+    if (!root || !*root)
+        return NULL;
+
+    tst_rebalance_link (root);
+
+    return *root;
+}
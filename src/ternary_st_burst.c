@@ -0,0 +1,693 @@
+#include <limits.h>
+
+#include "ternary_st_priv.h"
+
+/** burst tree. the words below a prefix are held in one TST_BUCKET node
+ *  while there are at most 'max' of them, a sorted run of suffixes scanned
+ *  linearly in place of a node per char. a bucket growing past 'max' words
+ *  bursts into a sibling level of nodes, one per first char of the
+ *  suffixes, each with a bucket for the rest, and a subtree left with at
+ *  most 'max / 2' words by a delete is gathered back into one bucket.
+ */
+
+/** delete path, one step per lo/hi level passed. */
+typedef struct tst_bstep {
+    node_tst **top,         /* slot holding the level */
+             **slot;        /* slot holding the node matched in the level */
+} tst_bstep;
+
+/** compare suffixes 'a' and 'b' in tree order (char difference). */
+static int tst_burst_cmp (const char *a, const char *b)
+{
+    while (*a && *a == *b)
+        a++, b++;
+
+    return *a - *b;
+}
+
+/** allocate bucket for 'max' words and 'size' bytes of suffixes.
+ *  returns pointer to bucket, NULL on failure.
+ */
+static tst_bucket *tst_bucket_alloc (const unsigned max, const size_t size)
+{
+    tst_bucket *b = calloc (1, sizeof *b);
+
+    if (!b || !(b->ent = malloc ((max ? max : 1) * sizeof *b->ent)) ||
+            !(b->sfx = malloc (size ? size : 1))) {
+        fprintf (stderr, "error: tst_bucket_alloc(), memory exhausted.\n");
+        if (b)
+            free (b->ent);
+        free (b);
+        return NULL;
+    }
+    b->hdr.key = CHAR_MAX;
+    b->hdr.flags = TST_BUCKET;
+    b->max = max ? max : 1;
+    b->size = size ? size : 1;
+
+    return b;
+}
+
+/** free bucket 'b' (not the words). */
+static void tst_bucket_free (tst_bucket *b)
+{
+    free (b->ent);
+    free (b->sfx);
+    free (b);
+}
+
+/** index in bucket 'b' of the first suffix not less than 's', its offset
+ *  in 'off' and the result of the compare in 'cmp' (1 if none).
+ */
+static unsigned tst_bucket_find (const tst_bucket *b, const char *s,
+                                size_t *off, int *cmp)
+{
+    const char *p = b->sfx;
+    unsigned i;
+
+    *cmp = 1;
+    for (i = 0; i < b->n; i++) {
+        const char *q = s, *start = p;
+        while (*p && *p == *q)
+            p++, q++;
+        if (*p - *q >= 0) {
+            *cmp = *p - *q;
+            p = start;
+            break;
+        }
+        p += strlen (p) + 1;
+    }
+    *off = p - b->sfx;
+
+    return i;
+}
+
+/** add word 'str' with suffix 'sfx' to bucket 'b' at index 'i', offset
+ *  'off'. returns 0 on success, -1 on failure (bucket unchanged).
+ */
+static int tst_bucket_add (tst_bucket *b, const unsigned i, const size_t off,
+                            const char *sfx, char *str)
+{
+    size_t len = strlen (sfx) + 1;
+
+    if (b->n == b->max) {
+        node_tst *ent = realloc (b->ent, 2 * b->max * sizeof *ent);
+        if (!ent)
+            goto nomem;
+        b->ent = ent;
+        b->max *= 2;
+    }
+    if (b->len + len > b->size) {
+        size_t size = 2 * b->size > b->len + len ? 2 * b->size : b->len + len;
+        char *tmp = realloc (b->sfx, size);
+        if (!tmp)
+            goto nomem;
+        b->sfx = tmp;
+        b->size = size;
+    }
+    memmove (b->sfx + off + len, b->sfx + off, b->len - off);
+    memcpy (b->sfx + off, sfx, len);
+    b->len += len;
+    memmove (b->ent + i + 1, b->ent + i, (b->n - i) * sizeof *b->ent);
+    memset (&b->ent[i], 0, sizeof b->ent[i]);
+    b->ent[i].refcnt = 1;
+    b->ent[i].eqkid = (node_tst *)str;
+    b->n++;
+
+    return 0;
+
+nomem:
+    fprintf (stderr, "error: tst_burst_ins_del(), memory exhausted.\n");
+    return -1;
+}
+
+/** remove word at index 'i', offset 'off' from bucket 'b'. */
+static void tst_bucket_del (tst_bucket *b, const unsigned i, const size_t off)
+{
+    size_t len = strlen (b->sfx + off) + 1;
+
+    memmove (b->sfx + off, b->sfx + off + len, b->len - off - len);
+    b->len -= len;
+    b->n--;
+    memmove (b->ent + i, b->ent + i + 1, (b->n - i) * sizeof *b->ent);
+}
+
+/** new bucket holding word 'str' with suffix 'sfx'. */
+static tst_bucket *tst_bucket_new (const char *sfx, char *str)
+{
+    tst_bucket *b = tst_bucket_alloc (1, strlen (sfx) + 1);
+
+    if (b && tst_bucket_add (b, 0, 0, sfx, str)) {
+        tst_bucket_free (b);
+        return NULL;
+    }
+
+    return b;
+}
+
+/** balanced lo/hi tree of 'nodes' [lo, hi). */
+static node_tst *tst_burst_bst (node_tst **nodes, const unsigned lo,
+                                const unsigned hi)
+{
+    unsigned mid = lo + (hi - lo) / 2;
+    node_tst *p;
+
+    if (lo == hi)
+        return NULL;
+    p = nodes[mid];
+    p->lokid = tst_burst_bst (nodes, lo, mid);
+    p->hikid = tst_burst_bst (nodes, mid + 1, hi);
+
+    return p;
+}
+
+/** scratch of one burst, the nodes of the new level and the index and
+ *  suffix offset of the first word of each first char group.
+ */
+typedef struct tst_bgroups {
+    node_tst *nodes[UCHAR_MAX + 1];
+    unsigned first[UCHAR_MAX + 2];
+    size_t soff[UCHAR_MAX + 2];
+} tst_bgroups;
+
+/** burst bucket at '*top' into a balanced level of nodes, one per first
+ *  char of the suffixes, each with a bucket for the words sharing the char
+ *  (or the word itself for the empty suffix), the nodes left in 'bg'.
+ *  returns number of nodes on success, -1 on failure (bucket left as is).
+ */
+static int tst_burst_level (node_tst **top, tst_bgroups *bg)
+{
+    tst_bucket *b = (tst_bucket *)*top;
+    node_tst **nodes = bg->nodes;
+    unsigned *first = bg->first, g = 0, j;
+    size_t *soff = bg->soff;
+    const char *p = b->sfx;
+
+    for (unsigned i = 0; i < b->n; p += strlen (p) + 1, i++)
+        if (!i || *p != b->sfx[soff[g - 1]]) {  /* group of first char */
+            first[g] = i;
+            soff[g++] = p - b->sfx;
+        }
+    first[g] = b->n;
+    soff[g] = b->len;
+
+    for (j = 0; j < g; j++) {
+        const char *q = b->sfx + soff[j];
+        unsigned cnt = first[j + 1] - first[j];
+        tst_bucket *sub;
+
+        if (!(nodes[j] = tst_node_alloc (NULL)))
+            goto nomem;
+        nodes[j]->key = *q;
+        if (!*q) {                          /* word ends here, word node */
+            *nodes[j] = b->ent[first[j]];
+            continue;
+        }
+        if (!(sub = tst_bucket_alloc (cnt, soff[j + 1] - soff[j] - cnt)))
+            goto nomem;
+        for (unsigned i = first[j]; i < first[j + 1]; i++) {
+            size_t len = strlen (q + 1) + 1;
+            memcpy (sub->sfx + sub->len, q + 1, len);
+            sub->len += len;
+            sub->ent[sub->n++] = b->ent[i];
+            q += len + 1;
+        }
+        nodes[j]->refcnt = 1;
+        nodes[j]->eqkid = &sub->hdr;
+    }
+
+    *top = tst_burst_bst (nodes, 0, g);
+    tst_bucket_free (b);
+
+    return (int)g;
+
+nomem:
+    fprintf (stderr, "error: tst_burst(), memory exhausted.\n");
+    for (unsigned k = 0; k <= j; k++)      /* nodes[j] may be NULL */
+        if (nodes[k]) {
+            if (nodes[k]->key && nodes[k]->eqkid)
+                tst_bucket_free ((tst_bucket *)nodes[k]->eqkid);
+            tst_node_free (NULL, nodes[k]);
+        }
+    return -1;
+}
+
+/** burst bucket at '*top' (see tst_burst_level()), then each bucket of
+ *  the new levels still holding more than 'max' words, the buckets left
+ *  to burst held on a worklist so a run of shared chars costs no stack.
+ *  returns 0 on success, -1 on failure (bucket left as is).
+ */
+static int tst_burst (node_tst **top, const int max)
+{
+    tst_bgroups *bg = malloc (sizeof *bg);
+    node_tst **slot = top;
+    tst_stack work;
+    int ret = 0;
+
+    if (!bg) {
+        fprintf (stderr, "error: tst_burst(), memory exhausted.\n");
+        return -1;
+    }
+    tst_stack_init (&work);
+    do {
+        int g = tst_burst_level (slot, bg);
+        if (g < 0 && slot == top)
+            ret = -1;
+        for (int j = 0; j < g; j++) {   /* oversize, left as is on failure */
+            node_tst *p = bg->nodes[j];
+            if (p->key && (int)((tst_bucket *)p->eqkid)->n > max)
+                tst_stack_push (&work, &p->eqkid);
+        }
+    } while ((slot = tst_stack_pop (&work)));
+    tst_stack_free (&work);
+    free (bg);
+
+    return ret;
+}
+
+/** number of words in subtree at 'p', counting stopped past 'lim'. */
+static size_t tst_burst_count (const node_tst *p, const size_t lim)
+{
+    size_t n = 0;
+
+    if (p && (p->flags & TST_BUCKET))
+        return ((const tst_bucket *)p)->n;
+
+    for (; p && n <= lim; p = p->hikid) {
+        n += tst_burst_count (p->lokid, lim - n);
+        if (n > lim)
+            break;
+        n += p->key ? tst_burst_count (p->eqkid, lim - n) : 1;
+    }
+
+    return n;
+}
+
+/** bytes of the suffixes past depth 'd' of the words in subtree at 'p'. */
+static size_t tst_burst_bytes (const node_tst *p, const size_t d)
+{
+    size_t n = 0;
+
+    if (p && (p->flags & TST_BUCKET)) {
+        const tst_bucket *b = (const tst_bucket *)p;
+        for (unsigned i = 0; i < b->n; i++)
+            n += strlen ((char *)b->ent[i].eqkid + d) + 1;
+        return n;
+    }
+    for (; p; p = p->hikid) {
+        n += tst_burst_bytes (p->lokid, d);
+        n += p->key ? tst_burst_bytes (p->eqkid, d) :
+                        strlen ((char *)p->eqkid + d) + 1;
+    }
+
+    return n;
+}
+
+/** append word node 'w' with suffix past depth 'd' to bucket 'b' (room
+ *  allocated).
+ */
+static void tst_burst_put (tst_bucket *b, const node_tst *w, const size_t d)
+{
+    const char *sfx = (char *)w->eqkid + d;
+    size_t len = strlen (sfx) + 1;
+
+    memcpy (b->sfx + b->len, sfx, len);
+    b->len += len;
+    b->ent[b->n] = *w;
+    b->ent[b->n].lokid = b->ent[b->n].hikid = NULL;
+    b->n++;
+}
+
+/** move the words of subtree at 'p' to bucket 'b' in order, freeing the
+ *  nodes and buckets of the subtree.
+ */
+static void tst_burst_gather (node_tst *p, tst_bucket *b, const size_t d)
+{
+    if (p && (p->flags & TST_BUCKET)) {
+        tst_bucket *sub = (tst_bucket *)p;
+        for (unsigned i = 0; i < sub->n; i++)
+            tst_burst_put (b, &sub->ent[i], d);
+        tst_bucket_free (sub);
+        return;
+    }
+    while (p) {
+        node_tst *next = p->hikid;
+        tst_burst_gather (p->lokid, b, d);
+        if (p->key)
+            tst_burst_gather (p->eqkid, b, d);
+        else
+            tst_burst_put (b, p, d);
+        tst_node_free (NULL, p);
+        p = next;
+    }
+}
+
+/** gather subtree at '*top' at depth 'd' holding 'n' words into one
+ *  bucket. returns 0 on success, -1 on failure (subtree unchanged).
+ */
+static int tst_burst_collapse (node_tst **top, const size_t d, const size_t n)
+{
+    tst_bucket *b = tst_bucket_alloc (n, tst_burst_bytes (*top, d));
+
+    if (!b)
+        return -1;
+    tst_burst_gather (*top, b, d);
+    *top = &b->hdr;
+
+    return 0;
+}
+
+/** unlink node at '*slot' from its lo/hi tree and free it, replaced by its
+ *  child, or with two children by its successor.
+ */
+static void tst_burst_unlink (node_tst **slot)
+{
+    node_tst *x = *slot, *succ, **link;
+
+    if (!x->lokid || !x->hikid)
+        *slot = x->lokid ? x->lokid : x->hikid;
+    else {
+        for (link = &x->hikid; (*link)->lokid; link = &(*link)->lokid) {}
+        succ = *link;
+        *link = succ->hikid;
+        succ->lokid = x->lokid;
+        succ->hikid = x->hikid;
+        *slot = succ;
+    }
+    tst_node_free (NULL, x);
+}
+
+/** remove the node of step 'k - 1' on 'path', left with nothing below its
+ *  eqkid, then each node above it left the same way. returns number of
+ *  levels on the path that remain.
+ */
+static size_t tst_burst_prune (tst_bstep *path, size_t k)
+{
+    while (k--) {
+        tst_burst_unlink (path[k].slot);
+        if (*path[k].top)
+            return k + 1;
+    }
+
+    return 0;
+}
+
+/** gather the highest subtree of the 'k' levels on 'path' (level 'j' at
+ *  depth 'j') holding at most 'max / 2' words into one bucket. words only
+ *  increase toward the root, so the search stops at the first level above.
+ */
+static void tst_burst_shrink (tst_bstep *path, const size_t k, const int max)
+{
+    size_t lim = max / 2, best = k, n = 0;
+
+    for (size_t j = k; j--;) {
+        size_t cnt = tst_burst_count (*path[j].top, lim);
+        if (cnt > lim)
+            break;
+        best = j;
+        n = cnt;
+    }
+    if (best < k)
+        tst_burst_collapse (path[best].top, best, n);  /* as is on failure */
+}
+
+/** storage for word 's' of length 'len', a copy for 'cpy'. */
+static char *tst_burst_str (char * const *s, const size_t len, const int cpy)
+{
+    char *str = *s;
+
+    if (cpy) {
+        if (!(str = tst_str_alloc (NULL, len + 1))) {
+            fprintf (stderr, "error: tst_burst_ins_del(), memory exhausted.\n");
+            return NULL;
+        }
+        memcpy (str, *s, len + 1);
+    }
+
+    return str;
+}
+
+/** ins/del of 's' at bucket at '*top', 'p' the suffix of 's' past the
+ *  bucket, 'd' levels on 'path' above it. returns as tst_burst_ins_del().
+ */
+static void *tst_burst_bucket (node_tst **top, const char *p, char * const *s,
+                                const size_t len, const int del, const int cpy,
+                                const int max, tst_bstep *path, const size_t d)
+{
+    tst_bucket *b = (tst_bucket *)*top;
+    size_t off;
+    int cmp;
+    unsigned i = tst_bucket_find (b, p, &off, &cmp);
+    char *str;
+
+    if (cmp == 0) {                         /* word exists */
+        node_tst *w = &b->ent[i];
+        str = (char *)w->eqkid;
+        if (!del) {
+            w->refcnt++;
+            return str;
+        }
+        if (--w->refcnt)                    /* occurrences remain */
+            return str;
+        tst_bucket_del (b, i, off);
+        if (cpy)
+            tst_str_free (NULL, str);
+        if (b->n)
+            tst_burst_shrink (path, d, max);
+        else {
+            tst_bucket_free (b);
+            *top = NULL;
+            tst_burst_shrink (path, tst_burst_prune (path, d), max);
+        }
+        return NULL;
+    }
+    if (del)                                /* not found */
+        return NULL;
+
+    if (!(str = tst_burst_str (s, len, cpy)))
+        return NULL;
+    if (tst_bucket_add (b, i, off, p, str)) {
+        if (cpy)
+            tst_str_free (NULL, str);
+        return NULL;
+    }
+    if ((int)b->n > max)
+        tst_burst (top, max);               /* stays whole on failure */
+
+    return str;
+}
+
+/** tst_burst_ins_del() ins/del copy or reference of 's' from burst tree at
+ *  'root', same semantics as tst_ins_del() (TST_NOKEY is not supported).
+ *  the words below a prefix are held in one bucket, a sorted run of their
+ *  suffixes, while there are at most 'max' of them, a bucket growing past
+ *  'max' words bursts into a level of nodes with a bucket below each, and
+ *  a subtree left with at most 'max / 2' words by a delete is gathered back
+ *  into a bucket ('max' 0 gives a plain tree). the tree must only be modified
+ *  through tst_burst_ins_del(), tst_burst_search() and
+ *  tst_burst_search_prefix() are used for lookup, tst_traverse_fn() (with
+ *  a word node for each word), tst_nodes(), tst_stats(), tst_search_fuzzy(),
+ *  tst_search_pattern(), tst_rebalance(), tst_free() and tst_free_all()
+ *  handle burst trees, the other walks fail with an error. subtree max is
+ *  not maintained.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on allocation failure on insert, or on successful
+ *  removal of 's' from tree.
+ */
+void *tst_burst_ins_del (node_tst **root, char * const *s, const int del,
+                        const int cpy, const int max)
+{
+    node_tst **top = root, **pcurr = root, *curr;
+    tst_bstep *path = NULL;
+    const char *p;
+    size_t len, d = 0;
+    char *str;
+    void *ret;
+
+    if (!root || !*s || cpy == TST_NOKEY || max < 0)
+        return NULL;
+
+    len = strlen (*s);
+    if (len > TST_KEYMAX) {
+        if (!del)
+            fprintf (stderr, "error: tst_burst_ins_del(), key exceeds TST_KEYMAX.\n");
+        return NULL;
+    }
+    if (del && !(path = malloc ((len + 1) * sizeof *path))) {
+        fprintf (stderr, "error: tst_burst_ins_del(), memory exhausted.\n");
+        return NULL;
+    }
+
+    p = *s;
+    while ((curr = *pcurr)) {
+        int diff;
+        if (curr->flags & TST_BUCKET) {     /* rest of 's' in bucket */
+            ret = tst_burst_bucket (pcurr, p, s, len, del, cpy, max, path, d);
+            free (path);
+            return ret;
+        }
+        diff = *p - curr->key;
+        if (diff) {
+            pcurr = diff < 0 ? &curr->lokid : &curr->hikid;
+            continue;
+        }
+        if (del)
+            path[d] = (tst_bstep){ .top = top, .slot = pcurr };
+        d++;
+        if (*p++ == 0) {                    /* word node exists */
+            str = (char *)curr->eqkid;
+            if (!del) {
+                curr->refcnt++;
+                return str;
+            }
+            if (!--curr->refcnt) {          /* last occurrence */
+                tst_burst_shrink (path, tst_burst_prune (path, d), max);
+                if (cpy)
+                    tst_str_free (NULL, str);
+                str = NULL;
+            }
+            free (path);
+            return str;
+        }
+        top = pcurr = &curr->eqkid;
+    }
+
+    if (del) {                              /* not found */
+        free (path);
+        return NULL;
+    }
+
+    if (!(str = tst_burst_str (s, len, cpy)))
+        return NULL;
+    if (pcurr == top) {                     /* empty tree, bucket for 's' */
+        tst_bucket *b = tst_bucket_new (p, str);
+        if (!b)
+            goto fail;
+        *pcurr = &b->hdr;
+        if (max < 1)
+            tst_burst (pcurr, max);
+        return str;
+    }
+    if (!(curr = tst_node_alloc (NULL)))    /* new node in lo/hi level */
+        goto fail;
+    curr->key = *p;
+    curr->refcnt = 1;
+    if (*p) {
+        tst_bucket *b = tst_bucket_new (p + 1, str);
+        if (!b) {
+            tst_node_free (NULL, curr);
+            goto fail;
+        }
+        curr->eqkid = &b->hdr;
+        if (max < 1)
+            tst_burst (&curr->eqkid, max);
+    }
+    else
+        curr->eqkid = (node_tst *)str;
+    *pcurr = curr;
+
+    return str;
+
+fail:
+    fprintf (stderr, "error: tst_burst_ins_del(), memory exhausted.\n");
+    if (cpy)
+        tst_str_free (NULL, str);
+    return NULL;
+}
+
+/** tst_burst_search(), non-recursive find of a string in burst tree.
+ *  returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_burst_search (const node_tst *p, const char *s)
+{
+    const node_tst *curr = p;
+
+    while (curr) {
+        int diff;
+        if (curr->flags & TST_BUCKET) {     /* scan bucket for rest of 's' */
+            const tst_bucket *b = (const tst_bucket *)curr;
+            size_t off;
+            int cmp;
+            unsigned i = tst_bucket_find (b, s, &off, &cmp);
+            return cmp ? NULL : (void *)b->ent[i].eqkid;
+        }
+        diff = *s - curr->key;
+        if (diff == 0) {
+            if (*s == 0)
+                return (void *)curr->eqkid;
+            s++;
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+    return NULL;
+}
+
+/** fill 'a' with the words in subtree at 'p' in order. */
+static void tst_burst_suggest (const node_tst *p, char **a, int *n,
+                                const int max)
+{
+    if (p && (p->flags & TST_BUCKET)) {
+        const tst_bucket *b = (const tst_bucket *)p;
+        for (unsigned i = 0; i < b->n && *n < max; i++)
+            a[(*n)++] = (char *)b->ent[i].eqkid;
+        return;
+    }
+    for (; p && *n < max; p = p->hikid) {
+        tst_burst_suggest (p->lokid, a, n, max);
+        if (*n == max)
+            return;
+        if (p->key)
+            tst_burst_suggest (p->eqkid, a, n, max);
+        else
+            a[(*n)++] = (char *)p->eqkid;
+    }
+}
+
+/** tst_burst_search_prefix() fills ptr array 'a' with words prefixed with
+ *  's' in burst tree, as tst_search_prefix(). returns non-NULL on success,
+ *  NULL otherwise.
+ */
+void *tst_burst_search_prefix (const node_tst *root, const char *s,
+                                char **a, int *n, const int max)
+{
+    const node_tst *curr = root;
+    size_t len;
+
+    *n = 0;
+    if (!*s) return NULL;
+
+    while (curr) {
+        int diff;
+        if (curr->flags & TST_BUCKET) {     /* suffixes prefixed with 's' */
+            const tst_bucket *b = (const tst_bucket *)curr;
+            const char *p = b->sfx;
+            len = strlen (s);
+            for (unsigned i = 0; i < b->n && *n < max; i++) {
+                int cmp = strncmp (p, s, len) ? tst_burst_cmp (p, s) : 0;
+                if (cmp > 0)
+                    break;
+                if (!cmp)
+                    a[(*n)++] = (char *)b->ent[i].eqkid;
+                p += strlen (p) + 1;
+            }
+            return *n ? (void *)curr : NULL;
+        }
+        diff = *s - curr->key;
+        if (diff == 0) {
+            if (!*++s) {                    /* words below last prefix char */
+                tst_burst_suggest (curr->eqkid, a, n, max);
+                return *n ? (void *)curr : NULL;
+            }
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+    return NULL;
+}
@@ -0,0 +1,420 @@
+#include "ternary_st_priv.h"
+
+/** string table slot, string pointer or next free slot index. */
+typedef union {
+    char *str;
+    uint32_t next;
+} tst_cstr;
+
+/** compact tree handle, nodes and string pointers held in pools. */
+struct tst_cpt {
+    cnode_tst *pool;        /* node pool, index 0 unused (nil) */
+    uint32_t nnodes,        /* pool entries used (including nil) */
+             maxnodes,      /* pool entries allocated */
+             freelist,      /* deleted nodes, chained through eqkid */
+             root;          /* index of root node */
+    tst_cstr *strs;         /* string table, index 0 unused */
+    uint32_t nstrs,         /* table entries used (including 0) */
+             maxstrs,       /* table entries allocated */
+             strfree;       /* deleted slots, chained through next */
+};
+
+/** tst_cpt_create() allocate empty compact tree. returns pointer to new
+ *  tree, NULL on allocation failure.
+ */
+tst_cpt *tst_cpt_create (void)
+{
+    tst_cpt *t = calloc (1, sizeof *t);
+
+    if (!t) {
+        fprintf (stderr, "error: tst_cpt_create(), memory exhausted.\n");
+        return NULL;
+    }
+    t->nnodes = t->nstrs = 1;       /* index 0 is nil */
+
+    return t;
+}
+
+/** ensure 'n' nodes can be taken from pool of 't' without realloc, so
+ *  node pointers remain valid during insert. returns 0 on success, -1
+ *  on allocation failure.
+ */
+static int tst_cpt_reserve (tst_cpt *t, size_t n)
+{
+    size_t need = (size_t)t->nnodes + n, max = t->maxnodes ? t->maxnodes : 1024;
+    void *tmp;
+
+    if (need <= t->maxnodes)
+        return 0;
+    while (max < need)
+        max *= 2;
+    if (max > UINT32_MAX || !(tmp = realloc (t->pool, max * sizeof *t->pool))) {
+        fprintf (stderr, "error: tst_cpt_reserve(), memory exhausted.\n");
+        return -1;
+    }
+    t->pool = tmp;
+    t->maxnodes = max;
+
+    return 0;
+}
+
+/** take node from free list or pool of 't' (capacity reserved), zeroed.
+ *  returns index of node.
+ */
+static uint32_t tst_cpt_node (tst_cpt *t)
+{
+    uint32_t i = t->freelist;
+
+    if (i)
+        t->freelist = t->pool[i].eqkid;
+    else
+        i = t->nnodes++;
+    memset (t->pool + i, 0, sizeof *t->pool);
+
+    return i;
+}
+
+/** return node 'i' to free list of 't'. */
+static void tst_cpt_node_free (tst_cpt *t, uint32_t i)
+{
+    t->pool[i].eqkid = t->freelist;
+    t->freelist = i;
+}
+
+/** store string pointer 's' in string table of 't'. returns index of
+ *  slot, 0 on allocation failure.
+ */
+static uint32_t tst_cpt_str (tst_cpt *t, char *s)
+{
+    uint32_t i = t->strfree;
+
+    if (i)
+        t->strfree = t->strs[i].next;
+    else {
+        if (t->nstrs >= t->maxstrs) {
+            size_t max = t->maxstrs ? (size_t)t->maxstrs * 2 : 1024;
+            void *tmp;
+            if (max > UINT32_MAX ||
+                    !(tmp = realloc (t->strs, max * sizeof *t->strs))) {
+                fprintf (stderr, "error: tst_cpt_str(), memory exhausted.\n");
+                return 0;
+            }
+            t->strs = tmp;
+            t->maxstrs = max;
+        }
+        i = t->nstrs++;
+    }
+    t->strs[i].str = s;
+
+    return i;
+}
+
+/** return string table slot 'i' to free list of 't'. */
+static void tst_cpt_str_free (tst_cpt *t, uint32_t i)
+{
+    t->strs[i].next = t->strfree;
+    t->strfree = i;
+}
+
+/** replace 'victim' with 'repl' in the link of 'parent' holding victim,
+ *  or as root if 'parent' is 0.
+ */
+static void tst_cpt_relink (tst_cpt *t, uint32_t parent, uint32_t victim,
+                            uint32_t repl)
+{
+    cnode_tst *p = t->pool + parent;
+
+    if (!parent)
+        t->root = repl;
+    else if (victim == p->lokid)
+        p->lokid = repl;
+    else if (victim == p->hikid)
+        p->hikid = repl;
+    else
+        p->eqkid = repl;
+}
+
+/** remove 'victim' from the lo/hi tree of its siblings, same rotations as
+ *  tst_del_node() for pointer nodes.
+ */
+static void tst_cpt_del_node (tst_cpt *t, uint32_t parent, uint32_t victim)
+{
+    cnode_tst *pool = t->pool, *v = pool + victim;
+    uint32_t repl;
+
+    if (v->lokid && v->hikid) {
+        if (!pool[v->lokid].hikid) {
+            pool[v->lokid].hikid = v->hikid;
+            repl = v->lokid;
+        }
+        else if (!pool[v->hikid].lokid) {
+            pool[v->hikid].lokid = v->lokid;
+            repl = v->hikid;
+        }
+        else {                              /* in-order predecessor */
+            uint32_t pp = v->lokid;
+            repl = pool[pp].hikid;
+            while (pool[repl].hikid) {
+                pp = repl;
+                repl = pool[repl].hikid;
+            }
+            pool[pp].hikid = pool[repl].lokid;
+            pool[repl].lokid = v->lokid;
+            pool[repl].hikid = v->hikid;
+        }
+    }
+    else
+        repl = v->lokid ? v->lokid : v->hikid;
+
+    tst_cpt_relink (t, parent, victim, repl);
+    tst_cpt_node_free (t, victim);
+}
+
+/** pop node index from delete path 'stk', 0 (nil) once empty. */
+static uint32_t tst_cpt_pop (tst_stack *stk)
+{
+    return (uint32_t)(uintptr_t)tst_stack_pop (stk);
+}
+
+/** delete word at terminal node 'node' with path to node in 'stk' (indexes
+ *  of nodes from root, top of stack parent of node), as tst_del_word().
+ */
+static void tst_cpt_del_word (tst_cpt *t, uint32_t node, tst_stack *stk,
+                                const int freedata)
+{
+    cnode_tst *pool = t->pool;
+    uint32_t victim = node,
+             parent = tst_cpt_pop (stk);
+
+    if (freedata)
+        free (t->strs[pool[victim].eqkid].str);
+    tst_cpt_str_free (t, pool[victim].eqkid);
+
+    /* remove unique suffix chain */
+    while (parent && !pool[parent].lokid && !pool[parent].hikid &&
+           !pool[victim].lokid && !pool[victim].hikid) {
+        pool[parent].eqkid = 0;
+        tst_cpt_node_free (t, victim);
+        victim = parent;
+        parent = tst_cpt_pop (stk);
+    }
+
+    /* victim was eqkid of parent with other children, parent becomes victim */
+    if (parent && victim == pool[parent].eqkid &&
+            !pool[victim].lokid && !pool[victim].hikid) {
+        pool[parent].eqkid = 0;
+        tst_cpt_node_free (t, victim);
+        victim = parent;
+        parent = tst_cpt_pop (stk);
+    }
+
+    tst_cpt_del_node (t, parent, victim);
+}
+
+static void *tst_cpt_ins_del_stk (tst_cpt *t, char * const *s, const int del,
+                                    const int cpy, tst_stack *stk);
+
+/** tst_cpt_ins_del() ins/del copy or reference of 's' from compact tree 't'.
+ *  same semantics as tst_ins_del(). the refcnt of a word saturates at
+ *  2^24 - 1, a further insert returns the word uncounted. returns address
+ *  of 's' in tree on successful insert (or on delete if refcnt non-zero),
+ *  NULL on allocation failure on insert, or on successful removal of 's'
+ *  from tree.
+ */
+void *tst_cpt_ins_del (tst_cpt *t, char * const *s, const int del, const int cpy)
+{
+    tst_stack stk;
+    void *ret;
+
+    if (!t || !*s) return NULL;             /* validate parameters */
+
+    tst_stack_init (&stk);
+    ret = tst_cpt_ins_del_stk (t, s, del, cpy, &stk);
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_cpt_ins_del() with delete path held on 'stk', any depth of path. */
+static void *tst_cpt_ins_del_stk (tst_cpt *t, char * const *s, const int del,
+                                    const int cpy, tst_stack *stk)
+{
+    uint32_t *plink, curr;
+    size_t len;
+    const char *p;
+
+    /* keeps the 127 char WRDMAX limit (see TST_KEYMAX) */
+    if ((len = strlen (*s)) + 1 > STKMAX / 2)
+        return NULL;
+    if (!del && tst_cpt_reserve (t, len + 1))   /* nodes for whole word */
+        return NULL;
+
+    p = *s;
+    plink = &t->root;
+    while ((curr = *plink)) {               /* iterate to insertion node */
+        cnode_tst *node = t->pool + curr;
+        int diff = *p - CKEY(node);
+        if (diff == 0) {
+            if (*p++ == 0) {                /* word exists */
+                char *str = t->strs[node->eqkid].str;
+                if (del) {
+                    if (--node->refcnt)     /* occurrences remain */
+                        return str;
+                    tst_cpt_del_word (t, curr, stk, cpy);
+                    return NULL;
+                }
+                if (node->refcnt < CREFMAX)     /* saturate at limit */
+                    node->refcnt++;
+                return str;
+            }
+            plink = &node->eqkid;
+        }
+        else if (diff < 0)
+            plink = &node->lokid;
+        else
+            plink = &node->hikid;
+        if (del && !tst_stack_push (stk, (void *)(uintptr_t)curr))
+            return NULL;                    /* path for delete */
+    }
+
+    if (del)                                /* not found */
+        return NULL;
+
+    for (;;) {      /* insert remaining chars, pool reserved above */
+        cnode_tst *node;
+        curr = tst_cpt_node (t);
+        *plink = curr;
+        node = t->pool + curr;
+        node->key = (unsigned char)*p;
+        node->refcnt = 1;
+
+        if (*p++ == 0) {
+            char *str = *s;
+            if (cpy) {  /* allocate storage for 's' */
+                if (!(str = malloc (len + 1)))
+                    return NULL;
+                memcpy (str, *s, len + 1);
+            }
+            if (!(node->eqkid = tst_cpt_str (t, str))) {
+                if (cpy)
+                    free (str);
+                return NULL;
+            }
+            return str;
+        }
+        plink = &node->eqkid;
+    }
+}
+
+/** tst_cpt_search(), non-recursive find of a string in compact tree.
+ *  returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_cpt_search (const tst_cpt *t, const char *s)
+{
+    const cnode_tst *pool = t->pool;
+    uint32_t curr = t->root;
+
+    while (curr) {
+        const cnode_tst *node = pool + curr;
+        int diff = *s - CKEY(node);
+        if (diff == 0) {
+            if (*s == 0)
+                return t->strs[node->eqkid].str;
+            s++;
+            curr = node->eqkid;
+        }
+        else if (diff < 0)
+            curr = node->lokid;
+        else
+            curr = node->hikid;
+    }
+    return NULL;
+}
+
+/** fill ptr array 'a' with strings matching prefix at node 'curr', as
+ *  tst_suggest().
+ */
+static void tst_cpt_suggest (const tst_cpt *t, uint32_t curr, const char c,
+                            const size_t nchr, char **a, int *n, const int max)
+{
+    const cnode_tst *node;
+
+    if (!curr || *n == max)
+        return;
+    node = t->pool + curr;
+    tst_cpt_suggest (t, node->lokid, c, nchr, a, n, max);
+    if (node->key)
+        tst_cpt_suggest (t, node->eqkid, c, nchr, a, n, max);
+    else {
+        char *str = t->strs[node->eqkid].str;
+        if (str[nchr - 1] == c && *n < max)
+            a[(*n)++] = str;
+    }
+    tst_cpt_suggest (t, node->hikid, c, nchr, a, n, max);
+}
+
+/** tst_cpt_search_prefix() fills ptr array 'a' with words prefixed with 's',
+ *  as tst_search_prefix(). returns non-NULL on success, NULL otherwise.
+ */
+void *tst_cpt_search_prefix (const tst_cpt *t, const char *s,
+                            char **a, int *n, const int max)
+{
+    const char *start = s;
+    uint32_t curr = t->root;
+    size_t nchr;
+
+    if (!*s) return NULL;
+
+    nchr = strlen (s);
+    *n = 0;
+
+    while (curr) {
+        const cnode_tst *node = t->pool + curr;
+        int diff = *s - CKEY(node);
+        if (diff == 0) {
+            if ((size_t)(s - start) == nchr - 1) {
+                tst_cpt_suggest (t, curr, CKEY(node), nchr, a, n, max);
+                return (void *)node;
+            }
+            s++;
+            curr = node->eqkid;
+        }
+        else if (diff < 0)
+            curr = node->lokid;
+        else
+            curr = node->hikid;
+    }
+    return NULL;
+}
+
+/** tst_cpt_size() returns bytes allocated for node pool and string table
+ *  of compact tree 't' (storage of copied words not included).
+ */
+size_t tst_cpt_size (const tst_cpt *t)
+{
+    return sizeof *t + (size_t)t->maxnodes * sizeof *t->pool +
+            (size_t)t->maxstrs * sizeof *t->strs;
+}
+
+/** tst_cpt_free() free compact tree 't', if 'freedata' is non-zero the
+ *  copies of words stored in the tree are freed as well.
+ */
+void tst_cpt_free (tst_cpt *t, const int freedata)
+{
+    if (!t)
+        return;
+
+    if (freedata) {     /* free words in slots not on the free list */
+        uint32_t i = t->strfree;
+        while (i) {
+            uint32_t next = t->strs[i].next;
+            t->strs[i].str = NULL;
+            i = next;
+        }
+        for (i = 1; i < t->nstrs; i++)
+            free (t->strs[i].str);
+    }
+    free (t->strs);
+    free (t->pool);
+    free (t);
+}
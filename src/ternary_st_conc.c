@@ -0,0 +1,452 @@
+#include <stdatomic.h>
+#include <threads.h>
+
+#include "ternary_st_priv.h"
+
+/** max reader threads registered with a concurrent tree */
+#define CONCRDR 64
+/** initial retire list size (entries), doubled as required */
+#define RETIRESZ 256
+
+/** child pointer 'p' read by a reader (acquire) and published by the writer
+ *  (release), a node is fully initialized before the store that links it.
+ */
+#define TST_LOAD(p) \
+    atomic_load_explicit ((_Atomic (node_tst *) *)&(p), memory_order_acquire)
+#define TST_STORE(p, v) \
+    atomic_store_explicit ((_Atomic (node_tst *) *)&(p), (v), \
+                            memory_order_release)
+
+/** reader slot, epoch the reader entered its read section in (0 outside),
+ *  padded to a cache line so readers do not share lines.
+ */
+typedef struct tst_rdslot {
+    atomic_ullong epoch;
+    atomic_int used;        /* slot registered to a reader */
+    char pad[64 - sizeof (atomic_ullong) - sizeof (atomic_int)];
+} tst_rdslot;
+
+/** node or copied string unlinked by the writer in epoch 'epoch'. */
+typedef struct tst_retired {
+    void *ptr;
+    unsigned long long epoch;
+    int str;                /* ptr is string, otherwise node */
+} tst_retired;
+
+/** concurrent tree handle. readers never block, the writer publishes each
+ *  change with one release store and frees what it unlinks once every
+ *  reader in a read section has been seen in the current epoch twice.
+ */
+struct tst_conc {
+    node_tst *root;         /* root, loaded and stored atomically */
+    mtx_t lock;             /* serializes writers */
+    atomic_ullong epoch;    /* global epoch, advanced by the writer */
+    tst_retired *retired;   /* unlinked nodes and strings not yet freed */
+    size_t nretired,
+           maxretired;
+    int cpy;                /* words copied (and freed on delete) */
+    tst_rdslot rd[CONCRDR];
+};
+
+/** tst_conc_create() allocate concurrent tree handle, words inserted by
+ *  copy if 'cpy' is non-zero, otherwise by reference. returns pointer to
+ *  new handle, NULL on failure.
+ */
+tst_conc *tst_conc_create (const int cpy)
+{
+    tst_conc *c = calloc (1, sizeof *c);
+
+    if (!c) {
+        fprintf (stderr, "error: tst_conc_create(), memory exhausted.\n");
+        return NULL;
+    }
+    if (mtx_init (&c->lock, mtx_plain) != thrd_success) {
+        fprintf (stderr, "error: tst_conc_create(), mtx_init failed.\n");
+        free (c);
+        return NULL;
+    }
+    atomic_init (&c->epoch, 1);
+    for (int i = 0; i < CONCRDR; i++) {
+        atomic_init (&c->rd[i].epoch, 0);
+        atomic_init (&c->rd[i].used, 0);
+    }
+    c->cpy = cpy;
+
+    return c;
+}
+
+/** tst_conc_register() register calling reader thread with 'c'.
+ *  returns reader id for tst_conc_read_begin/end(), -1 if CONCRDR (64)
+ *  readers are registered.
+ */
+int tst_conc_register (tst_conc *c)
+{
+    for (int i = 0; i < CONCRDR; i++) {
+        int unused = 0;
+        if (atomic_compare_exchange_strong (&c->rd[i].used, &unused, 1))
+            return i;
+    }
+    fprintf (stderr, "error: tst_conc_register(), %d readers registered.\n",
+            CONCRDR);
+
+    return -1;
+}
+
+/** tst_conc_unregister() release reader 'id' (outside a read section). */
+void tst_conc_unregister (tst_conc *c, const int id)
+{
+    atomic_store (&c->rd[id].epoch, 0);
+    atomic_store (&c->rd[id].used, 0);
+}
+
+/** tst_conc_read_begin() enter read section for reader 'id'. nodes and
+ *  words found by tst_conc_search() and tst_conc_search_prefix() remain
+ *  valid until tst_conc_read_end(). never blocks.
+ */
+void tst_conc_read_begin (tst_conc *c, const int id)
+{
+    atomic_store (&c->rd[id].epoch, atomic_load (&c->epoch));
+    /* slot visible to the writer before any node is read, pairs with the
+     * fence in tst_conc_reclaim() */
+    atomic_thread_fence (memory_order_seq_cst);
+}
+
+/** tst_conc_read_end() leave read section for reader 'id'. */
+void tst_conc_read_end (tst_conc *c, const int id)
+{
+    atomic_store_explicit (&c->rd[id].epoch, 0, memory_order_release);
+}
+
+/** free node or string 'r'. */
+static void tst_conc_free (const tst_retired *r)
+{
+    if (r->str)
+        tst_str_free (NULL, r->ptr);
+    else
+        tst_node_free (NULL, r->ptr);
+}
+
+/** retire node or string 'ptr' unlinked by the writer, freed by
+ *  tst_conc_reclaim() once no reader can hold it.
+ */
+static void tst_conc_retire (tst_conc *c, void *ptr, const int str)
+{
+    if (c->nretired == c->maxretired) {
+        size_t max = c->maxretired ? c->maxretired * 2 : RETIRESZ;
+        void *tmp = realloc (c->retired, max * sizeof *c->retired);
+        if (!tmp) {     /* cannot tell when readers are done, leak ptr */
+            fprintf (stderr, "error: tst_conc_retire(), memory exhausted.\n");
+            return;
+        }
+        c->retired = tmp;
+        c->maxretired = max;
+    }
+    c->retired[c->nretired].ptr = ptr;
+    c->retired[c->nretired].epoch = atomic_load (&c->epoch);
+    c->retired[c->nretired++].str = str;
+}
+
+/** advance the epoch if every reader in a read section entered it in the
+ *  current epoch, then free what was retired two or more epochs ago (no
+ *  reader still in a read section can have seen it linked).
+ */
+static void tst_conc_reclaim (tst_conc *c)
+{
+    unsigned long long e = atomic_load (&c->epoch);
+    size_t keep = 0;
+    int advance = 1;
+
+    /* unlinks visible to readers entering after the scan */
+    atomic_thread_fence (memory_order_seq_cst);
+    for (int i = 0; i < CONCRDR && advance; i++) {
+        unsigned long long r = atomic_load (&c->rd[i].epoch);
+        if (r && r != e)
+            advance = 0;
+    }
+    if (advance)
+        atomic_store (&c->epoch, ++e);
+
+    for (size_t i = 0; i < c->nretired; i++) {
+        if (c->retired[i].epoch + 2 <= e)
+            tst_conc_free (&c->retired[i]);
+        else
+            c->retired[keep++] = c->retired[i];
+    }
+    c->nretired = keep;
+}
+
+/** unlink node at '*slot' (no words below its eqkid) from its sibling tree.
+ *  with one child the child takes its place, with two children its
+ *  successor is copied into its place over copies of the path down to the
+ *  successor, so either way readers see the old or new sibling tree with
+ *  one store. replaced nodes are retired. returns 0 on success, -1 on
+ *  allocation failure (tree unchanged).
+ */
+static int tst_conc_unlink (tst_conc *c, node_tst **slot)
+{
+    node_tst *x = *slot, *path[STKMAX], *cp[STKMAX], *top;
+    size_t k = 0;
+
+    if (!x->lokid || !x->hikid) {
+        TST_STORE (*slot, x->lokid ? x->lokid : x->hikid);
+        tst_conc_retire (c, x, 0);
+        return 0;
+    }
+
+    for (node_tst *p = x->hikid; p; p = p->lokid) {     /* to successor */
+        if (k == STKMAX)
+            return -1;
+        path[k++] = p;
+    }
+    for (size_t i = 0; i < k; i++) {        /* copy path and successor */
+        if (!(cp[i] = tst_node_alloc (NULL))) {
+            fprintf (stderr, "error: tst_conc_unlink(), memory exhausted.\n");
+            while (i--)
+                tst_node_free (NULL, cp[i]);
+            return -1;
+        }
+        *cp[i] = *path[i];
+    }
+
+    top = cp[k - 1];                        /* successor copy replaces x */
+    top->lokid = x->lokid;
+    if (k > 1) {
+        cp[k - 2]->lokid = path[k - 1]->hikid;
+        for (size_t i = 0; i + 2 < k; i++)
+            cp[i]->lokid = cp[i + 1];
+        top->hikid = cp[0];
+    }
+    TST_STORE (*slot, top);
+
+    tst_conc_retire (c, x, 0);
+    for (size_t i = 0; i < k; i++)
+        tst_conc_retire (c, path[i], 0);
+
+    return 0;
+}
+
+/** slot 'i' (0 root) on path 'stk'. */
+static node_tst **tst_conc_at (const tst_stack *stk, size_t i)
+{
+    return stk->data[i];
+}
+
+/** delete word with terminal node at the slot on top of 'stk', 'stk'
+ *  holding the slot of each node on the path from root. the terminal node
+ *  is unlinked, then each node whose eqkid is left empty (a node failing
+ *  to unlink is left with an empty eqkid, which search and insert handle).
+ *  returns 0 on success, -1 if the terminal node could not be unlinked.
+ */
+static int tst_conc_del_word (tst_conc *c, const tst_stack *stk)
+{
+    size_t i = stk->idx - 1;
+    node_tst *term = *tst_conc_at (stk, i);
+
+    if (tst_conc_unlink (c, tst_conc_at (stk, i)))
+        return -1;
+    if (c->cpy)
+        tst_conc_retire (c, term->eqkid, 1);
+
+    for (;;) {
+        size_t j = i;
+        node_tst *parent;
+
+        /* slot j is the eqkid slot of the parent of the sibling tree */
+        while (j && tst_conc_at (stk, j) !=
+                    &(*tst_conc_at (stk, j - 1))->eqkid)
+            j--;
+        if (!j)                             /* sibling tree at root */
+            return 0;
+        parent = *tst_conc_at (stk, j - 1);
+        if (parent->eqkid)                  /* words remain below parent */
+            return 0;
+        i = j - 1;
+        if (tst_conc_unlink (c, tst_conc_at (stk, i)))
+            return 0;
+    }
+}
+
+/** tst_conc_ins_del() ins/del 's' in concurrent tree 'c', same semantics
+ *  as tst_ins_del() with storage set by tst_conc_create(). writers are
+ *  serialized, new nodes are linked with a single release store and nodes
+ *  and copied words removed by a delete are freed only once no reader can
+ *  hold them, so readers never see a partial update or freed memory.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on allocation failure on insert, or on successful
+ *  removal of 's' from tree.
+ */
+void *tst_conc_ins_del (tst_conc *c, char * const *s, const int del)
+{
+    node_tst **slot = &c->root, *curr, *chain = NULL, **link;
+    const char *p = *s;
+    char *str = *s;
+    void *ret = NULL;
+    tst_stack stk;
+
+    /* keeps the 127 char WRDMAX limit (see TST_KEYMAX) */
+    if (!*s || strlen (*s) + 1 > STKMAX / 2)
+        return NULL;
+
+    tst_stack_init (&stk);
+    mtx_lock (&c->lock);
+
+    while ((curr = *slot)) {                /* only writer stores, plain read */
+        int diff = *p - curr->key;
+        if (!tst_stack_push (&stk, slot))   /* slots on path */
+            goto done;
+        if (diff == 0) {
+            if (*p++ == 0)                  /* word exists */
+                break;
+            slot = &curr->eqkid;
+        }
+        else if (diff < 0)
+            slot = &curr->lokid;
+        else
+            slot = &curr->hikid;
+    }
+
+    if (curr) {                             /* word exists */
+        if (!del) {
+            curr->refcnt++;
+            ret = curr->eqkid;
+        }
+        else if (--curr->refcnt)            /* occurrences remain */
+            ret = curr->eqkid;
+        else if (tst_conc_del_word (c, &stk)) {
+            curr->refcnt = 1;
+            ret = curr->eqkid;
+        }
+        else
+            tst_conc_reclaim (c);
+        goto done;
+    }
+    if (del)                                /* not found */
+        goto done;
+
+    if (c->cpy) {   /* allocate storage for 's' */
+        size_t len = strlen (*s);
+        if (!(str = tst_str_alloc (NULL, len + 1)))
+            goto nomem;
+        memcpy (str, *s, len + 1);
+    }
+    for (link = &chain;; p++) {             /* chain for rest of 's' */
+        node_tst *node = tst_node_alloc (NULL);
+        if (!node)
+            goto nomem;
+        node->key = *p;
+        node->refcnt = 1;
+        *link = node;
+        if (!*p) {
+            node->eqkid = (node_tst *)str;
+            break;
+        }
+        link = &node->eqkid;
+    }
+    TST_STORE (*slot, chain);               /* publish chain */
+    ret = str;
+    goto done;
+
+nomem:
+    fprintf (stderr, "error: tst_conc_ins_del(), memory exhausted.\n");
+    while (chain) {
+        node_tst *next = chain->key ? chain->eqkid : NULL;
+        tst_node_free (NULL, chain);
+        chain = next;
+    }
+    if (c->cpy)
+        tst_str_free (NULL, str);
+
+done:
+    mtx_unlock (&c->lock);
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_conc_search() as tst_search() on concurrent tree 'c', called within
+ *  a read section. returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_conc_search (const tst_conc *c, const char *s)
+{
+    const node_tst *curr = TST_LOAD (c->root);
+
+    while (curr) {
+        int diff = *s - curr->key;
+        if (diff == 0) {
+            if (*s == 0)
+                return (void *)curr->eqkid;
+            s++;
+            curr = TST_LOAD (curr->eqkid);
+        }
+        else if (diff < 0)
+            curr = TST_LOAD (curr->lokid);
+        else
+            curr = TST_LOAD (curr->hikid);
+    }
+    return NULL;
+}
+
+/** fill 'a' with words in sibling tree at 'p' and below, in order. */
+static void tst_conc_suggest (const node_tst *p, char **a, int *n,
+                                const int max)
+{
+    for (; p && *n < max; p = TST_LOAD (p->hikid)) {
+        tst_conc_suggest (TST_LOAD (p->lokid), a, n, max);
+        if (*n >= max)
+            break;
+        if (!p->key)
+            a[(*n)++] = (char *)p->eqkid;
+        else
+            tst_conc_suggest (TST_LOAD (p->eqkid), a, n, max);
+    }
+}
+
+/** tst_conc_search_prefix() as tst_search_prefix() on concurrent tree 'c',
+ *  called within a read section. returns non-NULL on success, NULL
+ *  otherwise.
+ */
+void *tst_conc_search_prefix (const tst_conc *c, const char *s,
+                                char **a, int *n, const int max)
+{
+    const node_tst *curr = TST_LOAD (c->root);
+
+    *n = 0;
+    if (!*s) return NULL;
+
+    while (curr) {
+        int diff = *s - curr->key;
+        if (diff == 0) {
+            if (!*s)
+                return NULL;
+            if (!*++s) {                    /* prefix found */
+                tst_conc_suggest (TST_LOAD (curr->eqkid), a, n, max);
+                return (void *)curr;
+            }
+            curr = TST_LOAD (curr->eqkid);
+        }
+        else if (diff < 0)
+            curr = TST_LOAD (curr->lokid);
+        else
+            curr = TST_LOAD (curr->hikid);
+    }
+    return NULL;
+}
+
+/** tst_conc_destroy() free concurrent tree 'c', all nodes, retired nodes
+ *  and copied words (no reader may be in a read section).
+ */
+void tst_conc_destroy (tst_conc *c)
+{
+    if (!c)
+        return;
+
+    for (size_t i = 0; i < c->nretired; i++)
+        tst_conc_free (&c->retired[i]);
+    free (c->retired);
+    if (c->cpy)
+        tst_free_all (c->root);
+    else
+        tst_free (c->root);
+    mtx_destroy (&c->lock);
+    free (c);
+}
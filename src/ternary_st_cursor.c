@@ -0,0 +1,156 @@
+#include "ternary_st_priv.h"
+
+/** initial cursor stack size (frames), doubled as required */
+#define CURSTK 64
+
+/** cursor stack frame, node and next step for node. */
+typedef struct tst_frame {
+    const node_tst *node;
+    int step;               /* 0 - lokid, 1 - word or eqkid, 2 - hikid */
+} tst_frame;
+
+/** prefix cursor, in-order walk of the tree below the prefix held on an
+ *  explicit stack so the position is kept between calls.
+ */
+struct tst_cursor {
+    tst_frame *stk;         /* walk stack, stk[n - 1] is top */
+    size_t n,               /* frames in use */
+           max;             /* frames allocated */
+    char *word;             /* single match (prefix ends within leaf) */
+};
+
+/** push 'node' on stack of cursor 'c', growing stack as required.
+ *  returns 0 on success, -1 on allocation failure.
+ */
+static int tst_cursor_push (tst_cursor *c, const node_tst *node)
+{
+    if (c->n == c->max) {
+        size_t max = c->max ? c->max * 2 : CURSTK;
+        void *tmp = realloc (c->stk, max * sizeof *c->stk);
+        if (!tmp) {
+            fprintf (stderr, "error: tst_cursor_push(), memory exhausted.\n");
+            return -1;
+        }
+        c->stk = tmp;
+        c->max = max;
+    }
+    c->stk[c->n].node = node;
+    c->stk[c->n++].step = 0;
+
+    return 0;
+}
+
+/** tst_cursor_open() open cursor on words in tree at 'root' prefixed with
+ *  'prefix' (all words if 'prefix' is empty). words are returned in sorted
+ *  (traversal) order by tst_cursor_next(), a page at a time. the tree must
+ *  not be modified while the cursor is open. returns pointer to cursor
+ *  (with no words if no word has 'prefix'), NULL on allocation failure or
+ *  if a wide level or bucket (see tst_wide_ins_del(), tst_burst_ins_del())
+ *  is met.
+ */
+tst_cursor *tst_cursor_open (const node_tst *root, const char *prefix)
+{
+    const node_tst *curr = root;
+    const char *s = prefix;
+    tst_cursor *c = calloc (1, sizeof *c);
+
+    if (!c) {
+        fprintf (stderr, "error: tst_cursor_open(), memory exhausted.\n");
+        return NULL;
+    }
+
+    while (curr && *s) {                    /* node for last prefix char */
+        int diff = *s - curr->key;
+        if (curr->flags & TST_LEVEL)
+            break;
+        if (diff == 0) {
+            if (curr->flags & TST_LEAF) {   /* prefix ends within tail */
+                const char *word = (char *)curr->eqkid;
+                if (!strncmp (s, word + (s - prefix), strlen (s)))
+                    c->word = (char *)word;
+                return c;
+            }
+            s++;
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+
+    if (curr && curr->flags & TST_LEVEL) {
+        fprintf (stderr, "error: tst_cursor_open(), wide or burst tree.\n");
+        tst_cursor_close (c);
+        return NULL;
+    }
+    if (curr && tst_cursor_push (c, curr)) {
+        tst_cursor_close (c);
+        return NULL;
+    }
+
+    return c;
+}
+
+/** tst_cursor_next() fill ptr array 'a' with up to 'max' of the next words
+ *  of cursor 'c', continuing from the last word returned. no recursion,
+ *  the walk is resumed from the cursor stack so each page costs time in
+ *  proportion to the page only. returns the number of words in 'a' (0 when
+ *  all words have been returned), -1 on allocation failure or if a wide
+ *  level or bucket is met.
+ */
+int tst_cursor_next (tst_cursor *c, char **a, const int max)
+{
+    int n = 0;
+
+    if (!c || max <= 0)
+        return 0;
+
+    if (c->word) {                          /* single match */
+        a[n++] = c->word;
+        c->word = NULL;
+    }
+
+    while (c->n && n < max) {
+        tst_frame *f = c->stk + c->n - 1;
+        const node_tst *p = f->node;
+
+        switch (f->step++) {
+            case 0:                         /* lesser siblings first */
+                if (p->flags & TST_LEVEL) {
+                    fprintf (stderr, "error: tst_cursor_next(), wide or "
+                                    "burst tree.\n");
+                    return -1;
+                }
+                if (p->lokid && tst_cursor_push (c, p->lokid))
+                    return -1;
+                break;
+            case 1:
+                if (TST_WORD (p))
+                    a[n++] = (char *)p->eqkid;
+                else if (p->eqkid && tst_cursor_push (c, p->eqkid))
+                    return -1;
+                break;
+            default:                        /* replace frame with hikid */
+                if (p->hikid) {
+                    f->node = p->hikid;
+                    f->step = 0;
+                }
+                else
+                    c->n--;
+                break;
+        }
+    }
+
+    return n;
+}
+
+/** tst_cursor_close() free cursor 'c'. */
+void tst_cursor_close (tst_cursor *c)
+{
+    if (!c)
+        return;
+
+    free (c->stk);
+    free (c);
+}
@@ -0,0 +1,369 @@
+#define _POSIX_C_SOURCE 200112L     /* for mmap, open, fstat */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ternary_st_priv.h"
+
+/** frozen (read-only) tree, nodes in one array in blocked order, root at
+ *  index 0 (as no node links to root, 0 is nil for children). eqkid of the
+ *  node with key nul is the offset of the word in the string block. nodes
+ *  and strings are allocated, or point into a mapped image file.
+ */
+struct tst_frozen {
+    cnode_tst *nodes;       /* node array */
+    char *strs;             /* string block, nul-terminated words */
+    size_t nnodes,          /* number of nodes */
+           strsz;           /* bytes in string block */
+    void *map;              /* mapped image (NULL if allocated) */
+    size_t mapsz;           /* bytes mapped */
+};
+
+/** image file magic and version */
+#define TST_IMGMAGIC "TSTIMAGE"
+#define TST_IMGVER   1u
+#define TST_IMGBOM   0x01020304u
+
+/** image file header. nodes and strings are stored at the offsets given
+ *  (from start of file) exactly as held in memory, native byte order.
+ */
+typedef struct {
+    char magic[8];          /* TST_IMGMAGIC (no nul) */
+    uint32_t version,       /* TST_IMGVER */
+             bom,           /* TST_IMGBOM, byte order check */
+             nodesz,        /* sizeof (cnode_tst) */
+             pad;
+    uint64_t nnodes,        /* number of nodes */
+             nodeoff,       /* offset of node array */
+             strsz,         /* bytes in string block */
+             stroff;        /* offset of string block */
+} tst_imghdr;
+
+/** freeze state, source node of each output node. output indexes are
+ *  assigned in layout order, so src doubles as the breadth-first queue.
+ */
+typedef struct {
+    tst_frozen *f;
+    const node_tst **src;   /* source node of output node */
+    size_t next,            /* next output node index */
+           stroff;          /* next offset in string block */
+} tst_fz;
+
+/** count nodes and bytes of words in tree rooted at 'p'. returns 0 on
+ *  success, -1 if tree holds path-compressed leaves, keyless words, wide
+ *  levels or buckets (not supported).
+ */
+static int tst_fz_count (const node_tst *p, size_t *nnodes, size_t *strsz)
+{
+    if (!p)
+        return 0;
+    if ((p->flags & (TST_LEAF | TST_LEVEL)) || (!p->key && !p->eqkid))
+        return -1;
+    (*nnodes)++;
+    if (tst_fz_count (p->lokid, nnodes, strsz))
+        return -1;
+    if (p->key) {
+        if (tst_fz_count (p->eqkid, nnodes, strsz))
+            return -1;
+    }
+    else
+        *strsz += strlen ((char *)p->eqkid) + 1;
+
+    return tst_fz_count (p->hikid, nnodes, strsz);
+}
+
+/** lay out sibling tree rooted at 'p' breadth-first in consecutive nodes,
+ *  then the eqkid tree of each sibling in the same order. a unique suffix
+ *  chain is stored in consecutive nodes, and the top of each sibling tree
+ *  shares cache lines. returns index of the node for 'p'.
+ */
+static uint32_t tst_fz_layout (tst_fz *fz, const node_tst *p)
+{
+    size_t first = fz->next, last;
+
+    fz->src[fz->next++] = p;
+    for (size_t i = first; i < fz->next; i++) {     /* breadth-first */
+        const node_tst *s = fz->src[i];
+        cnode_tst *node = fz->f->nodes + i;
+        node->key = (unsigned char)s->key;
+        node->refcnt = s->refcnt > CREFMAX ? CREFMAX : s->refcnt;
+        node->lokid = node->hikid = node->eqkid = 0;
+        if (s->lokid) {
+            node->lokid = fz->next;
+            fz->src[fz->next++] = s->lokid;
+        }
+        if (s->hikid) {
+            node->hikid = fz->next;
+            fz->src[fz->next++] = s->hikid;
+        }
+    }
+    last = fz->next;
+
+    for (size_t i = first; i < last; i++) {         /* eqkid trees */
+        const node_tst *s = fz->src[i];
+        if (s->key) {
+            if (s->eqkid)
+                fz->f->nodes[i].eqkid = tst_fz_layout (fz, s->eqkid);
+        }
+        else {
+            size_t len = strlen ((char *)s->eqkid) + 1;
+            memcpy (fz->f->strs + fz->stroff, s->eqkid, len);
+            fz->f->nodes[i].eqkid = fz->stroff;
+            fz->stroff += len;
+        }
+    }
+
+    return first;
+}
+
+/** tst_freeze() compile tree rooted at 'root' into a frozen (read-only) tree
+ *  held in one node array in cache friendly order, with a copy of all words.
+ *  'root' is not modified and can be freed. returns pointer to frozen tree,
+ *  NULL on allocation failure, if tree exceeds 32-bit node/string indexes
+ *  or if tree is path-compressed (see tst_pc_ins_del()), keyless, wide or
+ *  burst (see tst_wide_ins_del(), tst_burst_ins_del()).
+ */
+tst_frozen *tst_freeze (const node_tst *root)
+{
+    tst_fz fz = { .f = NULL, .src = NULL, .next = 0, .stroff = 0 };
+    size_t nnodes = 0, strsz = 0;
+
+    if (tst_fz_count (root, &nnodes, &strsz)) {
+        fprintf (stderr, "error: tst_freeze(), path-compressed, keyless, "
+                        "wide or burst tree.\n");
+        return NULL;
+    }
+    if (nnodes > UINT32_MAX || strsz > UINT32_MAX) {
+        fprintf (stderr, "error: tst_freeze(), tree exceeds 32-bit indexes.\n");
+        return NULL;
+    }
+
+    if (!(fz.f = calloc (1, sizeof *fz.f)) ||
+            (nnodes && !(fz.f->nodes = malloc (nnodes * sizeof *fz.f->nodes))) ||
+            (strsz && !(fz.f->strs = malloc (strsz))) ||
+            (nnodes && !(fz.src = malloc (nnodes * sizeof *fz.src)))) {
+        fprintf (stderr, "error: tst_freeze(), memory exhausted.\n");
+        tst_frozen_free (fz.f);
+        return NULL;
+    }
+    fz.f->nnodes = nnodes;
+    fz.f->strsz = strsz;
+
+    if (root)
+        tst_fz_layout (&fz, root);
+    free (fz.src);
+
+    return fz.f;
+}
+
+/** tst_frozen_search(), find of a string in frozen tree.
+ *  returns pointer to copy of 's' in frozen tree on success, NULL otherwise.
+ */
+void *tst_frozen_search (const tst_frozen *f, const char *s)
+{
+    const cnode_tst *nodes = f->nodes;
+    uint32_t curr = 0;
+
+    if (!f->nnodes)
+        return NULL;
+
+    for (;;) {
+        const cnode_tst *node = nodes + curr;
+        int diff = *s - CKEY(node);
+        if (diff == 0) {
+            if (*s == 0)
+                return f->strs + node->eqkid;
+            s++;
+            curr = node->eqkid;
+        }
+        else if (diff < 0)
+            curr = node->lokid;
+        else
+            curr = node->hikid;
+        if (!curr)
+            return NULL;
+    }
+}
+
+/** fill ptr array 'a' with strings in frozen tree at node 'curr' (and its
+ *  siblings) that match the prefix ending in 'c', as tst_suggest().
+ */
+static void tst_frozen_suggest (const tst_frozen *f, uint32_t curr,
+                                const char c, const size_t nchr,
+                                char **a, int *n, const int max)
+{
+    const cnode_tst *node = f->nodes + curr;
+
+    if (*n == max)
+        return;
+    if (node->lokid)
+        tst_frozen_suggest (f, node->lokid, c, nchr, a, n, max);
+    if (node->key)
+        tst_frozen_suggest (f, node->eqkid, c, nchr, a, n, max);
+    else if (f->strs[node->eqkid + nchr - 1] == c && *n < max)
+        a[(*n)++] = f->strs + node->eqkid;
+    if (node->hikid)
+        tst_frozen_suggest (f, node->hikid, c, nchr, a, n, max);
+}
+
+/** tst_frozen_prefix() fills ptr array 'a' with words in frozen tree
+ *  prefixed with 's', up to 'max' words updating 'n' with the number of
+ *  words in 'a', as tst_search_prefix(). returns pointer to the node for
+ *  the last char of the prefix on success, NULL otherwise.
+ */
+void *tst_frozen_prefix (const tst_frozen *f, const char *s,
+                        char **a, int *n, const int max)
+{
+    const char *start = s;
+    uint32_t curr = 0;
+    size_t nchr;
+
+    if (!*s || !f->nnodes) return NULL;
+
+    nchr = strlen (s);
+    *n = 0;
+
+    for (;;) {
+        const cnode_tst *node = f->nodes + curr;
+        int diff = *s - CKEY(node);
+        if (diff == 0) {
+            if ((size_t)(s - start) == nchr - 1) {
+                tst_frozen_suggest (f, curr, CKEY(node), nchr, a, n, max);
+                return (void *)node;
+            }
+            s++;
+            curr = node->eqkid;
+        }
+        else if (diff < 0)
+            curr = node->lokid;
+        else
+            curr = node->hikid;
+        if (!curr)
+            return NULL;
+    }
+}
+
+/** tst_frozen_save() write frozen tree 'f' to image file 'path'. the image
+ *  holds offsets only (no pointers) and can be mapped by tst_frozen_map().
+ *  returns 0 on success, -1 on error.
+ */
+int tst_frozen_save (const tst_frozen *f, const char *path)
+{
+    tst_imghdr hdr = { .magic = TST_IMGMAGIC, .version = TST_IMGVER,
+                        .bom = TST_IMGBOM, .nodesz = sizeof (cnode_tst) };
+    FILE *fp;
+    int rtn = 0;
+
+    hdr.nnodes = f->nnodes;
+    hdr.nodeoff = sizeof hdr;
+    hdr.strsz = f->strsz;
+    hdr.stroff = hdr.nodeoff + f->nnodes * sizeof *f->nodes;
+
+    if (!(fp = fopen (path, "wb"))) {
+        fprintf (stderr, "error: tst_frozen_save(), file open failed '%s'.\n",
+                path);
+        return -1;
+    }
+    if (fwrite (&hdr, sizeof hdr, 1, fp) != 1 ||
+            fwrite (f->nodes, sizeof *f->nodes, f->nnodes, fp) != f->nnodes ||
+            fwrite (f->strs, 1, f->strsz, fp) != f->strsz)
+        rtn = -1;
+    if (fclose (fp) == EOF)
+        rtn = -1;
+    if (rtn)
+        fprintf (stderr, "error: tst_frozen_save(), write failed '%s'.\n", path);
+
+    return rtn;
+}
+
+/** tst_save() freeze tree rooted at 'root' and write image file 'path'.
+ *  returns 0 on success, -1 on error.
+ */
+int tst_save (const node_tst *root, const char *path)
+{
+    tst_frozen *f = tst_freeze (root);
+    int rtn;
+
+    if (!f)
+        return -1;
+    rtn = tst_frozen_save (f, path);
+    tst_frozen_free (f);
+
+    return rtn;
+}
+
+/** tst_frozen_map() map image file 'path' written by tst_frozen_save()
+ *  read-only and shared, nodes and strings are used in place with no
+ *  deserialization, so processes mapping the same image share one copy
+ *  through the page cache. only the header is validated, images are
+ *  trusted. returns pointer to frozen tree, NULL on error.
+ */
+tst_frozen *tst_frozen_map (const char *path)
+{
+    tst_frozen *f = NULL;
+    const tst_imghdr *hdr;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if ((fd = open (path, O_RDONLY)) == -1) {
+        fprintf (stderr, "error: tst_frozen_map(), file open failed '%s'.\n",
+                path);
+        return NULL;
+    }
+    if (fstat (fd, &st) == -1 || (size_t)st.st_size < sizeof *hdr) {
+        fprintf (stderr, "error: tst_frozen_map(), invalid image '%s'.\n", path);
+        close (fd);
+        return NULL;
+    }
+    map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);                 /* mapping remains valid after close */
+    if (map == MAP_FAILED) {
+        fprintf (stderr, "error: tst_frozen_map(), mmap failed '%s'.\n", path);
+        return NULL;
+    }
+
+    hdr = map;
+    if (memcmp (hdr->magic, TST_IMGMAGIC, sizeof hdr->magic) ||
+            hdr->version != TST_IMGVER || hdr->bom != TST_IMGBOM ||
+            hdr->nodesz != sizeof (cnode_tst) ||
+            hdr->nodeoff % _Alignof (cnode_tst) ||
+            hdr->nnodes > UINT32_MAX || hdr->strsz > UINT32_MAX ||
+            hdr->nodeoff + hdr->nnodes * sizeof (cnode_tst) > hdr->stroff ||
+            hdr->stroff + hdr->strsz > (uint64_t)st.st_size) {
+        fprintf (stderr, "error: tst_frozen_map(), invalid image '%s'.\n", path);
+        munmap (map, st.st_size);
+        return NULL;
+    }
+
+    if (!(f = calloc (1, sizeof *f))) {
+        fprintf (stderr, "error: tst_frozen_map(), memory exhausted.\n");
+        munmap (map, st.st_size);
+        return NULL;
+    }
+    f->map = map;
+    f->mapsz = st.st_size;
+    f->nnodes = hdr->nnodes;
+    f->nodes = (cnode_tst *)((char *)map + hdr->nodeoff);
+    f->strsz = hdr->strsz;
+    f->strs = (char *)map + hdr->stroff;
+
+    return f;
+}
+
+/** tst_frozen_free() free (or unmap) frozen tree 'f'. */
+void tst_frozen_free (tst_frozen *f)
+{
+    if (!f)
+        return;
+
+    if (f->map)
+        munmap (f->map, f->mapsz);
+    else {
+        free (f->nodes);
+        free (f->strs);
+    }
+    free (f);
+}
@@ -0,0 +1,180 @@
+#include "ternary_st_priv.h"
+
+/** fuzzy search state. row d holds the edit distance of the d chars on the
+ *  tree path to each prefix of 's' (m + 1 ints per row, one row per depth).
+ *  the min of row d is at least d - m, so no path deeper than m + maxdist
+ *  is entered and m + maxdist + 2 rows (at most TST_PATHMAX + 2, the
+ *  longest path) are enough.
+ */
+typedef struct tst_fuzzy {
+    const char *s;          /* word searched for */
+    size_t m;               /* length of s */
+    int maxdist,            /* max edit distance */
+        prefix;             /* match words with a prefix within maxdist */
+    int *rows;              /* rows for depth 0 - m + maxdist + 1 */
+    char **out;             /* matching words */
+    int n, max;             /* number of words in out, max words */
+} tst_fuzzy;
+
+/** add word 'w' to matches of 'f'. */
+static void tst_lev_add (tst_fuzzy *f, const void *w)
+{
+    if (f->n < f->max)
+        f->out[f->n++] = (char *)w;
+}
+
+/** fill row 'next' for tree char 'c' from row 'prev'. returns row min. */
+static int tst_lev_row (const tst_fuzzy *f, const int *prev, int *next,
+                        const char c)
+{
+    int min = next[0] = prev[0] + 1;
+
+    for (size_t j = 1; j <= f->m; j++) {
+        int d = prev[j - 1] + (f->s[j - 1] != c);   /* substitute / match */
+        if (prev[j] + 1 < d)                        /* delete */
+            d = prev[j] + 1;
+        if (next[j - 1] + 1 < d)                    /* insert */
+            d = next[j - 1] + 1;
+        next[j] = d;
+        if (d < min)
+            min = d;
+    }
+
+    return min;
+}
+
+/** add every word in tree at 'p' to matches of 'f', in order. */
+static void tst_lev_all (const node_tst *p, tst_fuzzy *f)
+{
+    if (p && p->flags & TST_WIDE) {         /* level nodes, in key order */
+        const tst_wnode *w = (const tst_wnode *)p;
+        for (unsigned i = 0; i < w->n; i++)
+            tst_lev_all (&w->ent[i], f);
+        return;
+    }
+    if (p && p->flags & TST_BUCKET) {       /* word nodes, in key order */
+        const tst_bucket *b = (const tst_bucket *)p;
+        for (unsigned i = 0; i < b->n; i++)
+            tst_lev_add (f, b->ent[i].eqkid);
+        return;
+    }
+    for (; p && f->n < f->max; p = p->hikid) {
+        tst_lev_all (p->lokid, f);
+        if (TST_WORD (p))
+            tst_lev_add (f, p->eqkid);
+        else
+            tst_lev_all (p->eqkid, f);
+    }
+}
+
+/** continue rows of 'f' from depth 'd' over the tail of the word held in
+ *  leaf (or bucket word node) 'p', adding the word if within maxdist.
+ */
+static void tst_lev_tail (const node_tst *p, size_t d, tst_fuzzy *f)
+{
+    const char *w = (char *)p->eqkid;
+
+    for (; w[d]; d++) {
+        int *row = f->rows + d * (f->m + 1);
+        if (tst_lev_row (f, row, row + f->m + 1, w[d]) > f->maxdist)
+            return;                         /* no extension can match */
+        if (f->prefix && row[f->m + 1 + f->m] <= f->maxdist) {
+            tst_lev_add (f, w);             /* prefix within maxdist */
+            return;
+        }
+    }
+    if (f->rows[d * (f->m + 1) + f->m] <= f->maxdist)
+        tst_lev_add (f, w);
+}
+
+/** walk sibling tree at 'p' (depth 'd') in order, extending the row for
+ *  depth 'd' by each node key and entering eqkid only while the row min
+ *  is within maxdist. the nodes of a wide level are walked in key order,
+ *  the words of a bucket are continued over their tails.
+ */
+static void tst_lev_walk (const node_tst *p, const size_t d, tst_fuzzy *f)
+{
+    int *row = f->rows + d * (f->m + 1), *next = row + f->m + 1;
+
+    if (p && p->flags & TST_WIDE) {
+        const tst_wnode *w = (const tst_wnode *)p;
+        for (unsigned i = 0; i < w->n; i++)
+            tst_lev_walk (&w->ent[i], d, f);
+        return;
+    }
+    if (p && p->flags & TST_BUCKET) {
+        const tst_bucket *b = (const tst_bucket *)p;
+        for (unsigned i = 0; i < b->n && f->n < f->max; i++)
+            tst_lev_tail (&b->ent[i], d, f);
+        return;
+    }
+    for (; p && f->n < f->max; p = p->hikid) {
+        tst_lev_walk (p->lokid, d, f);
+        if (!p->key) {                      /* word ends at depth d */
+            if (row[f->m] <= f->maxdist)
+                tst_lev_add (f, p->eqkid);
+        }
+        else if (p->flags & TST_LEAF)
+            tst_lev_tail (p, d, f);
+        else if (tst_lev_row (f, row, next, p->key) <= f->maxdist) {
+            if (f->prefix && next[f->m] <= f->maxdist)
+                tst_lev_all (p->eqkid, f);  /* path within maxdist of s */
+            else
+                tst_lev_walk (p->eqkid, d + 1, f);
+        }
+    }
+}
+
+/** search tree at 'root' for words (or prefixes if 'prefix') within
+ *  'maxdist' of 's'. returns number of words in 'out', -1 on failure.
+ */
+static int tst_fuzzy_search (const node_tst *root, const char *s,
+                            const int maxdist, char **out, const int max,
+                            const int prefix)
+{
+    tst_fuzzy f = { .s = s, .m = strlen (s), .maxdist = maxdist,
+                    .prefix = prefix, .rows = NULL, .out = out, .n = 0,
+                    .max = max };
+    size_t depth = f.m + (size_t)maxdist;
+
+    if (maxdist < 0 || max <= 0)
+        return 0;
+
+    if (depth > TST_PATHMAX)                /* no path is longer */
+        depth = TST_PATHMAX;
+    if (!(f.rows = malloc ((depth + 2) * (f.m + 1) * sizeof *f.rows))) {
+        fprintf (stderr, "error: tst_search_fuzzy(), memory exhausted.\n");
+        return -1;
+    }
+    for (size_t j = 0; j <= f.m; j++)       /* distance from empty path */
+        f.rows[j] = j;
+
+    if (prefix && f.rows[f.m] <= maxdist)
+        tst_lev_all (root, &f);
+    else
+        tst_lev_walk (root, 0, &f);
+    free (f.rows);
+
+    return f.n;
+}
+
+/** tst_search_fuzzy() fills ptr array 'out' with up to 'max' words within
+ *  Levenshtein distance 'maxdist' of 's', in sorted (traversal) order. the
+ *  tree is walked with one edit-distance row per depth and a branch is
+ *  pruned once the min of its row exceeds 'maxdist'. returns number of
+ *  words in 'out', -1 on allocation failure.
+ */
+int tst_search_fuzzy (const node_tst *root, const char *s, const int maxdist,
+                        char **out, const int max)
+{
+    return tst_fuzzy_search (root, s, maxdist, out, max, 0);
+}
+
+/** tst_search_fuzzy_prefix() as tst_search_fuzzy() for completion, fills
+ *  'out' with words having a prefix within distance 'maxdist' of 's'.
+ */
+int tst_search_fuzzy_prefix (const node_tst *root, const char *s,
+                            const int maxdist, char **out, const int max)
+{
+    return tst_fuzzy_search (root, s, maxdist, out, max, 1);
+}
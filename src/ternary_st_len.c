@@ -0,0 +1,219 @@
+#include "ternary_st_priv.h"
+
+/** length-delimited key read one tree path char at a time. key bytes 0 and
+ *  TST_ESC are held as two chars, TST_ESC then the byte + 1, so no path
+ *  char is nul and the key order (and prefixes) are those of the bytes.
+ *  the key is read once, in step with the walk, never scanned for length.
+ */
+typedef struct tst_lkey {
+    const char *s, *end;    /* next key byte, end of key */
+    char esc;               /* second char of escaped byte pending (or 0) */
+} tst_lkey;
+
+/** next path char of key 'k', nul once the key is read. */
+static inline char tst_lkey_next (tst_lkey *k)
+{
+    char c;
+
+    if (k->esc) {
+        c = k->esc;
+        k->esc = 0;
+        return c;
+    }
+    if (k->s == k->end)
+        return 0;
+    c = *k->s++;
+    if (c == 0 || c == TST_ESC) {
+        k->esc = c + 1;
+        return TST_ESC;
+    }
+
+    return c;
+}
+
+/** tst_ins_del() of key 'k' with delete path held on 'stk'. */
+static void *tst_ins_del_lkey (node_tst **root, char * const *s, tst_lkey k,
+                            const int del, const int cpy, tst_stack *stk)
+{
+    const tst_lkey key = k;
+    node_tst *curr, **pcurr = root;
+    char c = tst_lkey_next (&k);
+
+    while ((curr = *pcurr)) {
+        int diff = c - curr->key;
+        if (diff == 0) {
+            if (c == 0) {                   /* key exists */
+                if (del) {
+                    curr->refcnt--;
+                    return tst_del_word (root, NULL, curr, stk, cpy);
+                }
+                curr->refcnt++;
+                if (cpy == TST_NOKEY)
+                    return (void *)curr;
+                return (void *)curr->eqkid;
+            }
+            pcurr = &curr->eqkid;
+            c = tst_lkey_next (&k);
+        }
+        else if (diff < 0)
+            pcurr = &curr->lokid;
+        else
+            pcurr = &curr->hikid;
+        if (del && !tst_stack_push (stk, curr))
+            return NULL;
+    }
+    if (del)                                /* key not in tree */
+        return NULL;
+    if ((size_t)(key.end - key.s) > TST_KEYMAX) {
+        fprintf (stderr, "error: tst_ins_del_len(), key exceeds TST_KEYMAX.\n");
+        return NULL;
+    }
+
+    for (;;) {                              /* nodes for rest of key */
+        if (!(curr = *pcurr = tst_node_alloc (NULL))) {
+            fprintf (stderr, "error: tst_ins_del_len(), memory exhausted.\n");
+            return NULL;
+        }
+        curr->key = c;
+        curr->refcnt = 1;
+        if (!c)
+            break;
+        pcurr = &curr->eqkid;
+        c = tst_lkey_next (&k);
+    }
+
+    if (cpy == TST_NOKEY)
+        return (void *)curr;
+    if (cpy) {      /* copy of key, nul-terminated for text keys */
+        size_t len = key.end - key.s;
+        char *eqdata = tst_str_alloc (NULL, len + 1);
+        if (!eqdata) {
+            fprintf (stderr, "error: tst_ins_del_len(), memory exhausted.\n");
+            return NULL;
+        }
+        memcpy (eqdata, key.s, len);
+        eqdata[len] = 0;
+        curr->eqkid = (node_tst *)eqdata;
+    }
+    else
+        curr->eqkid = (node_tst *)*s;
+
+    return (void *)curr->eqkid;
+}
+
+/** tst_ins_del_len() ins/del key of 'len' bytes at '*s' as tst_ins_del(),
+ *  the key may hold any byte (nul included), up to TST_KEYMAX (4096)
+ *  bytes (a longer key is refused, NULL returned). a copy ('cpy' non-zero)
+ *  is nul-terminated after 'len' bytes. a key holding no nul or 0x01 byte
+ *  is held the same as the string inserted with tst_ins_del(), so text
+ *  keys may be searched with either. deleting a key not in the tree leaves
+ *  the tree unchanged and returns NULL (unlike tst_ins_del(), which inserts
+ *  it). returns as tst_ins_del().
+ */
+void *tst_ins_del_len (node_tst **root, char * const *s, const size_t len,
+                        const int del, const int cpy)
+{
+    tst_lkey k = { .s = *s, .end = *s + len, .esc = 0 };
+    tst_stack stk;
+    void *ret;
+
+    if (!root || !*s)
+        return NULL;
+
+    tst_stack_init (&stk);
+    ret = tst_ins_del_lkey (root, s, k, del, cpy, &stk);
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_search_len() find key of 'len' bytes at 's' (see tst_ins_del_len()).
+ *  returns pointer to stored key on success (node for TST_NOKEY), NULL
+ *  otherwise.
+ */
+void *tst_search_len (const node_tst *p, const char *s, const size_t len)
+{
+    tst_lkey k = { .s = s, .end = s + len, .esc = 0 };
+    char c = tst_lkey_next (&k);
+
+    while (p) {
+        int diff = c - p->key;
+        if (diff == 0) {
+            if (c == 0)
+                return p->eqkid ? (void *)p->eqkid : (void *)p;
+            c = tst_lkey_next (&k);
+            p = p->eqkid;
+        }
+        else if (diff < 0)
+            p = p->lokid;
+        else
+            p = p->hikid;
+    }
+
+    return NULL;
+}
+
+/** prefix search state, words and their lengths in key bytes. */
+typedef struct tst_lwords {
+    char **a;
+    size_t *lens;           /* key length of each word (may be NULL) */
+    int n, max;
+} tst_lwords;
+
+/** add each word in tree at 'p' to 'w' in order, 'len' key bytes on the
+ *  path to 'p', 'esc' non-zero if the path ends in an unpaired TST_ESC.
+ */
+static void tst_suggest_len (const node_tst *p, const size_t len,
+                            const int esc, tst_lwords *w)
+{
+    for (; p && w->n < w->max; p = p->hikid) {
+        tst_suggest_len (p->lokid, len, esc, w);
+        if (w->n == w->max)
+            return;
+        if (!p->key) {
+            if (w->lens)
+                w->lens[w->n] = len;
+            w->a[w->n++] = (char *)p->eqkid;
+        }
+        else if (esc || p->key != TST_ESC)
+            tst_suggest_len (p->eqkid, len + 1, 0, w);
+        else
+            tst_suggest_len (p->eqkid, len, 1, w);
+    }
+}
+
+/** tst_search_prefix_len() fills ptr array 'a' with keys prefixed with the
+ *  'len' bytes at 's' (every key if 'len' is 0) in sorted order, with the
+ *  length of each in 'lens' (if not NULL), up to 'max' keys, updating 'n'
+ *  with the number of keys in 'a'. for a TST_NOKEY tree 'a' holds NULL for
+ *  each key. returns non-NULL on success, NULL if no key has the prefix.
+ */
+void *tst_search_prefix_len (const node_tst *root, const char *s,
+                            const size_t len, char **a, size_t *lens,
+                            int *n, const int max)
+{
+    tst_lkey k = { .s = s, .end = s + len, .esc = 0 };
+    tst_lwords w = { .a = a, .lens = lens, .n = 0, .max = max };
+    const node_tst *p = root;
+    char c = tst_lkey_next (&k);
+
+    *n = 0;
+    while (p && c) {                        /* eqkid below prefix */
+        int diff = c - p->key;
+        if (diff == 0) {
+            c = tst_lkey_next (&k);
+            p = p->eqkid;
+        }
+        else if (diff < 0)
+            p = p->lokid;
+        else
+            p = p->hikid;
+    }
+    if (!p)
+        return NULL;
+
+    tst_suggest_len (p, len, 0, &w);
+    *n = w.n;
+
+    return w.n ? (void *)p : NULL;
+}
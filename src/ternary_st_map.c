@@ -0,0 +1,188 @@
+#include "ternary_st_priv.h"
+
+/** map. a plain tree whose word nodes are allocated as tst_mnode, the
+ *  node followed by the value of the key, so one walk finds the key and its
+ *  value. the rest of the tree is unchanged, the read-only functions and
+ *  tst_ins_del() delete work on a map as on any tree.
+ */
+
+/** find 's' in map at 'root', adding it with a zero value if not found,
+ *  'found' set to 1 if 's' was in the map, 0 if added. returns word node
+ *  of 's', NULL on allocation failure (map unchanged).
+ */
+static tst_mnode *tst_map_node (node_tst **root, char * const *s,
+                                const int cpy, int *found)
+{
+    node_tst *curr, **pcurr = root, *chain = NULL, **link = &chain;
+    const char *p = *s;
+    char *str = NULL;
+
+    *found = 0;
+    if (!root || !*s)
+        return NULL;
+
+    while ((curr = *pcurr)) {
+        int diff = *p - curr->key;
+        if (diff == 0) {
+            if (*p++ == 0) {                /* key exists */
+                *found = 1;
+                return (tst_mnode *)curr;
+            }
+            pcurr = &curr->eqkid;
+        }
+        else if (diff < 0)
+            pcurr = &curr->lokid;
+        else
+            pcurr = &curr->hikid;
+    }
+
+    if ((size_t)(p - *s) + strlen (p) > TST_KEYMAX) {
+        fprintf (stderr, "error: tst_map_put(), key exceeds TST_KEYMAX.\n");
+        return NULL;
+    }
+    if (cpy == TST_NOKEY)                   /* value alone, key is the path */
+        str = NULL;
+    else if (cpy) {                         /* allocate storage for 's' */
+        size_t len = strlen (*s);
+        if (!(str = tst_str_alloc (NULL, len + 1)))
+            goto nomem;
+        memcpy (str, *s, len + 1);
+    }
+    else
+        str = *s;
+
+    for (;; p++) {                          /* chain for rest of 's' */
+        node_tst *node = *p ? tst_node_alloc (NULL)
+                            : calloc (1, sizeof (tst_mnode));
+        if (!node)
+            goto nomem;
+        node->key = *p;
+        node->refcnt = 1;
+        *link = node;
+        if (!*p) {
+            node->eqkid = (node_tst *)str;
+            *pcurr = chain;
+            return (tst_mnode *)node;
+        }
+        link = &node->eqkid;
+    }
+
+nomem:
+    fprintf (stderr, "error: tst_map_put(), memory exhausted.\n");
+    while (chain) {
+        node_tst *next = chain->eqkid;
+        free (chain);
+        chain = next;
+    }
+    if (cpy && cpy != TST_NOKEY)
+        tst_str_free (NULL, str);
+
+    return NULL;
+}
+
+/** tst_map_put() set value of 's' in map at 'root' to 'val', adding 's'
+ *  (by copy or reference per 'cpy', or TST_NOKEY for the value alone) if
+ *  not in the map. a map is a plain tree whose word nodes hold a value
+ *  after the node, so the read-only functions (tst_search(),
+ *  tst_search_prefix(), tst_traverse_fn(), ...) work on it, and it is freed
+ *  with tst_free() or tst_free_all(). keys must be added with tst_map_put()
+ *  or tst_map_upsert() (a word node added by tst_ins_del() has no value)
+ *  and removed with tst_map_del(). returns pointer to the value, valid
+ *  until 's' is removed, NULL on allocation failure.
+ */
+tst_value *tst_map_put (node_tst **root, char * const *s, const int cpy,
+                        const tst_value val)
+{
+    int found;
+    tst_mnode *m = tst_map_node (root, s, cpy, &found);
+
+    if (!m)
+        return NULL;
+    m->val = val;
+
+    return &m->val;
+}
+
+/** tst_map_upsert() find 's' in map at 'root', adding it with a zero value
+ *  if not found (see tst_map_put()), 'found' (if not NULL) set to 1 if 's'
+ *  was in the map, 0 if added. one walk for find or add, the caller
+ *  updates or initializes the value through the pointer returned. returns
+ *  pointer to the value, NULL on allocation failure.
+ */
+tst_value *tst_map_upsert (node_tst **root, char * const *s, const int cpy,
+                            int *found)
+{
+    int f;
+    tst_mnode *m = tst_map_node (root, s, cpy, &f);
+
+    if (found)
+        *found = f;
+
+    return m ? &m->val : NULL;
+}
+
+/** word node of 's' in tree at 'p', NULL if not found. */
+static const node_tst *tst_map_find (const node_tst *p, const char *s)
+{
+    while (p) {
+        int diff = *s - p->key;
+        if (diff == 0) {
+            if (*s++ == 0)
+                return p;
+            p = p->eqkid;
+        }
+        else if (diff < 0)
+            p = p->lokid;
+        else
+            p = p->hikid;
+    }
+    return NULL;
+}
+
+/** tst_map_get() returns pointer to the value of 's' in map at 'root', NULL
+ *  if not found.
+ */
+const tst_value *tst_map_get (const node_tst *root, const char *s)
+{
+    const node_tst *p = tst_map_find (root, s);
+
+    return p ? &((const tst_mnode *)p)->val : NULL;
+}
+
+/** tst_map_update() returns pointer to the value of 's' in map at 'root'
+ *  to update in place, NULL if not found (nothing added).
+ */
+tst_value *tst_map_update (node_tst *root, const char *s)
+{
+    node_tst *p = (node_tst *)tst_map_find (root, s);
+
+    return p ? &((tst_mnode *)p)->val : NULL;
+}
+
+/** tst_map_value() returns pointer to the value of word node 'node' of a
+ *  map, as passed to the tst_traverse_fn() callback.
+ */
+tst_value *tst_map_value (const void *node)
+{
+    return &((tst_mnode *)node)->val;
+}
+
+/** tst_map_del() remove 's' from map at 'root' whatever its refcnt, the
+ *  stored copy freed for a map by copy ('cpy' as added), the value copied
+ *  to 'val' if not NULL. returns 0 on success, -1 if not found.
+ */
+int tst_map_del (node_tst **root, const char *s, const int cpy,
+                    tst_value *val)
+{
+    node_tst *p = (node_tst *)tst_map_find (*root, s);
+    char *key = (char *)s;
+
+    if (!p)
+        return -1;
+    if (val)
+        *val = ((tst_mnode *)p)->val;
+    p->refcnt = 1;                          /* last occurrence, node removed */
+    tst_ins_del (root, &key, 1, cpy);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#define _POSIX_C_SOURCE 200112L     /* for mmap, open, fstat */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ternary_st_priv.h"
+
+/** word file mapped private and writable, lines split in place so the
+ *  words of the tree at '*root' (by reference) point into the mapping.
+ */
+struct tst_mapped {
+    node_tst **root;        /* tree holding the words, freed with mapping */
+    char *map;              /* mapped file (NULL for empty file) */
+    size_t mapsz,           /* bytes mapped */
+           nwords;          /* lines inserted */
+    char *tail;             /* last line, if no room to terminate in map */
+};
+
+/** insert line [s, end) of 'm', removing a trailing '\r' and terminating
+ *  it in place. empty lines are skipped. returns 0 on success, -1 on
+ *  allocation failure.
+ */
+static int tst_mapped_line (tst_mapped *m, char *s, char *end)
+{
+    if (end > s && end[-1] == '\r')
+        end--;
+    if (end == s)
+        return 0;
+
+    if (end == m->map + m->mapsz) {         /* no room for nul in map */
+        size_t len = end - s;
+        if (!(m->tail = malloc (len + 1))) {
+            fprintf (stderr, "error: tst_load_mapped(), memory exhausted.\n");
+            return -1;
+        }
+        memcpy (m->tail, s, len);
+        s = m->tail;
+        end = s + len;
+    }
+    *end = 0;
+
+    if (!tst_ins_del (m->root, &s, 0, 0))
+        return -1;
+    m->nwords++;
+
+    return 0;
+}
+
+/** tst_load_mapped() map word file 'path' (one word per line, LF or CRLF
+ *  line ends, empty lines skipped) private and writable, split the lines
+ *  in place and insert each word by reference into the empty tree at
+ *  'root' in file order, so the load allocates nodes only, no storage per
+ *  word. pages are copied by the kernel as lines are terminated, the file
+ *  is never written. the words live in the mapping, so the tree is freed
+ *  and the file unmapped together by tst_mapped_free(), and 'root' must
+ *  remain valid until then (words may be added or deleted by reference in
+ *  the meantime). returns pointer to mapping handle, NULL on error (tree
+ *  left empty).
+ */
+tst_mapped *tst_load_mapped (const char *path, node_tst **root)
+{
+    tst_mapped *m;
+    struct stat st;
+    char *s, *end;
+    int fd;
+
+    if (!root || *root) {
+        fprintf (stderr, "error: tst_load_mapped(), tree not empty.\n");
+        return NULL;
+    }
+    if ((fd = open (path, O_RDONLY)) == -1) {
+        fprintf (stderr, "error: tst_load_mapped(), file open failed '%s'.\n",
+                path);
+        return NULL;
+    }
+    if (fstat (fd, &st) == -1) {
+        fprintf (stderr, "error: tst_load_mapped(), fstat failed '%s'.\n", path);
+        close (fd);
+        return NULL;
+    }
+    if (!(m = calloc (1, sizeof *m))) {
+        fprintf (stderr, "error: tst_load_mapped(), memory exhausted.\n");
+        close (fd);
+        return NULL;
+    }
+    m->root = root;
+
+    if (st.st_size > 0) {                   /* mmap of 0 bytes fails */
+        void *map = mmap (NULL, st.st_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            fprintf (stderr, "error: tst_load_mapped(), mmap failed '%s'.\n",
+                    path);
+            close (fd);
+            free (m);
+            return NULL;
+        }
+        m->map = map;
+        m->mapsz = st.st_size;
+    }
+    close (fd);                 /* mapping remains valid after close */
+
+    for (s = m->map, end = s + m->mapsz; s < end;) {
+        char *nl = memchr (s, '\n', end - s);
+        if (!nl)
+            nl = end;
+        if (tst_mapped_line (m, s, nl)) {
+            tst_mapped_free (m);
+            return NULL;
+        }
+        s = nl + 1;
+    }
+
+    return m;
+}
+
+/** tst_mapped_words() returns number of words inserted by tst_load_mapped()
+ *  (duplicates included).
+ */
+size_t tst_mapped_words (const tst_mapped *m)
+{
+    return m->nwords;
+}
+
+/** tst_mapped_free() free the tree at 'root' given to tst_load_mapped()
+ *  (words held by reference, root set NULL), then unmap the word file.
+ */
+void tst_mapped_free (tst_mapped *m)
+{
+    if (!m)
+        return;
+
+    tst_free (*m->root);
+    *m->root = NULL;
+    if (m->map)
+        munmap (m->map, m->mapsz);
+    free (m->tail);
+    free (m);
+}
@@ -0,0 +1,127 @@
+#include "ternary_st_priv.h"
+
+/** longest-prefix match. the word ending after 'i' chars of the text is the
+ *  nul node of the sibling tree reached after 'i' eqkid steps, so one
+ *  descent of the text visits every stored prefix of it in turn. the nul
+ *  node is found on the path of the next char while the two paths are the
+ *  same, and by a walk of lo/hi links from where they part.
+ */
+
+/** word node of key nul in sibling tree at 'p', NULL if none. */
+static const node_tst *tst_match_nul (const node_tst *p)
+{
+    while (p && p->key)
+        p = p->key > 0 ? p->lokid : p->hikid;
+
+    return p;
+}
+
+/** longest word in tree at 'root' that is a prefix of 'text' (see
+ *  tst_longest_prefix()), 'err' set if a wide level or bucket is met (match
+ *  NULL).
+ */
+static const node_tst *tst_longest (const node_tst *root, const char *text,
+                                    const size_t len, size_t *mlen, int *err)
+{
+    const node_tst *curr = root, *last = NULL;
+    size_t i = 0, n = 0;
+
+    while (curr) {
+        const node_tst *nul = NULL;
+        int c = i < len ? text[i] : 0, split = 0;
+
+        if (curr->flags & TST_LEVEL) {      /* sibling level, not lo/hi */
+            fprintf (stderr, "error: tst_longest_prefix(), wide or burst "
+                            "tree.\n");
+            *err = 1;
+            last = NULL, n = 0;
+            break;
+        }
+        if (!c) {                           /* end of text, word ends here */
+            if ((nul = tst_match_nul (curr)))
+                last = nul, n = i;
+            break;
+        }
+        while (curr && curr->key != c) {    /* find 'c', nul on the way */
+            if (!split) {
+                if (!curr->key)
+                    nul = curr, split = 1;
+                else if ((c < curr->key) != (0 < curr->key)) {
+                    nul = tst_match_nul (c < curr->key ? curr->hikid
+                                                        : curr->lokid);
+                    split = 1;
+                }
+            }
+            curr = c < curr->key ? curr->lokid : curr->hikid;
+        }
+        if (!split && curr)                 /* paths the same to 'c' */
+            nul = tst_match_nul (c < 0 ? curr->hikid : curr->lokid);
+        if (nul)
+            last = nul, n = i;
+        if (!curr)
+            break;
+
+        if (curr->flags & TST_LEAF) {       /* tail must be a prefix of rest */
+            const char *tail = (char *)curr->eqkid + i;
+            size_t tlen = strlen (tail);
+            /* strncmp stops at a nul ending the text before 'len' */
+            if (tlen <= len - i && !strncmp (text + i, tail, tlen))
+                last = curr, n = i + tlen;
+            break;
+        }
+        i++;
+        curr = curr->eqkid;
+    }
+
+    if (mlen)
+        *mlen = n;
+
+    return last;
+}
+
+/** tst_longest_prefix() find the longest word in tree at 'root' (plain,
+ *  path-compressed or keyless) that is a prefix of the first 'len' chars of
+ *  'text' (the text ends at a nul before 'len'), in one descent. 'mlen' (if
+ *  not NULL) set to the length of the word. returns word node of the word
+ *  (see tst_get_string(), tst_map_value()), NULL if no word is a prefix or
+ *  if a wide level or bucket (see tst_wide_ins_del(), tst_burst_ins_del())
+ *  is met.
+ */
+const node_tst *tst_longest_prefix (const node_tst *root, const char *text,
+                                    const size_t len, size_t *mlen)
+{
+    int err = 0;
+
+    return tst_longest (root, text, len, mlen, &err);
+}
+
+/** tst_longest_scan() split the first 'len' chars of 'text' into longest
+ *  matches of words in tree at 'root' (see tst_longest_prefix()), calling
+ *  'fn' with the word node, offset and length of each match and 'data'.
+ *  the scan resumes after each match, and one char on from a position with
+ *  no match (the empty word is not a match), and stops if a wide level or
+ *  bucket is met. returns number of matches.
+ */
+size_t tst_longest_scan (const node_tst *root, const char *text,
+                        const size_t len,
+                        void (fn)(const node_tst *, size_t, size_t, void *),
+                        void *data)
+{
+    size_t off = 0, count = 0;
+    int err = 0;
+
+    while (off < len && text[off] && !err) {
+        size_t n;
+        const node_tst *node = tst_longest (root, text + off, len - off, &n,
+                                            &err);
+        if (!node || !n) {
+            off++;
+            continue;
+        }
+        fn (node, off, n, data);
+        count++;
+        off += n;
+    }
+
+    return count;
+}
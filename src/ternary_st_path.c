@@ -0,0 +1,304 @@
+#include "ternary_st_priv.h"
+
+/** path-compressed tree. the unique suffix chain of a word (every char
+ *  after the last char it shares with another word) is held in a single
+ *  TST_LEAF node, key set to the first char of the tail and eqkid to the
+ *  word, the rest of the tail is compared against the stored word. a leaf
+ *  is split when an inserted word diverges within its tail and nodes are
+ *  merged back into a leaf when a delete leaves one word below them, so the
+ *  tree has the same shape as a plain tree with suffix chains removed.
+ */
+
+/** allocate node for word 'str' with tail 'p', leaf if tail is not empty,
+ *  otherwise node with key nul. returns pointer to node, NULL on failure.
+ */
+static node_tst *tst_pc_word_node (const char *p, char *str, unsigned refcnt)
+{
+    node_tst *node = tst_node_alloc (NULL);
+
+    if (!node)
+        return NULL;
+    node->key = *p;
+    node->flags = *p ? TST_LEAF : 0;
+    node->refcnt = refcnt;
+    node->eqkid = (node_tst *)str;
+
+    return node;
+}
+
+/** split 'leaf' at depth 'd' (chars before the leaf key) for word 's' of
+ *  length 'len' diverging within the leaf tail. the leaf becomes a node
+ *  on the chain of shared chars ending in the nodes for both words.
+ *  returns address of word on success, NULL on allocation failure (tree
+ *  unchanged).
+ */
+static void *tst_pc_split (node_tst *leaf, const size_t d, char * const *s,
+                            const size_t len, const int cpy)
+{
+    const char *w = *s + d, *t = (char *)leaf->eqkid + d;
+    node_tst *o = NULL, *nw = NULL, *sub = NULL;
+    char *str = *s;
+    size_t j = 1;
+
+    while (w[j] == t[j])            /* first char that differs */
+        j++;
+
+    if (cpy) {  /* allocate storage for 's' */
+        if (!(str = tst_str_alloc (NULL, len + 1)))
+            goto nomem;
+        memcpy (str, *s, len + 1);
+    }
+
+    o = tst_pc_word_node (t + j, (char *)leaf->eqkid, leaf->refcnt);
+    nw = tst_pc_word_node (w + j, str, 1);
+    if (!o || !nw)
+        goto nomem;
+    if (w[j] < t[j])
+        o->lokid = nw;
+    else
+        o->hikid = nw;
+
+    for (sub = o; --j;) {           /* shared chars after leaf key */
+        node_tst *node = tst_node_alloc (NULL);
+        if (!node)
+            goto nomem;
+        node->key = w[j];
+        node->refcnt = 1;
+        node->eqkid = sub;
+        sub = node;
+    }
+
+    leaf->flags = 0;
+    leaf->refcnt = 1;
+    leaf->eqkid = sub;
+
+    return str;
+
+nomem:
+    fprintf (stderr, "error: tst_pc_ins_del(), memory exhausted.\n");
+    while (sub && sub != o) {
+        node_tst *next = sub->eqkid;
+        free (sub);
+        sub = next;
+    }
+    free (o);
+    free (nw);
+    if (cpy)
+        tst_str_free (NULL, str);
+
+    return NULL;
+}
+
+/** node 'i' (0 root) on delete path 'stk'. */
+static node_tst *tst_pc_at (const tst_stack *stk, size_t i)
+{
+    return stk->data[i];
+}
+
+/** delete word at node 'victim' (refcnt zero) with path to victim in 'stk'
+ *  (nodes from root, top of stack parent of victim). victim is removed
+ *  from its sibling tree, and if one word remains below the node whose
+ *  eqkid holds the sibling tree, the chain down to that word is merged
+ *  into a leaf at the top of the chain.
+ */
+static void tst_pc_del_word (node_tst **root, node_tst *victim,
+                            const tst_stack *stk, const int freedata)
+{
+    node_tst *top, *last;
+    size_t n = stk->idx, e = n;
+
+    if (freedata)
+        tst_str_free (NULL, victim->eqkid);
+
+    /* node e - 1 is the node whose eqkid holds the sibling tree of victim */
+    while (e && tst_pc_at (stk, e - 1)->eqkid !=
+                (e < n ? tst_pc_at (stk, e) : victim))
+        e--;
+
+    tst_del_node (root, NULL, n ? tst_pc_at (stk, n - 1) : NULL, victim);
+
+    if (!e)                         /* sibling tree at root */
+        return;
+
+    top = tst_pc_at (stk, e - 1);
+    last = top->eqkid;
+    if (!last || last->lokid || last->hikid || !TST_WORD (last))
+        return;                     /* more than one word below top */
+
+    /* climb while top is the only node in its sibling tree */
+    while (e > 1 && tst_pc_at (stk, e - 2)->eqkid == top &&
+            !top->lokid && !top->hikid)
+        top = tst_pc_at (stk, --e - 1);
+
+    for (node_tst *node = top->eqkid; node != last;) {
+        node_tst *next = node->eqkid;
+        free (node);
+        node = next;
+    }
+    top->flags = TST_LEAF;
+    top->refcnt = last->refcnt;
+    top->eqkid = last->eqkid;
+    free (last);
+}
+
+static void *tst_pc_ins_del_stk (node_tst **root, char * const *s,
+                                const int del, const int cpy, tst_stack *stk);
+
+/** tst_pc_ins_del() ins/del copy or reference of 's' from path-compressed
+ *  tree at 'root', same semantics as tst_ins_del(). the unique tail of
+ *  each word is held in one leaf node rather than a node per char. the
+ *  tree must only be modified through tst_pc_ins_del(), tst_pc_search()
+ *  and tst_pc_search_prefix() are used for lookup, tst_traverse_fn(),
+ *  tst_free() and tst_free_all() handle both kinds of tree.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on allocation failure on insert, or on successful
+ *  removal of 's' from tree.
+ */
+void *tst_pc_ins_del (node_tst **root, char * const *s, const int del,
+                        const int cpy)
+{
+    tst_stack stk;
+    void *ret;
+
+    if (!root || !*s) return NULL;          /* validate parameters */
+
+    tst_stack_init (&stk);
+    ret = tst_pc_ins_del_stk (root, s, del, cpy, &stk);
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_pc_ins_del() with delete path held on 'stk', any depth of path. */
+static void *tst_pc_ins_del_stk (node_tst **root, char * const *s,
+                                const int del, const int cpy, tst_stack *stk)
+{
+    node_tst *curr, **pcurr;
+    size_t len;
+    const char *p;
+    char *str;
+
+    /* keeps the 127 char WRDMAX limit (see TST_KEYMAX) */
+    if ((len = strlen (*s)) + 1 > STKMAX / 2)
+        return NULL;
+
+    p = *s;
+    pcurr = root;
+    while ((curr = *pcurr)) {               /* iterate to insertion node */
+        int diff = *p - curr->key;
+        if (diff == 0) {
+            if (curr->flags & TST_LEAF) {   /* compare rest of tail */
+                if (strcmp (p, (char *)curr->eqkid + (p - *s)))
+                    return del ? NULL : tst_pc_split (curr, p - *s, s, len, cpy);
+                break;
+            }
+            if (*p++ == 0)                  /* word exists */
+                break;
+            pcurr = &curr->eqkid;
+        }
+        else if (diff < 0)
+            pcurr = &curr->lokid;
+        else
+            pcurr = &curr->hikid;
+        if (del && !tst_stack_push (stk, curr))
+            return NULL;                    /* path for delete */
+    }
+
+    if (curr) {                             /* word exists */
+        if (!del) {
+            curr->refcnt++;
+            return curr->eqkid;
+        }
+        if (--curr->refcnt)                 /* occurrences remain */
+            return curr->eqkid;
+        tst_pc_del_word (root, curr, stk, cpy);
+        return NULL;
+    }
+
+    if (del)                                /* not found */
+        return NULL;
+
+    str = *s;
+    if (cpy) {  /* allocate storage for 's' */
+        if (!(str = tst_str_alloc (NULL, len + 1)))
+            return NULL;
+        memcpy (str, *s, len + 1);
+    }
+    if (!(*pcurr = tst_pc_word_node (p, str, 1))) {
+        fprintf (stderr, "error: tst_pc_ins_del(), memory exhausted.\n");
+        if (cpy)
+            tst_str_free (NULL, str);
+        return NULL;
+    }
+
+    return str;
+}
+
+/** tst_pc_search(), non-recursive find of a string in path-compressed tree.
+ *  returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_pc_search (const node_tst *p, const char *s)
+{
+    const node_tst *curr = p;
+    const char *start = s;
+
+    while (curr) {
+        int diff = *s - curr->key;
+        if (diff == 0) {
+            if (curr->flags & TST_LEAF)     /* rest of 's' must match tail */
+                return strcmp (s, (char *)curr->eqkid + (s - start)) ?
+                        NULL : (void *)curr->eqkid;
+            if (*s == 0)
+                return (void *)curr->eqkid;
+            s++;
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+    return NULL;
+}
+
+/** tst_pc_search_prefix() fills ptr array 'a' with words prefixed with 's'
+ *  in path-compressed tree, as tst_search_prefix(). returns non-NULL on
+ *  success, NULL otherwise.
+ */
+void *tst_pc_search_prefix (const node_tst *root, const char *s,
+                            char **a, int *n, const int max)
+{
+    const node_tst *curr = root;
+    const char *start = s;
+    size_t nchr;
+
+    if (!*s) return NULL;
+
+    nchr = strlen (s);
+    *n = 0;
+
+    while (curr) {
+        int diff = *s - curr->key;
+        if (diff == 0) {
+            if (curr->flags & TST_LEAF) {   /* prefix ends within tail */
+                const char *t = (char *)curr->eqkid + (s - start);
+                if (strncmp (s, t, nchr - (s - start)))
+                    return NULL;
+                if (*n < max)
+                    a[(*n)++] = (char *)curr->eqkid;
+                return (void *)curr;
+            }
+            if ((size_t)(s - start) == nchr - 1) {
+                tst_suggest (curr, curr->key, nchr, a, n, max);
+                return (void *)curr;
+            }
+            s++;
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+    return NULL;
+}
@@ -0,0 +1,176 @@
+#include "ternary_st_priv.h"
+
+/** max pattern length, pattern positions held as bits of a uint64_t */
+#define PATMAX 63
+
+/** pattern search state. the pattern is run as an NFA over the chars on
+ *  the tree path, bit i of a set is pattern position i (bit m a complete
+ *  match), the set reached on the path is passed down the walk.
+ */
+typedef struct tst_pat {
+    uint64_t lit[256],      /* positions matching each char literally */
+             any,           /* positions holding '?' */
+             star,          /* positions holding '*' */
+             done;          /* bit m, complete match */
+    const char *pat;
+    char **a;               /* matching words */
+    int n, max;             /* number of words in a, max words */
+} tst_pat;
+
+/** add positions reached by '*' matching an empty run to set 's'. */
+static uint64_t tst_pat_close (const tst_pat *t, uint64_t s)
+{
+    uint64_t next;
+
+    while ((next = s | (s & t->star) << 1) != s)
+        s = next;
+
+    return s;
+}
+
+/** set reached from set 's' by tree char 'c', a position matching 'c' moves
+ *  on one, a '*' keeps its position.
+ */
+static uint64_t tst_pat_step (const tst_pat *t, const uint64_t s, const char c)
+{
+    uint64_t moved = s & (t->lit[(unsigned char)c] | t->any);
+
+    return tst_pat_close (t, moved << 1 | (s & t->star));
+}
+
+/** char wanted by set 's' if it holds a single literal position (nul for a
+ *  complete match), -1 if 's' holds a wildcard (all siblings wanted).
+ */
+static int tst_pat_literal (const tst_pat *t, const uint64_t s)
+{
+    int i = 0;
+
+    if (s & (t->any | t->star) || s & (s - 1))
+        return -1;
+    while (!(s >> i & 1))
+        i++;
+
+    return t->pat[i];
+}
+
+static void tst_pat_walk (const node_tst *p, const size_t d, uint64_t s,
+                            tst_pat *t);
+
+/** run set 's' over the chars of word 'w' from depth 'd', word added if
+ *  complete at its end.
+ */
+static void tst_pat_tail (const char *w, const size_t d, uint64_t s,
+                            tst_pat *t)
+{
+    for (size_t i = d; w[i]; i++)
+        if (!(s = tst_pat_step (t, s, w[i])))
+            return;
+    if (s & t->done && t->n < t->max)
+        t->a[t->n++] = (char *)w;
+}
+
+/** match node 'p' at depth 'd' with set 's', word added if complete,
+ *  otherwise the set is stepped by the key and eqkid walked if not empty.
+ */
+static void tst_pat_node (const node_tst *p, const size_t d, uint64_t s,
+                            tst_pat *t)
+{
+    if (!p->key) {                          /* word ends at depth d */
+        if (s & t->done && t->n < t->max)
+            t->a[t->n++] = (char *)p->eqkid;
+    }
+    else if (p->flags & TST_LEAF)           /* run tail of word in leaf */
+        tst_pat_tail ((char *)p->eqkid, d, s, t);
+    else if ((s = tst_pat_step (t, s, p->key)))
+        tst_pat_walk (p->eqkid, d + 1, s, t);
+}
+
+/** match each node of sibling tree at 'p' (depth 'd') in order, the nodes
+ *  of a wide level in key order, the tail of each word of a bucket.
+ */
+static void tst_pat_bst (const node_tst *p, const size_t d, const uint64_t s,
+                            tst_pat *t)
+{
+    if (p && p->flags & TST_WIDE) {
+        const tst_wnode *w = (const tst_wnode *)p;
+        for (unsigned i = 0; i < w->n && t->n < t->max; i++)
+            tst_pat_node (&w->ent[i], d, s, t);
+        return;
+    }
+    if (p && p->flags & TST_BUCKET) {
+        const tst_bucket *b = (const tst_bucket *)p;
+        for (unsigned i = 0; i < b->n && t->n < t->max; i++)
+            tst_pat_tail ((char *)b->ent[i].eqkid, d, s, t);
+        return;
+    }
+    for (; p && t->n < t->max; p = p->hikid) {
+        tst_pat_bst (p->lokid, d, s, t);
+        if (t->n < t->max)
+            tst_pat_node (p, d, s, t);
+    }
+}
+
+/** match sibling tree at 'p' (depth 'd') with set 's', a single literal is
+ *  found by descent as in tst_search(), a wildcard (or a wide level or
+ *  bucket, keys not matching the literal step to the empty set) visits
+ *  every sibling.
+ */
+static void tst_pat_walk (const node_tst *p, const size_t d, uint64_t s,
+                            tst_pat *t)
+{
+    int c = tst_pat_literal (t, s);
+
+    if (c < 0 || (p && p->flags & TST_LEVEL)) {
+        tst_pat_bst (p, d, s, t);
+        return;
+    }
+    while (p) {
+        int diff = (char)c - p->key;
+        if (diff == 0) {
+            tst_pat_node (p, d, s, t);
+            return;
+        }
+        p = diff < 0 ? p->lokid : p->hikid;
+    }
+}
+
+/** tst_search_pattern() fills ptr array 'a' with words matching pattern
+ *  'pat', where '?' matches any one char and '*' any run of chars (empty
+ *  included), up to 'max' words in sorted (traversal) order, updating 'n'
+ *  with the number of words in 'a'. literal chars are found by descent so
+ *  they prune the tree, only wildcards visit every sibling. 'pat' is
+ *  limited to 63 chars. returns 'a' if a word matches, NULL otherwise.
+ */
+void *tst_search_pattern (const node_tst *root, const char *pat,
+                            char **a, int *n, const int max)
+{
+    tst_pat t = { .any = 0 };
+    size_t m = strlen (pat);
+
+    *n = 0;
+    if (m > PATMAX) {
+        fprintf (stderr, "error: tst_search_pattern(), pattern exceeds %d "
+                        "chars.\n", PATMAX);
+        return NULL;
+    }
+    if (max <= 0)
+        return NULL;
+
+    for (size_t i = 0; i < m; i++) {        /* position masks for pattern */
+        if (pat[i] == '?')
+            t.any |= (uint64_t)1 << i;
+        else if (pat[i] == '*')
+            t.star |= (uint64_t)1 << i;
+        else
+            t.lit[(unsigned char)pat[i]] |= (uint64_t)1 << i;
+    }
+    t.done = (uint64_t)1 << m;
+    t.pat = pat;
+    t.a = a;
+    t.max = max;
+
+    tst_pat_walk (root, 0, tst_pat_close (&t, 1), &t);  /* start set */
+    *n = t.n;
+
+    return t.n ? (void *)a : NULL;
+}
@@ -0,0 +1,330 @@
+#include <limits.h>
+
+#include "ternary_st_priv.h"
+
+/** persistent tree handle. versions share unchanged nodes, node->share
+ *  counts the owners (parents or snapshot roots) a node has beyond one,
+ *  and an edit copies each shared node on its path before changing it.
+ */
+struct tst_pers {
+    node_tst *root;         /* current version, owned by the handle */
+    int cpy;                /* words copied (and freed with last owner) */
+};
+
+/** tst_pers_create() allocate persistent tree handle, words inserted by
+ *  copy if 'cpy' is non-zero, otherwise by reference. returns pointer to
+ *  new handle, NULL on allocation failure.
+ */
+tst_pers *tst_pers_create (const int cpy)
+{
+    tst_pers *h = calloc (1, sizeof *h);
+
+    if (!h) {
+        fprintf (stderr, "error: tst_pers_create(), memory exhausted.\n");
+        return NULL;
+    }
+    h->cpy = cpy;
+
+    return h;
+}
+
+/** node 'p' (NULL ignored) can take another owner. */
+static int tst_pers_can_share (const node_tst *p)
+{
+    return !p || p->share < USHRT_MAX;
+}
+
+/** make node at '*slot' owned by the current version alone, replacing a
+ *  shared node with a copy owning the children of the original (a copy of
+ *  the word too for 'cpy', each word node owns its word). returns the node,
+ *  NULL on failure (tree unchanged).
+ */
+static node_tst *tst_pers_own (const tst_pers *h, node_tst **slot)
+{
+    node_tst *p = *slot, *cp;
+    int word = !p->key;
+
+    if (!p->share)
+        return p;
+
+    if (!tst_pers_can_share (p->lokid) || !tst_pers_can_share (p->hikid) ||
+            (!word && !tst_pers_can_share (p->eqkid))) {
+        fprintf (stderr, "error: tst_pers_own(), node shared by %u versions.\n",
+                USHRT_MAX + 1u);
+        return NULL;
+    }
+    if (!(cp = tst_node_alloc (NULL)))
+        goto nomem;
+    *cp = *p;
+    cp->share = 0;
+    if (word && h->cpy) {
+        size_t len = strlen ((char *)p->eqkid);
+        if (!(cp->eqkid = (node_tst *)tst_str_alloc (NULL, len + 1))) {
+            tst_node_free (NULL, cp);
+            goto nomem;
+        }
+        memcpy (cp->eqkid, p->eqkid, len + 1);
+    }
+
+    if (cp->lokid)
+        cp->lokid->share++;
+    if (cp->hikid)
+        cp->hikid->share++;
+    if (!word && cp->eqkid)
+        cp->eqkid->share++;
+    p->share--;
+    *slot = cp;
+
+    return cp;
+
+nomem:
+    fprintf (stderr, "error: tst_pers_own(), memory exhausted.\n");
+    return NULL;
+}
+
+/** free node 'x' removed from the current version (children passed on),
+ *  with its word for 'cpy'.
+ */
+static void tst_pers_free_node (const tst_pers *h, node_tst *x)
+{
+    if (!x->key && h->cpy)
+        tst_str_free (NULL, x->eqkid);
+    tst_node_free (NULL, x);
+}
+
+/** unlink owned node at '*slot' (no words below its eqkid) from its sibling
+ *  tree, replaced by its child, or with two children by its successor once
+ *  the path down to the successor is owned. returns 0 on success, -1 on
+ *  failure (tree unchanged).
+ */
+static int tst_pers_unlink (const tst_pers *h, node_tst **slot)
+{
+    node_tst *x = *slot, *succ, **link = &x->hikid;
+
+    if (!x->lokid || !x->hikid) {
+        *slot = x->lokid ? x->lokid : x->hikid;
+        tst_pers_free_node (h, x);
+        return 0;
+    }
+
+    for (;;) {                              /* own path to successor */
+        if (!(succ = tst_pers_own (h, link)))
+            return -1;
+        if (!succ->lokid)
+            break;
+        link = &succ->lokid;
+    }
+    *link = succ->hikid;
+    succ->lokid = x->lokid;
+    succ->hikid = x->hikid;
+    *slot = succ;
+    tst_pers_free_node (h, x);
+
+    return 0;
+}
+
+/** slot 'i' (0 root) on path 'stk'. */
+static node_tst **tst_pers_at (const tst_stack *stk, size_t i)
+{
+    return stk->data[i];
+}
+
+/** delete word with owned terminal node at the slot on top of 'stk', 'stk'
+ *  holding the slot of each (owned) node on the path from root, as
+ *  tst_conc_del_word(). returns 0 on success, -1 if the terminal node could
+ *  not be unlinked.
+ */
+static int tst_pers_del_word (const tst_pers *h, const tst_stack *stk)
+{
+    size_t i = stk->idx - 1;
+
+    if (tst_pers_unlink (h, tst_pers_at (stk, i)))
+        return -1;
+
+    for (;;) {
+        size_t j = i;
+
+        /* slot j is the eqkid slot of the parent of the sibling tree */
+        while (j && tst_pers_at (stk, j) !=
+                    &(*tst_pers_at (stk, j - 1))->eqkid)
+            j--;
+        if (!j || (*tst_pers_at (stk, j - 1))->eqkid)   /* root, or words */
+            return 0;                                   /* below parent */
+        i = j - 1;
+        if (tst_pers_unlink (h, tst_pers_at (stk, i)))  /* empty eqkid left */
+            return 0;
+    }
+}
+
+static void *tst_pers_ins_del_stk (tst_pers *h, char * const *s,
+                                    const int del, tst_stack *stk);
+
+/** tst_pers_ins_del() ins/del 's' in the current version of persistent tree
+ *  'h', same semantics as tst_ins_del() with storage set by
+ *  tst_pers_create(). each shared node on the path of 's' is copied before
+ *  it is changed, so snapshots taken with tst_snapshot() are unaffected.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on failure on insert, or on successful removal
+ *  of 's' from tree.
+ */
+void *tst_pers_ins_del (tst_pers *h, char * const *s, const int del)
+{
+    tst_stack stk;
+    void *ret;
+
+    /* keeps the 127 char WRDMAX limit (see TST_KEYMAX) */
+    if (!*s || strlen (*s) + 1 > STKMAX / 2)
+        return NULL;
+    if (del && !tst_search (h->root, *s))   /* nothing to copy */
+        return NULL;
+
+    tst_stack_init (&stk);
+    ret = tst_pers_ins_del_stk (h, s, del, &stk);
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_pers_ins_del() with the slots on the path held on 'stk'. */
+static void *tst_pers_ins_del_stk (tst_pers *h, char * const *s,
+                                    const int del, tst_stack *stk)
+{
+    node_tst **slot = &h->root, *chain = NULL, **link;
+    const char *p = *s;
+    char *str = *s;
+
+    while (*slot) {                         /* own each node on path */
+        node_tst *curr = tst_pers_own (h, slot);
+        int diff;
+
+        if (!curr || !tst_stack_push (stk, slot))
+            return NULL;
+        diff = *p - curr->key;
+        if (diff == 0) {
+            if (*p++ == 0) {                /* word exists */
+                if (!del) {
+                    curr->refcnt++;
+                    return curr->eqkid;
+                }
+                if (--curr->refcnt)         /* occurrences remain */
+                    return curr->eqkid;
+                if (tst_pers_del_word (h, stk)) {
+                    curr->refcnt = 1;
+                    return curr->eqkid;
+                }
+                return NULL;
+            }
+            slot = &curr->eqkid;
+        }
+        else if (diff < 0)
+            slot = &curr->lokid;
+        else
+            slot = &curr->hikid;
+    }
+
+    if (h->cpy) {   /* allocate storage for 's' */
+        size_t len = strlen (*s);
+        if (!(str = tst_str_alloc (NULL, len + 1)))
+            goto nomem;
+        memcpy (str, *s, len + 1);
+    }
+    for (link = &chain;; p++) {             /* chain for rest of 's' */
+        node_tst *node = tst_node_alloc (NULL);
+        if (!node)
+            goto nomem;
+        node->key = *p;
+        node->refcnt = 1;
+        *link = node;
+        if (!*p) {
+            node->eqkid = (node_tst *)str;
+            break;
+        }
+        link = &node->eqkid;
+    }
+    *slot = chain;
+
+    return str;
+
+nomem:
+    fprintf (stderr, "error: tst_pers_ins_del(), memory exhausted.\n");
+    while (chain) {
+        node_tst *next = chain->key ? chain->eqkid : NULL;
+        tst_node_free (NULL, chain);
+        chain = next;
+    }
+    if (h->cpy)
+        tst_str_free (NULL, str);
+
+    return NULL;
+}
+
+/** tst_pers_root() returns root of the current version of 'h' for use with
+ *  the read-only functions, valid until the next tst_pers_ins_del().
+ */
+node_tst *tst_pers_root (const tst_pers *h)
+{
+    return h->root;
+}
+
+/** tst_snapshot() returns root of an immutable version of 'h' as it is now,
+ *  in O(1) (the root gains an owner, later edits copy what they change).
+ *  the snapshot is read with the read-only functions (tst_search(),
+ *  tst_search_prefix(), tst_traverse_fn(), ...) and released with
+ *  tst_snapshot_release(). returns NULL for an empty tree or if the root is
+ *  shared by USHRT_MAX + 1 versions.
+ */
+node_tst *tst_snapshot (tst_pers *h)
+{
+    if (!h->root)
+        return NULL;
+    if (h->root->share == USHRT_MAX) {
+        fprintf (stderr, "error: tst_snapshot(), root shared by %u versions.\n",
+                USHRT_MAX + 1u);
+        return NULL;
+    }
+    h->root->share++;
+
+    return h->root;
+}
+
+/** drop one owner from the tree at 'p', freeing nodes (and words for
+ *  'cpy') left without an owner.
+ */
+static void tst_pers_release (node_tst *p, const int cpy)
+{
+    while (p) {
+        node_tst *next;
+        if (p->share) {
+            p->share--;
+            return;
+        }
+        tst_pers_release (p->lokid, cpy);
+        if (p->key)
+            tst_pers_release (p->eqkid, cpy);
+        else if (cpy)
+            tst_str_free (NULL, p->eqkid);
+        next = p->hikid;
+        tst_node_free (NULL, p);
+        p = next;
+    }
+}
+
+/** tst_snapshot_release() release snapshot 'snap' of 'h', nodes no longer
+ *  used by any version are freed.
+ */
+void tst_snapshot_release (tst_pers *h, node_tst *snap)
+{
+    tst_pers_release (snap, h->cpy);
+}
+
+/** tst_pers_destroy() release the current version of 'h' and free the
+ *  handle (snapshots must be released first).
+ */
+void tst_pers_destroy (tst_pers *h)
+{
+    if (!h)
+        return;
+
+    tst_pers_release (h->root, h->cpy);
+    free (h);
+}
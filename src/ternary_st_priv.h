@@ -0,0 +1,209 @@
+#ifndef _tst_search_tree_priv_h_
+#define _tst_search_tree_priv_h_  1
+
+#include <stdint.h>
+
+#include "ternary_st.h"
+
+/** max word length (+1) of the fixed path stacks of tst_pc_ins_del(),
+ *  tst_cpt_ins_del(), tst_conc_ins_del() and tst_pers_ins_del(), stack size
+ */
+#define WRDMAX 128
+#define STKMAX (WRDMAX * 2)
+
+/** longest tree path, a key byte 0 or 0x01 is two chars (tst_ins_del_len()) */
+#define TST_PATHMAX (2 * TST_KEYMAX)
+
+/** ternary search tree node. */
+typedef struct node_tst {
+    char key;               /* char key for node (null for node with string) */
+    unsigned char flags;    /* node kind, TST_LEAF for compressed word tail */
+    unsigned short share;   /* added owners of node shared between versions
+                               of a persistent tree (0 single owner) */
+    unsigned refcnt;        /* refcnt tracks occurrence of word (for delete),
+                               1 otherwise (subtree max in top-k trees) */
+    struct node_tst *lokid, /* ternary low child pointer */
+                    *eqkid, /* ternary equal child pointer */
+                    *hikid; /* ternary high child pointer */
+} node_tst;
+
+/** node flags. a TST_LEAF node (path-compressed tree) holds the unique
+ *  tail of a word, its key is the first char of the tail and eqkid the
+ *  string (the rest of the tail is read from the string).
+ */
+#define TST_LEAF 0x01
+
+/** node flags. a TST_WIDE node (wide tree) heads a sibling level held as
+ *  a sorted array of keys and a node per key, in place of the lo/hi tree
+ *  (see tst_wnode). checked before TST_WORD(), the header holds no word.
+ */
+#define TST_WIDE 0x02
+
+/** node flags. a TST_BUCKET node (burst tree) holds every word below one
+ *  prefix in a sorted container in place of the nodes for the words (see
+ *  tst_bucket). checked before TST_WORD(), the header holds no word.
+ */
+#define TST_BUCKET 0x04
+
+/** node flags of a node heading a level in place of a lo/hi tree */
+#define TST_LEVEL (TST_WIDE | TST_BUCKET)
+
+/** node 'n' holds a word (string in eqkid), nul key or compressed leaf */
+#define TST_WORD(n) (!(n)->key || ((n)->flags & TST_LEAF))
+
+/** wide sibling level. the node for each key (lokid and hikid NULL) is
+ *  held in key order in 'ent', and the keys alone in 'key', padded with
+ *  CHAR_MAX (never less than a key) to 'max', a multiple of the vector
+ *  width, so the key array is searched in whole vector blocks.
+ */
+typedef struct tst_wnode {
+    node_tst hdr;           /* flags TST_WIDE, key non-nul, links unused */
+    node_tst *ent;          /* node for each key, in key order */
+    unsigned n,             /* keys held */
+             max;           /* keys allocated */
+    char key[];             /* keys in char order, CHAR_MAX past 'n' */
+} tst_wnode;
+
+/** burst bucket. the words below one prefix, the word node (key nul) of
+ *  each held in 'ent' and the suffix of each past the prefix held in 'sfx',
+ *  both in key order, so a lookup is one linear scan of 'sfx'.
+ */
+typedef struct tst_bucket {
+    node_tst hdr;           /* flags TST_BUCKET, key non-nul, links unused */
+    node_tst *ent;          /* word node for each word, in key order */
+    char *sfx;              /* nul-terminated suffix of each word in order */
+    unsigned n,             /* words held */
+             max;           /* word nodes allocated */
+    size_t len,             /* bytes of 'sfx' used */
+           size;            /* bytes of 'sfx' allocated */
+} tst_bucket;
+
+/** word node of a map, the value held after the node (see tst_map_put()).
+ *  nodes are relinked, never copied, so the value does not move.
+ */
+typedef struct tst_mnode {
+    node_tst node;
+    tst_value val;
+} tst_mnode;
+
+/** max refcnt held in 24 bits of compact node */
+#define CREFMAX 0xffffffu
+
+/** compact ternary search tree node, 16 bytes. children are indexes into
+ *  a node pool (0 is nil). for the node with key nul, eqkid is the index
+ *  (or offset) of the string. used by compact and frozen trees.
+ */
+typedef struct cnode_tst {
+    uint32_t lokid,         /* ternary low child index */
+             eqkid,         /* ternary equal child (or string) index */
+             hikid;         /* ternary high child index */
+    unsigned refcnt : 24,   /* refcnt tracks occurrence of word (for delete) */
+             key : 8;       /* char key for node (stored as unsigned char) */
+} cnode_tst;
+
+/** char key of compact node 'n' */
+#define CKEY(n) ((char)(n)->key)
+
+/** arena internals used by tree code, node and string storage carved from
+ *  slabs owned by the arena. (see ternary_st_arena.c)
+ */
+node_tst *tst_arena_node (tst_arena *a);
+void tst_arena_node_free (tst_arena *a, node_tst *node);
+char *tst_arena_str (tst_arena *a, size_t size);
+
+/** node and string storage, from arena 'a' if given, otherwise from the
+ *  heap. nodes are returned zeroed.
+ */
+static inline node_tst *tst_node_alloc (tst_arena *a)
+{
+    return a ? tst_arena_node (a) : calloc (1, sizeof (node_tst));
+}
+
+static inline void tst_node_free (tst_arena *a, node_tst *node)
+{
+    if (a)
+        tst_arena_node_free (a, node);
+    else
+        free (node);
+}
+
+static inline char *tst_str_alloc (tst_arena *a, size_t size)
+{
+    return a ? tst_arena_str (a, size) : malloc (size);
+}
+
+/** string storage in an arena is only released with the arena. */
+static inline void tst_str_free (tst_arena *a, void *str)
+{
+    if (!a)
+        free (str);
+}
+
+/** tst_ins_del_a() tst_ins_del() with node storage from arena 'a', (calloc
+ *  and free are used for node and string storage if 'a' is NULL).
+ */
+void *tst_ins_del_a (node_tst **root, tst_arena *a, char * const *s,
+                        const int del, const int cpy);
+
+/** tst_suggest() fill ptr array 'a' with words below node 'p' with 'c' as
+ *  char 'nchr' (see tst_search_prefix()).
+ */
+void tst_suggest (const node_tst *p, const char c, const size_t nchr,
+                    char **a, int *n, const int max);
+
+/** subtree max, in a top-k tree the refcnt of a node not holding a word is
+ *  the max refcnt of the words below its eqkid (see tst_topk_ins_del(),
+ *  tst_topk_index()). tst_bst_max() returns max refcnt of the nodes in
+ *  sibling tree at 'p'.
+ */
+unsigned tst_bst_max (const node_tst *p);
+
+/** stack of node pointers on the path to a word, STKMAX slots held in the
+ *  struct and moved to the heap (doubling) for longer paths, so words of
+ *  any length can be deleted. tst_stack_init() before use, tst_stack_free()
+ *  after (the struct must not be copied).
+ */
+typedef struct tst_stack {
+    void **data;            /* slots, buf or heap */
+    size_t idx,             /* slots in use */
+           max;             /* slots available */
+    void *buf[STKMAX];
+} tst_stack;
+
+void tst_stack_init (tst_stack *s);
+int tst_stack_reserve (tst_stack *s, const size_t n);
+void *tst_stack_push (tst_stack *s, void *node);
+void *tst_stack_pop (tst_stack *s);
+void tst_stack_free (tst_stack *s);
+
+/** tst_del_word() remove word at terminal 'node' with refcnt already
+ *  decremented, 'stk' holding each node on the path from root. returns
+ *  NULL on removal, 'node' if occurrences remain.
+ */
+void *tst_del_word (node_tst **root, tst_arena *a, node_tst *node,
+                    tst_stack *stk, const int freedata);
+
+/** escape char for length-delimited keys. a key byte 0 is held on the tree
+ *  path as TST_ESC, 1 and a key byte TST_ESC as TST_ESC, 2 so the nul key
+ *  still ends every word, other bytes are held as is (see ternary_st_len.c).
+ */
+#define TST_ESC 0x01
+
+/** tst_del_node() remove 'victim' from the lo/hi tree of its siblings,
+ *  'parent' is the node linking to victim (NULL if root).
+ */
+void tst_del_node (node_tst **root, tst_arena *a, node_tst *parent,
+                    node_tst *victim);
+
+/** TST_COUNT() count event 'f' (calls, nodes, cmps) of operation 'op'
+ *  (search, prefix, insdel) in the counters of the calling thread when
+ *  built with -DTST_STATS, no code otherwise (see tst_counters_get()).
+ */
+#ifdef TST_STATS
+extern _Thread_local tst_counters_t tst_ctr;
+#define TST_COUNT(op, f) (tst_ctr.op.f++)
+#else
+#define TST_COUNT(op, f) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200112L     /* for pthread_rwlock_t */
+
+#include <limits.h>
+#include <pthread.h>
+
+#include "ternary_st_priv.h"
+
+/** number of shards, one per first byte */
+#define NSHARD 256
+
+/** sharded tree handle. words are held in the ordinary tree for their first
+ *  byte, so the top-level sibling tree of each shard is the one node for
+ *  that byte and a search starts with an index rather than a walk over
+ *  every first char. each shard has its own reader/writer lock, readers of
+ *  a shard share it, a writer holds it alone.
+ */
+struct tst_shard {
+    node_tst *root[NSHARD];
+    pthread_rwlock_t lock[NSHARD];
+};
+
+/** shard for string 's' */
+#define SHARD(s) ((unsigned char)*(s))
+
+/** tst_shard_create() allocate sharded tree handle.
+ *  returns pointer to new handle, NULL on failure.
+ */
+tst_shard *tst_shard_create (void)
+{
+    tst_shard *t = calloc (1, sizeof *t);
+
+    if (!t) {
+        fprintf (stderr, "error: tst_shard_create(), memory exhausted.\n");
+        return NULL;
+    }
+    for (int i = 0; i < NSHARD; i++)
+        if (pthread_rwlock_init (&t->lock[i], NULL)) {
+            fprintf (stderr, "error: tst_shard_create(), "
+                            "pthread_rwlock_init failed.\n");
+            while (i--)
+                pthread_rwlock_destroy (&t->lock[i]);
+            free (t);
+            return NULL;
+        }
+
+    return t;
+}
+
+/** tst_shard_ins_del() tst_ins_del() 's' in the shard for its first byte,
+ *  holding the lock of that shard only (exclusive), so writers of words
+ *  with different first bytes do not block each other. returns as
+ *  tst_ins_del().
+ */
+void *tst_shard_ins_del (tst_shard *t, char * const *s, const int del,
+                        const int cpy)
+{
+    void *ret;
+    int i;
+
+    if (!*s)
+        return NULL;
+
+    i = SHARD (*s);
+    pthread_rwlock_wrlock (&t->lock[i]);
+    ret = tst_ins_del (&t->root[i], s, del, cpy);
+    pthread_rwlock_unlock (&t->lock[i]);
+
+    return ret;
+}
+
+/** tst_shard_search() tst_search() for 's' in the shard for its first
+ *  byte, holding the lock of that shard shared with other readers. a word
+ *  stored by copy is only valid while no other thread deletes it. returns
+ *  pointer to 's' on success, NULL otherwise.
+ */
+void *tst_shard_search (tst_shard *t, const char *s)
+{
+    void *ret;
+    int i = SHARD (s);
+
+    pthread_rwlock_rdlock (&t->lock[i]);
+    ret = tst_search (t->root[i], s);
+    pthread_rwlock_unlock (&t->lock[i]);
+
+    return ret;
+}
+
+/** tst_shard_search_prefix() tst_search_prefix() for 's' in the shard for
+ *  its first byte, holding the lock shared as tst_shard_search(). returns
+ *  non-NULL on success, NULL otherwise.
+ */
+void *tst_shard_search_prefix (tst_shard *t, const char *s,
+                                char **a, int *n, const int max)
+{
+    void *ret;
+    int i = SHARD (s);
+
+    *n = 0;
+    if (!*s) return NULL;
+
+    pthread_rwlock_rdlock (&t->lock[i]);
+    ret = tst_search_prefix (t->root[i], s, a, n, max);
+    pthread_rwlock_unlock (&t->lock[i]);
+
+    return ret;
+}
+
+/** tst_shard_traverse_fn() tst_traverse_fn() each shard in turn, holding
+ *  the lock of the shard being traversed (shared). shards are visited in signed
+ *  char order of their byte, so words are in the same order as for one
+ *  tree.
+ */
+void tst_shard_traverse_fn (tst_shard *t, void (fn)(const void *, void *),
+                            void *data)
+{
+    for (int c = CHAR_MIN; c <= CHAR_MAX; c++) {
+        int i = (unsigned char)c;
+        pthread_rwlock_rdlock (&t->lock[i]);
+        tst_traverse_fn (t->root[i], fn, data);
+        pthread_rwlock_unlock (&t->lock[i]);
+    }
+}
+
+/** tst_shard_destroy() free all shards, words stored by copy as well if
+ *  'freedata' is non-zero (tst_free_all()), then the handle.
+ */
+void tst_shard_destroy (tst_shard *t, const int freedata)
+{
+    if (!t)
+        return;
+
+    for (int i = 0; i < NSHARD; i++) {
+        if (freedata)
+            tst_free_all (t->root[i]);
+        else
+            tst_free (t->root[i]);
+        pthread_rwlock_destroy (&t->lock[i]);
+    }
+    free (t);
+}
@@ -0,0 +1,200 @@
+#include "ternary_st_priv.h"
+
+#ifdef TST_STATS
+/** hot-path counters of the calling thread (see TST_COUNT) */
+_Thread_local tst_counters_t tst_ctr;
+#endif
+
+/** bucket of histogram for 'v', values past the last bucket in the last. */
+static size_t tst_stats_bucket (const size_t v)
+{
+    return v < TST_HISTMAX ? v : TST_HISTMAX - 1;
+}
+
+/** sibling trees still to add to the statistics, so a key of any length
+ *  is walked without recursing once per char. 'err' set on allocation
+ *  failure.
+ */
+typedef struct tst_stats_todo {
+    struct tst_stats_sib {
+        const node_tst *p;
+        size_t d, cmps;
+    } *a;
+    size_t n, max;
+    int err;
+} tst_stats_todo;
+
+/** add sibling tree at 'p' to 'todo', returns 0 on success, -1 otherwise. */
+static int tst_stats_push (tst_stats_todo *todo, const node_tst *p,
+                            const size_t d, const size_t cmps)
+{
+    if (todo->n == todo->max) {
+        size_t max = todo->max ? todo->max * 2 : STKMAX;
+        void *tmp = realloc (todo->a, max * sizeof *todo->a);
+        if (!tmp) {
+            fprintf (stderr, "tst_stats() error: memory exhausted.\n");
+            todo->err = 1;
+            return -1;
+        }
+        todo->a = tmp;
+        todo->max = max;
+    }
+    todo->a[todo->n++] = (struct tst_stats_sib){ p, d, cmps };
+
+    return 0;
+}
+
+/** add node 'p' (and the lo/hi nodes below it) to 'st', 'd' eqkid links
+ *  from root, 'cmps' nodes compared on the search path before 'p'. the
+ *  sibling trees below are added to 'todo'. returns height of the lo/hi
+ *  tree below 'p' (1 for 'p' alone).
+ */
+static size_t tst_stats_node (const node_tst *p, const size_t d, size_t cmps,
+                                tst_stats_t *st, tst_stats_todo *todo)
+{
+    size_t lo, hi;
+
+    if (!p)
+        return 0;
+
+    cmps++;
+    st->nodes++;
+    if (TST_WORD (p)) {
+        const char *w = (char *)p->eqkid;
+        st->words++;
+        st->eq_depth[tst_stats_bucket (d)]++;
+        st->avg_cmps += cmps;
+        if (d > st->depth_max)
+            st->depth_max = d;
+        if (cmps > st->worst_cmps) {
+            st->worst_cmps = cmps;
+            st->worst = w;
+        }
+        if (w)                              /* not keyless */
+            st->str_bytes += strlen (w) + 1;
+    }
+    else if (p->eqkid)
+        tst_stats_push (todo, p->eqkid, d + 1, cmps);
+
+    lo = tst_stats_node (p->lokid, d, cmps, st, todo);
+    hi = tst_stats_node (p->hikid, d, cmps, st, todo);
+
+    return 1 + (lo > hi ? lo : hi);
+}
+
+/** add sibling tree at 'p' to 'st' (see tst_stats_node()). a wide level
+ *  is a sibling tree of height 1, one compare for any of its nodes, and a
+ *  bucket one of height 1 scanned linearly.
+ */
+static void tst_stats_sib (const node_tst *p, const size_t d,
+                            const size_t cmps, tst_stats_t *st,
+                            tst_stats_todo *todo)
+{
+    size_t h = 1;
+
+    if (p->flags & TST_WIDE) {
+        const tst_wnode *w = (const tst_wnode *)p;
+        st->wide++;
+        st->node_bytes += sizeof *w + w->max +
+                            (w->max - w->n) * sizeof *w->ent;
+        for (unsigned i = 0; i < w->n; i++)
+            tst_stats_node (&w->ent[i], d, cmps, st, todo);
+    }
+    else if (p->flags & TST_BUCKET) {       /* word i found on i + 1 compares */
+        const tst_bucket *b = (const tst_bucket *)p;
+        const char *sfx = b->sfx;
+        st->buckets++;
+        st->node_bytes += sizeof *b + b->size +
+                            (b->max - b->n) * sizeof *b->ent;
+        for (unsigned i = 0; i < b->n; sfx += strlen (sfx) + 1, i++)
+            tst_stats_node (&b->ent[i], d + strlen (sfx), cmps + i, st, todo);
+    }
+    else
+        h = tst_stats_node (p, d, cmps, st, todo);
+    st->sibtrees++;
+    st->sib_height[tst_stats_bucket (h)]++;
+    if (h > st->sib_max)
+        st->sib_max = h;
+}
+
+/** tst_stats() fill 'st' with the statistics of tree at 'root' (plain,
+ *  path-compressed, keyless, wide or burst): node and word counts, bytes
+ *  of nodes and of the words held (the caller's for a tree by reference),
+ *  the number of words at each eqkid depth (key length), the number of
+ *  lo/hi sibling trees of each height, and the worst-case search path, the
+ *  most nodes compared to reach a word, with the word (NULL if keyless).
+ *  avg_cmps is the mean nodes compared per word. returns 'st', NULL on
+ *  allocation failure.
+ */
+tst_stats_t *tst_stats (const node_tst *root, tst_stats_t *st)
+{
+    tst_stats_todo todo = { .a = NULL };
+
+    memset (st, 0, sizeof *st);
+
+    if (root)
+        tst_stats_push (&todo, root, 0, 0);
+    while (todo.n && !todo.err) {
+        struct tst_stats_sib sib = todo.a[--todo.n];
+        tst_stats_sib (sib.p, sib.d, sib.cmps, st, &todo);
+    }
+    free (todo.a);
+    if (todo.err)
+        return NULL;
+
+    st->node_bytes += st->nodes * sizeof (node_tst);
+    if (st->words)
+        st->avg_cmps /= st->words;
+
+    return st;
+}
+
+/** print histogram 'h' of 'name', buckets up to the last non-zero. */
+static void tst_stats_hist (FILE *fp, const char *name, const size_t *h)
+{
+    int last = TST_HISTMAX - 1;
+
+    while (last > 0 && !h[last])
+        last--;
+    fprintf (fp, "%-14s", name);
+    for (int i = 0; i <= last; i++)
+        fprintf (fp, " %zu%s", h[i], i == TST_HISTMAX - 1 ? "+" : "");
+    fputc ('\n', fp);
+}
+
+/** tst_stats_print() print statistics 'st' from tst_stats() to 'fp'. */
+void tst_stats_print (const tst_stats_t *st, FILE *fp)
+{
+    fprintf (fp, "nodes          %zu (%zu bytes)\n"
+                "words          %zu (%zu bytes)\n"
+                "sibling trees  %zu, tallest %zu, %zu wide, %zu buckets\n"
+                "longest key    %zu\n"
+                "worst path     %zu nodes '%s'\n"
+                "mean path      %.2f nodes\n",
+            st->nodes, st->node_bytes, st->words, st->str_bytes,
+            st->sibtrees, st->sib_max, st->wide, st->buckets,
+            st->depth_max, st->worst_cmps,
+            st->worst ? st->worst : "", st->avg_cmps);
+    tst_stats_hist (fp, "eqkid depth", st->eq_depth);
+    tst_stats_hist (fp, "sibling height", st->sib_height);
+}
+
+/** tst_counters_get() copy hot-path counters of the calling thread to 'c',
+ *  all zero unless the library is built with -DTST_STATS.
+ */
+void tst_counters_get (tst_counters_t *c)
+{
+#ifdef TST_STATS
+    *c = tst_ctr;
+#else
+    memset (c, 0, sizeof *c);
+#endif
+}
+
+/** tst_counters_reset() zero hot-path counters of the calling thread. */
+void tst_counters_reset (void)
+{
+#ifdef TST_STATS
+    memset (&tst_ctr, 0, sizeof tst_ctr);
+#endif
+}
@@ -0,0 +1,190 @@
+#include "ternary_st_priv.h"
+
+/** initial heap size (nodes), doubled as required */
+#define HEAPSZ 256
+
+/** max-heap of nodes by refcnt, word count for a word node, max refcnt of
+ *  the words below eqkid (subtree max) for any other node.
+ */
+typedef struct tst_heap {
+    const node_tst **nodes;
+    size_t n, max;
+} tst_heap;
+
+/** node 'a' is popped before 'b', larger refcnt first and a word before a
+ *  subtree with the same refcnt (the subtree cannot hold a larger word).
+ */
+static int tst_heap_before (const node_tst *a, const node_tst *b)
+{
+    if (a->refcnt != b->refcnt)
+        return a->refcnt > b->refcnt;
+
+    return TST_WORD (a) && !TST_WORD (b);
+}
+
+/** push 'node' on heap 'h'. returns 0 on success, -1 on allocation failure. */
+static int tst_heap_push (tst_heap *h, const node_tst *node)
+{
+    size_t i;
+
+    if (h->n == h->max) {
+        size_t max = h->max ? h->max * 2 : HEAPSZ;
+        void *tmp = realloc (h->nodes, max * sizeof *h->nodes);
+        if (!tmp) {
+            fprintf (stderr, "error: tst_heap_push(), memory exhausted.\n");
+            return -1;
+        }
+        h->nodes = tmp;
+        h->max = max;
+    }
+
+    for (i = h->n++; i; i = (i - 1) / 2) {  /* sift up */
+        const node_tst *parent = h->nodes[(i - 1) / 2];
+        if (!tst_heap_before (node, parent))
+            break;
+        h->nodes[i] = parent;
+    }
+    h->nodes[i] = node;
+
+    return 0;
+}
+
+/** pop node with largest refcnt from heap 'h' (not empty). */
+static const node_tst *tst_heap_pop (tst_heap *h)
+{
+    const node_tst *top = h->nodes[0], *last = h->nodes[--h->n];
+    size_t i = 0, c;
+
+    while ((c = 2 * i + 1) < h->n) {        /* sift down */
+        if (c + 1 < h->n && tst_heap_before (h->nodes[c + 1], h->nodes[c]))
+            c++;
+        if (!tst_heap_before (h->nodes[c], last))
+            break;
+        h->nodes[i] = h->nodes[c];
+        i = c;
+    }
+    h->nodes[i] = last;
+
+    return top;
+}
+
+/** push each node of sibling tree at 'p' on heap 'h'. returns 0 on success,
+ *  -1 on allocation failure or for a wide level or bucket (no subtree max).
+ */
+static int tst_heap_push_bst (tst_heap *h, const node_tst *p)
+{
+    if (p && p->flags & TST_LEVEL) {
+        fprintf (stderr, "error: tst_topk_prefix(), wide or burst tree.\n");
+        return -1;
+    }
+    for (; p; p = p->hikid)
+        if (tst_heap_push_bst (h, p->lokid) || tst_heap_push (h, p))
+            return -1;
+
+    return 0;
+}
+
+/** tst_topk_index() set the subtree max of each node not holding a word in
+ *  tree at 'root', bottom-up, non-recursive. the nodes are listed with each
+ *  node before the nodes below its eqkid, then set in reverse order.
+ *  returns 0 on success, -1 on allocation failure or for a wide level or
+ *  bucket.
+ */
+int tst_topk_index (node_tst *root)
+{
+    tst_stack stk, order;
+    node_tst *p;
+    int ret = 0;
+
+    tst_stack_init (&stk);
+    tst_stack_init (&order);
+    if (root && !tst_stack_push (&stk, root))
+        ret = -1;
+    while (!ret && (p = tst_stack_pop (&stk))) {
+        if (p->flags & TST_LEVEL) {
+            fprintf (stderr, "error: tst_topk_index(), wide or burst tree.\n");
+            ret = -1;
+            break;
+        }
+        if ((p->lokid && !tst_stack_push (&stk, p->lokid)) ||
+                (p->hikid && !tst_stack_push (&stk, p->hikid)))
+            ret = -1;
+        else if (!TST_WORD (p) && (!tst_stack_push (&order, p) ||
+                    (p->eqkid && !tst_stack_push (&stk, p->eqkid))))
+            ret = -1;
+    }
+    if (!ret)
+        while ((p = tst_stack_pop (&order)))
+            p->refcnt = tst_bst_max (p->eqkid);
+    tst_stack_free (&order);
+    tst_stack_free (&stk);
+
+    return ret;
+}
+
+/** tst_topk_prefix() fills ptr array 'a' with the (up to) 'k' words with the
+ *  largest refcnt prefixed with 's' (all words if 's' is empty), largest
+ *  first, updating 'n' with the number of words in 'a'. best-first search
+ *  on the subtree max held by each node (tree kept by tst_topk_ins_del()
+ *  or indexed by tst_topk_index()), a subtree is only entered when its
+ *  max can place a word in the top 'k', so a short prefix does not
+ *  enumerate all matches. returns pointer to the node for the prefix on
+ *  success, NULL if not found, on allocation failure or for a wide or
+ *  burst tree (see tst_wide_ins_del()).
+ */
+void *tst_topk_prefix (const node_tst *root, const char *s,
+                        char **a, int *n, const int k)
+{
+    const node_tst *curr = root, *node = root;
+    const char *start = s;
+    tst_heap h = { .nodes = NULL, .n = 0, .max = 0 };
+
+    *n = 0;
+
+    while (curr && *s) {                    /* node for last prefix char */
+        int diff = *s - curr->key;
+        if (curr->flags & TST_LEVEL) {
+            fprintf (stderr, "error: tst_topk_prefix(), wide or burst tree.\n");
+            return NULL;
+        }
+        if (diff == 0) {
+            node = curr;
+            if (curr->flags & TST_LEAF) {   /* prefix ends within tail */
+                const char *word = (char *)curr->eqkid;
+                if (strncmp (s, word + (s - start), strlen (s)))
+                    return NULL;
+                if (k > 0)
+                    a[(*n)++] = (char *)word;
+                return (void *)curr;
+            }
+            s++;
+            curr = curr->eqkid;
+        }
+        else if (diff < 0)
+            curr = curr->lokid;
+        else
+            curr = curr->hikid;
+    }
+    if (!curr || *s)
+        return NULL;
+
+    if (tst_heap_push_bst (&h, curr))
+        goto nomem;
+
+    while (h.n && *n < k) {
+        const node_tst *p = tst_heap_pop (&h);
+        if (TST_WORD (p))                   /* no word left can exceed p */
+            a[(*n)++] = (char *)p->eqkid;
+        else if (tst_heap_push_bst (&h, p->eqkid))
+            goto nomem;
+    }
+    free (h.nodes);
+
+    return (void *)node;
+
+nomem:
+    free (h.nodes);
+    *n = 0;
+
+    return NULL;
+}
@@ -0,0 +1,563 @@
+#include <limits.h>
+
+#if (defined(__AVX2__) || defined(__SSE2__)) && CHAR_MIN < 0
+#include <immintrin.h>
+#endif
+
+#include "ternary_st_priv.h"
+
+/** wide tree. a plain tree in which each sibling level (the lo/hi tree
+ *  under one eqkid) of 'min' or more nodes is replaced by a TST_WIDE node,
+ *  the keys of the level in a sorted array searched a vector at a time
+ *  with AVX2 or SSE2 (scalar otherwise) and the nodes of the level in an
+ *  array in the same order. one compare over the key block replaces the
+ *  walk of a lo/hi tree with a cache miss per node. a level is widened when
+ *  an insert brings it to 'min' nodes and narrowed back to a balanced lo/hi
+ *  tree when a delete leaves it under 'min / 2'.
+ */
+
+/** key capacity of a wide node is a multiple of WIDEBLK (the AVX2 width) */
+#define WIDEBLK 32
+
+/** delete path, one step per char of the word. */
+typedef struct tst_wstep {
+    node_tst **top,         /* slot holding the level of the step */
+             **slot;        /* slot holding node in lo/hi level (or NULL) */
+    node_tst *node;         /* node matched at the level */
+} tst_wstep;
+
+/** number of keys in wide node 'w' less than 'c', the index of 'c' if
+ *  held. keys are compared a block at a time (signed byte compare, char
+ *  order when char is signed), stopping at the first block holding a key
+ *  not less than 'c'.
+ */
+static inline unsigned tst_wide_rank (const tst_wnode *w, const char c)
+{
+    unsigned r = 0;
+#if defined(__AVX2__) && CHAR_MIN < 0
+    const __m256i v = _mm256_set1_epi8 (c);
+
+    for (unsigned i = 0; i < w->n; i += 32) {
+        __m256i k = _mm256_loadu_si256 ((const __m256i *)(w->key + i));
+        unsigned m = (unsigned)_mm256_movemask_epi8 (_mm256_cmpgt_epi8 (v, k));
+        r += __builtin_popcount (m);
+        if (m != 0xffffffffu)
+            break;
+    }
+#elif defined(__SSE2__) && CHAR_MIN < 0
+    const __m128i v = _mm_set1_epi8 (c);
+
+    for (unsigned i = 0; i < w->n; i += 16) {
+        __m128i k = _mm_loadu_si128 ((const __m128i *)(w->key + i));
+        unsigned m = (unsigned)_mm_movemask_epi8 (_mm_cmplt_epi8 (k, v));
+        r += __builtin_popcount (m);
+        if (m != 0xffffu)
+            break;
+    }
+#else
+    while (r < w->n && w->key[r] < c)
+        r++;
+#endif
+    return r;
+}
+
+/** allocate wide node for 'n' keys, keys padded. returns pointer to node,
+ *  NULL on failure.
+ */
+static tst_wnode *tst_wide_alloc (const unsigned n)
+{
+    unsigned max = (n + WIDEBLK - 1) / WIDEBLK * WIDEBLK;
+    tst_wnode *w = malloc (sizeof *w + max);
+
+    if (!w || !(w->ent = malloc (max * sizeof *w->ent))) {
+        fprintf (stderr, "error: tst_wide_alloc(), memory exhausted.\n");
+        free (w);
+        return NULL;
+    }
+    memset (&w->hdr, 0, sizeof w->hdr);
+    w->hdr.key = CHAR_MAX;
+    w->hdr.flags = TST_WIDE;
+    w->n = 0;
+    w->max = max;
+    memset (w->key, CHAR_MAX, max);
+
+    return w;
+}
+
+/** make room for one more key in wide node at '*top', moving the node if
+ *  it must grow. returns pointer to node, NULL on failure (node unchanged).
+ */
+static tst_wnode *tst_wide_grow (node_tst **top)
+{
+    tst_wnode *w = (tst_wnode *)*top, *nw;
+    unsigned max = w->max + WIDEBLK;
+    node_tst *ent;
+
+    if (w->n < w->max)
+        return w;
+
+    if (!(ent = realloc (w->ent, max * sizeof *ent)))
+        goto nomem;
+    w->ent = ent;
+    if (!(nw = realloc (w, sizeof *w + max)))
+        goto nomem;
+    memset (nw->key + nw->max, CHAR_MAX, max - nw->max);
+    nw->max = max;
+    *top = &nw->hdr;
+
+    return nw;
+
+nomem:
+    fprintf (stderr, "error: tst_wide_grow(), memory exhausted.\n");
+    return NULL;
+}
+
+/** number of nodes in lo/hi tree at 'p'. */
+static unsigned tst_wide_count (const node_tst *p)
+{
+    unsigned n = 0;
+
+    for (; p; p = p->hikid)
+        n += 1 + tst_wide_count (p->lokid);
+
+    return n;
+}
+
+/** move the nodes of lo/hi tree at 'p' to the end of wide node 'w' in
+ *  order, freeing them.
+ */
+static void tst_wide_fill (node_tst *p, tst_wnode *w)
+{
+    while (p) {
+        node_tst *next = p->hikid;
+        tst_wide_fill (p->lokid, w);
+        w->key[w->n] = p->key;
+        w->ent[w->n] = *p;
+        w->ent[w->n].lokid = w->ent[w->n].hikid = NULL;
+        w->n++;
+        tst_node_free (NULL, p);
+        p = next;
+    }
+}
+
+/** replace lo/hi level at '*top' by a wide node. returns 0 on success, -1
+ *  on failure (level unchanged).
+ */
+static int tst_wide_widen (node_tst **top)
+{
+    tst_wnode *w = tst_wide_alloc (tst_wide_count (*top));
+
+    if (!w)
+        return -1;
+    tst_wide_fill (*top, w);
+    *top = &w->hdr;
+
+    return 0;
+}
+
+/** balanced lo/hi tree of nodes 'nodes' [lo, hi) holding 'ent' [lo, hi). */
+static node_tst *tst_wide_bst (node_tst **nodes, const node_tst *ent,
+                                const unsigned lo, const unsigned hi)
+{
+    unsigned mid = lo + (hi - lo) / 2;
+    node_tst *p;
+
+    if (lo == hi)
+        return NULL;
+    p = nodes[mid];
+    *p = ent[mid];
+    p->lokid = tst_wide_bst (nodes, ent, lo, mid);
+    p->hikid = tst_wide_bst (nodes, ent, mid + 1, hi);
+
+    return p;
+}
+
+/** replace wide node at '*top' by a balanced lo/hi level. returns 0 on
+ *  success, -1 on failure (level unchanged).
+ */
+static int tst_wide_narrow (node_tst **top)
+{
+    tst_wnode *w = (tst_wnode *)*top;
+    node_tst *nodes[UCHAR_MAX + 1];
+
+    for (unsigned i = 0; i < w->n; i++)
+        if (!(nodes[i] = tst_node_alloc (NULL))) {
+            while (i--)
+                tst_node_free (NULL, nodes[i]);
+            fprintf (stderr, "error: tst_wide_narrow(), memory exhausted.\n");
+            return -1;
+        }
+    *top = tst_wide_bst (nodes, w->ent, 0, w->n);
+    free (w->ent);
+    free (w);
+
+    return 0;
+}
+
+/** chain of nodes for the chars at 'p' ending in the node with key nul
+ *  holding 'str'. returns top of chain, NULL on failure.
+ */
+static node_tst *tst_wide_chain (const char *p, char *str)
+{
+    node_tst *top = NULL, **link = &top;
+
+    for (;; p++) {
+        node_tst *node = tst_node_alloc (NULL);
+        if (!node) {
+            fprintf (stderr, "error: tst_wide_ins_del(), memory exhausted.\n");
+            while (top) {
+                node_tst *next = top->eqkid;
+                tst_node_free (NULL, top);
+                top = next;
+            }
+            return NULL;
+        }
+        node->key = *p;
+        node->refcnt = 1;
+        *link = node;
+        if (!*p) {
+            node->eqkid = (node_tst *)str;
+            return top;
+        }
+        link = &node->eqkid;
+    }
+}
+
+/** storage for word 's' of length 'len', a copy for 'cpy'. */
+static char *tst_wide_str (char * const *s, const size_t len, const int cpy)
+{
+    char *str = *s;
+
+    if (cpy) {
+        if (!(str = tst_str_alloc (NULL, len + 1))) {
+            fprintf (stderr, "error: tst_wide_ins_del(), memory exhausted.\n");
+            return NULL;
+        }
+        memcpy (str, *s, len + 1);
+    }
+
+    return str;
+}
+
+/** add key '*p' at index 'i' of wide node at '*top' with the chain for the
+ *  rest of word 's'. returns address of word, NULL on failure.
+ */
+static void *tst_wide_add (node_tst **top, const unsigned i, const char *p,
+                            char * const *s, const size_t len, const int cpy)
+{
+    char *str = tst_wide_str (s, len, cpy);
+    node_tst *below = NULL;
+    tst_wnode *w;
+
+    if (!str)
+        return NULL;
+    if (*p && !(below = tst_wide_chain (p + 1, str)))
+        goto fail;
+    if (!(w = tst_wide_grow (top))) {
+        tst_free (below);
+        goto fail;
+    }
+    memmove (w->key + i + 1, w->key + i, w->n - i);
+    memmove (w->ent + i + 1, w->ent + i, (w->n - i) * sizeof *w->ent);
+    w->key[i] = *p;
+    memset (&w->ent[i], 0, sizeof w->ent[i]);
+    w->ent[i].key = *p;
+    w->ent[i].refcnt = 1;
+    w->ent[i].eqkid = *p ? below : (node_tst *)str;
+    w->n++;
+
+    return str;
+
+fail:
+    if (cpy)
+        tst_str_free (NULL, str);
+    return NULL;
+}
+
+/** unlink node at '*slot' from its lo/hi tree and free it, replaced by its
+ *  child, or with two children by its successor.
+ */
+static void tst_wide_unlink (node_tst **slot)
+{
+    node_tst *x = *slot, *succ, **link;
+
+    if (!x->lokid || !x->hikid)
+        *slot = x->lokid ? x->lokid : x->hikid;
+    else {
+        for (link = &x->hikid; (*link)->lokid; link = &(*link)->lokid) {}
+        succ = *link;
+        *link = succ->hikid;
+        succ->lokid = x->lokid;
+        succ->hikid = x->hikid;
+        *slot = succ;
+    }
+    tst_node_free (NULL, x);
+}
+
+/** remove word with 'd' steps on 'path' (the last its node with key nul),
+ *  removing each node left with nothing below its eqkid, bottom up.
+ */
+static void tst_wide_del_word (tst_wstep *path, size_t d, const int min)
+{
+    while (d--) {
+        const tst_wstep *st = &path[d];
+
+        if ((*st->top)->flags & TST_WIDE) {
+            tst_wnode *w = (tst_wnode *)*st->top;
+            unsigned i = st->node - w->ent;
+
+            w->n--;
+            memmove (w->key + i, w->key + i + 1, w->n - i);
+            w->key[w->n] = CHAR_MAX;
+            memmove (w->ent + i, w->ent + i + 1, (w->n - i) * sizeof *w->ent);
+            if (w->n) {
+                if ((int)w->n < min / 2)
+                    tst_wide_narrow (st->top);  /* stays wide on failure */
+                return;
+            }
+            free (w->ent);
+            free (w);
+            *st->top = NULL;
+        }
+        else {
+            tst_wide_unlink (st->slot);
+            if (*st->top)
+                return;
+        }
+    }
+}
+
+/** tst_wide_ins_del() ins/del copy or reference of 's' from wide tree at
+ *  'root', same semantics as tst_ins_del() (TST_NOKEY is not supported,
+ *  nodes in wide levels move). a sibling level reaching 'min' nodes on
+ *  insert is replaced by a wide node, a wide node left with fewer than
+ *  'min / 2' keys on delete is replaced by a balanced lo/hi level ('min' 0
+ *  never changes a level). the tree must only be modified through
+ *  tst_wide_ins_del(), tst_wide_search() and tst_wide_search_prefix() are
+ *  used for lookup, tst_traverse_fn(), tst_nodes(), tst_stats(),
+ *  tst_search_fuzzy(), tst_search_pattern(), tst_rebalance(), tst_free()
+ *  and tst_free_all() handle wide trees, the other walks fail with an
+ *  error. subtree max is not maintained.
+ *  returns address of 's' in tree on successful insert (or on delete if
+ *  refcnt non-zero), NULL on allocation failure on insert, or on successful
+ *  removal of 's' from tree.
+ */
+void *tst_wide_ins_del (node_tst **root, char * const *s, const int del,
+                        const int cpy, const int min)
+{
+    node_tst **top = root, **pcurr = root, *curr;
+    tst_wstep *path = NULL;
+    const char *p;
+    size_t len, d = 0;
+    char *str;
+
+    if (!root || !*s || cpy == TST_NOKEY)
+        return NULL;
+
+    len = strlen (*s);
+    if (len > TST_KEYMAX) {
+        if (!del)
+            fprintf (stderr, "error: tst_wide_ins_del(), key exceeds TST_KEYMAX.\n");
+        return NULL;
+    }
+    if (del && !(path = malloc ((len + 1) * sizeof *path))) {
+        fprintf (stderr, "error: tst_wide_ins_del(), memory exhausted.\n");
+        return NULL;
+    }
+
+    p = *s;
+    while ((curr = *pcurr)) {
+        if (curr->flags & TST_WIDE) {       /* index of key in wide level */
+            tst_wnode *w = (tst_wnode *)curr;
+            unsigned i = tst_wide_rank (w, *p);
+            if (i == w->n || w->key[i] != *p) {
+                if (del)                    /* not found */
+                    break;
+                return tst_wide_add (pcurr, i, p, s, len, cpy);
+            }
+            curr = &w->ent[i];
+            if (del)
+                path[d] = (tst_wstep){ .top = top, .slot = NULL, .node = curr };
+        }
+        else {
+            int diff = *p - curr->key;
+            if (diff) {
+                pcurr = diff < 0 ? &curr->lokid : &curr->hikid;
+                continue;
+            }
+            if (del)
+                path[d] = (tst_wstep){ .top = top, .slot = pcurr, .node = curr };
+        }
+        d++;
+        if (*p++ == 0) {                    /* word exists */
+            if (!del) {
+                curr->refcnt++;
+                return curr->eqkid;
+            }
+            str = (char *)curr->eqkid;
+            if (--curr->refcnt) {           /* occurrences remain */
+                free (path);
+                return str;
+            }
+            tst_wide_del_word (path, d, min);
+            if (cpy)
+                tst_str_free (NULL, str);
+            free (path);
+            return NULL;
+        }
+        top = pcurr = &curr->eqkid;
+    }
+
+    if (del) {                              /* not found */
+        free (path);
+        return NULL;
+    }
+
+    if (!(str = tst_wide_str (s, len, cpy)))
+        return NULL;
+    if (!(*pcurr = tst_wide_chain (p, str))) {
+        if (cpy)
+            tst_str_free (NULL, str);
+        return NULL;
+    }
+    /* node added to a lo/hi level, widen at 'min' (stays on failure) */
+    if (pcurr != top && min > 0 && tst_wide_count (*top) >= (unsigned)min)
+        tst_wide_widen (top);
+
+    return str;
+}
+
+/** widen each level of 'min' or more nodes below lo/hi tree at 'p'. */
+static int tst_wide_sib (node_tst *p, const int min);
+
+/** widen level at '*top' if it has 'min' or more nodes, then the levels
+ *  below it. returns 0 on success, -1 on failure.
+ */
+static int tst_wide_level (node_tst **top, const int min)
+{
+    tst_wnode *w;
+
+    if (!*top)
+        return 0;
+    if (!((*top)->flags & TST_WIDE)) {
+        if (tst_wide_count (*top) < (unsigned)min)
+            return tst_wide_sib (*top, min);
+        if (tst_wide_widen (top))
+            return -1;
+    }
+
+    w = (tst_wnode *)*top;
+    for (unsigned i = 0; i < w->n; i++)
+        if (w->ent[i].key && tst_wide_level (&w->ent[i].eqkid, min))
+            return -1;
+
+    return 0;
+}
+
+static int tst_wide_sib (node_tst *p, const int min)
+{
+    for (; p; p = p->hikid) {
+        if (tst_wide_sib (p->lokid, min))
+            return -1;
+        if (p->key && tst_wide_level (&p->eqkid, min))
+            return -1;
+    }
+
+    return 0;
+}
+
+/** tst_widen() replace each sibling level of 'min' (> 0) or more nodes in
+ *  plain tree (by copy or reference) at 'root' by a wide node, making it a
+ *  wide tree (see tst_wide_ins_del()). returns 0 on success, -1 on
+ *  allocation failure (the tree is valid, some levels left lo/hi).
+ */
+int tst_widen (node_tst **root, const int min)
+{
+    if (min <= 0) {
+        fprintf (stderr, "error: tst_widen(), min must be positive.\n");
+        return -1;
+    }
+
+    return tst_wide_level (root, min);
+}
+
+/** tst_wide_search(), non-recursive find of a string in wide tree.
+ *  returns pointer to 's' on success, NULL otherwise.
+ */
+void *tst_wide_search (const node_tst *p, const char *s)
+{
+    const node_tst *curr = p;
+
+    while (curr) {
+        if (curr->flags & TST_WIDE) {
+            const tst_wnode *w = (const tst_wnode *)curr;
+            unsigned i = tst_wide_rank (w, *s);
+            if (i == w->n || w->key[i] != *s)
+                return NULL;
+            curr = &w->ent[i];
+        }
+        else if (*s != curr->key) {
+            curr = *s < curr->key ? curr->lokid : curr->hikid;
+            continue;
+        }
+        if (*s == 0)
+            return (void *)curr->eqkid;
+        s++;
+        curr = curr->eqkid;
+    }
+    return NULL;
+}
+
+/** fill 'a' with the words in wide tree level at 'p' in order. */
+static void tst_wide_suggest (const node_tst *p, char **a, int *n,
+                                const int max)
+{
+    if (p && (p->flags & TST_WIDE)) {
+        const tst_wnode *w = (const tst_wnode *)p;
+        for (unsigned i = 0; i < w->n && *n < max; i++)
+            tst_wide_suggest (&w->ent[i], a, n, max);
+        return;
+    }
+    for (; p && *n < max; p = p->hikid) {
+        tst_wide_suggest (p->lokid, a, n, max);
+        if (*n == max)
+            return;
+        if (p->key)
+            tst_wide_suggest (p->eqkid, a, n, max);
+        else
+            a[(*n)++] = (char *)p->eqkid;
+    }
+}
+
+/** tst_wide_search_prefix() fills ptr array 'a' with words prefixed with
+ *  's' in wide tree, as tst_search_prefix(). returns non-NULL on success,
+ *  NULL otherwise.
+ */
+void *tst_wide_search_prefix (const node_tst *root, const char *s,
+                                char **a, int *n, const int max)
+{
+    const node_tst *curr = root;
+
+    *n = 0;
+    if (!*s) return NULL;
+
+    while (curr) {
+        if (curr->flags & TST_WIDE) {
+            const tst_wnode *w = (const tst_wnode *)curr;
+            unsigned i = tst_wide_rank (w, *s);
+            if (i == w->n || w->key[i] != *s)
+                return NULL;
+            curr = &w->ent[i];
+        }
+        else if (*s != curr->key) {
+            curr = *s < curr->key ? curr->lokid : curr->hikid;
+            continue;
+        }
+        if (!*++s) {                        /* words below last prefix char */
+            tst_wide_suggest (curr->eqkid, a, n, max);
+            return *n ? (void *)curr : NULL;
+        }
+        curr = curr->eqkid;
+    }
+    return NULL;
+}
@@ -0,0 +1,1987 @@
+#define _XOPEN_SOURCE 600           /* for clock_gettime, getrusage */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <malloc.h>                 /* mallinfo2, malloc_trim (glibc) */
+#include <stdatomic.h>
+#include <threads.h>
+#include <sys/resource.h>
+
+#include "ternary_st.h"
+
+/** constants insert, delete, max word(s) & stack nodes */
+enum { INS, DEL, WRDMAX = 256, STKMAX = 512, LMAX = 1024 };
+#define REF INS
+#define CPY DEL
+
+/** timing helper function (monotonic clock) */
+double tvgetf (void)
+{
+    struct timespec ts;
+    double sec;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    sec = ts.tv_nsec;
+    sec /= 1e9;
+    sec += ts.tv_sec;
+
+    return sec;
+}
+
+/** realloc 'ptr' of 'nelem' of 'psz' to 'nelem * 2' of 'psz'.
+ *  returns pointer to reallocated block of memory with new
+ *  memory initialized to 0/NULL. return must be assigned to
+ *  original pointer in caller.
+ */
+void *xrealloc (void *ptr, size_t psz, size_t *nelem)
+{
+    void *memptr = realloc ((char *)ptr, *nelem * 2 * psz);
+    if (!memptr) {
+        fprintf (stderr, "realloc() error: virtual memory exhausted.\n");
+        exit (EXIT_FAILURE);
+    }
+    /* zero new memory (optional) */
+    memset ((char *)memptr + *nelem * psz, 0, *nelem * psz);
+    *nelem *= 2;
+
+    return memptr;
+}
+
+/** rand_int for use with shuffle */
+static int rand_int (int n)
+{
+    int limit = RAND_MAX - RAND_MAX % n, rnd;
+
+    rnd = rand();
+    for (; rnd >= limit; )
+        rnd = rand();
+
+    return rnd % n;
+}
+
+/** shuffle an array of pointers */
+void shuffle_ptrs (char **a, size_t n)
+{
+    char *tmp;
+    size_t i;
+
+    while (n-- > 1) {
+        i = rand_int (n);
+        tmp  = a[i];
+        a[i] = a[n];
+        a[n] = tmp;
+    }
+}
+
+/** shuffled copy of 'n' pointers in 'words' for lookups in random order. */
+static char **lookup_keys (char **words, size_t n)
+{
+    char **keys = malloc (n * sizeof *keys);
+
+    if (!keys) {
+        fprintf (stderr, "error: memory exhausted, lookup keys.\n");
+        exit (EXIT_FAILURE);
+    }
+    memcpy (keys, words, n * sizeof *keys);
+    shuffle_ptrs (keys, n);
+
+    return keys;
+}
+
+/** copies of 'n' 'keys' with '#' appended, each a miss after a full path. */
+static char **miss_keys (char **keys, size_t n)
+{
+    char **miss = malloc (n * sizeof *miss);
+
+    if (!miss) {
+        fprintf (stderr, "error: memory exhausted, miss keys.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t len = strlen (keys[i]);
+        if (!(miss[i] = malloc (len + 2))) {
+            fprintf (stderr, "error: memory exhausted, miss keys.\n");
+            exit (EXIT_FAILURE);
+        }
+        memcpy (miss[i], keys[i], len);
+        memcpy (miss[i] + len, "#", 2);
+    }
+
+    return miss;
+}
+
+/** free 'n' keys and array of pointers 'keys'. */
+static void free_keys (char **keys, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        free (keys[i]);
+    free (keys);
+}
+
+/** benchmark, 'name' selects 'fn' to run on 'n' loaded 'words'. */
+typedef struct {
+    const char *name;
+    void (*fn) (char **words, size_t n);
+} bench_t;
+
+/** max timed repetitions of a case */
+#define REPMAX 100
+
+/** timed runs of each case (after 'warmup' runs not counted), results as
+ *  text or as tab-separated 'bench case metric value unit' lines ('tsv').
+ */
+static struct {
+    int reps, warmup, tsv;
+} cfg = { 5, 1, 0 };
+
+/** state of a timed case, keys used in order, tree, prefix search results. */
+typedef struct {
+    char **keys;
+    size_t n;
+    node_tst *root;
+    char **a;               /* prefix search results */
+    size_t found;           /* words found (checked after the runs) */
+    int level;              /* wide 'min' or burst 'max', 0 plain tree */
+} core_t;
+
+/** qsort compare for doubles, ascending. */
+static int cmp_dbl (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/** qsort compare for array of pointers to strings. */
+static int cmp_str (const void *a, const void *b)
+{
+    return strcmp (*(char * const *)a, *(char * const *)b);
+}
+
+/** report 'value' in 'unit' as metric 'metric' of case 'name' of 'bench'. */
+static void report_value (const char *bench, const char *name,
+                            const char *metric, double value, const char *unit)
+{
+    if (cfg.tsv)
+        printf ("%s\t%s\t%s\t%.9g\t%s\n", bench, name, metric, value, unit);
+    else
+        printf ("%-8s %-9s %s %.1f %s\n", bench, name, metric, value, unit);
+}
+
+/** time 'run' of case 'name' of 'bench' ('ops' operations per run) with
+ *  cfg.warmup runs then cfg.reps timed runs, 'setup' and 'teardown' (may
+ *  be NULL) around each run untimed. reports min, median and max time
+ *  and median ns per operation.
+ */
+static void timed (const char *bench, const char *name, const size_t ops,
+                    void (*setup) (core_t *), void (*run) (core_t *),
+                    void (*teardown) (core_t *), core_t *c)
+{
+    double t[REPMAX], med;
+    int n = 0;
+
+    for (int r = -cfg.warmup; r < cfg.reps; r++) {
+        double t1, t2;
+        if (setup)
+            setup (c);
+        c->found = 0;
+        t1 = tvgetf();
+        run (c);
+        t2 = tvgetf();
+        if (teardown)
+            teardown (c);
+        if (r >= 0)
+            t[n++] = t2 - t1;
+    }
+    qsort (t, n, sizeof *t, cmp_dbl);
+    med = n % 2 ? t[n / 2] : (t[n / 2 - 1] + t[n / 2]) / 2;
+
+    if (cfg.tsv) {
+        report_value (bench, name, "min", t[0], "s");
+        report_value (bench, name, "median", med, "s");
+        report_value (bench, name, "max", t[n - 1], "s");
+        report_value (bench, name, "per_op", med / ops * 1e9, "ns");
+    }
+    else
+        printf ("%-8s %-9s median %.6f sec  min %.6f  max %.6f  %9.1f ns/op\n",
+                bench, name, med, t[0], t[n - 1], med / ops * 1e9);
+}
+
+/** insert keys of 'c' in order by reference. */
+static void core_build (core_t *c)
+{
+    for (size_t i = 0; i < c->n; i++)
+        if (!tst_ins_del (&c->root, &c->keys[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+}
+
+/** free tree of 'c'. */
+static void core_free (core_t *c)
+{
+    tst_free (c->root);
+    c->root = NULL;
+}
+
+/** search each key of 'c'. */
+static void core_search (core_t *c)
+{
+    for (size_t i = 0; i < c->n; i++)
+        c->found += tst_search (c->root, c->keys[i]) != NULL;
+}
+
+/** prefix search with each key of 'c' (the prefixes). */
+static void core_prefix (core_t *c)
+{
+    for (size_t i = 0; i < c->n; i++) {
+        int n = 0;
+        tst_search_prefix (c->root, c->keys[i], c->a, &n, LMAX);
+        c->found += n;
+    }
+}
+
+/** delete each key of 'c' (tree empty after). */
+static void core_delete (core_t *c)
+{
+    for (size_t i = 0; i < c->n; i++)
+        tst_ins_del (&c->root, &c->keys[i], DEL, REF);
+    c->found = c->root == NULL;
+}
+
+/** count words, tst_traverse_fn() callback. */
+static void core_count (const void *node, void *data)
+{
+    (*(size_t *)data)++;
+
+    if (node) {}
+}
+
+/** traverse tree of 'c' counting words. */
+static void core_traverse (core_t *c)
+{
+    tst_traverse_fn (c->root, core_count, &c->found);
+}
+
+/** insertion by reference of the words sorted and shuffled. */
+static void bench_insert (char **words, size_t n)
+{
+    char **sorted = malloc (n * sizeof *sorted), **keys = lookup_keys (words, n);
+    core_t c = { .keys = sorted, .n = n };
+
+    if (!sorted) {
+        fprintf (stderr, "error: memory exhausted, sorted keys.\n");
+        exit (EXIT_FAILURE);
+    }
+    memcpy (sorted, words, n * sizeof *sorted);
+    qsort (sorted, n, sizeof *sorted, cmp_str);
+
+    timed ("insert", "sorted", n, NULL, core_build, core_free, &c);
+    c.keys = keys;
+    timed ("insert", "shuffled", n, NULL, core_build, core_free, &c);
+
+    free (sorted);
+    free (keys);
+}
+
+/** lookup of every word (hit) and of every word with a char appended
+ *  (miss after a full path), in random order, tree built shuffled.
+ */
+static void bench_lookup (char **words, size_t n)
+{
+    char **keys = lookup_keys (words, n), **miss = miss_keys (keys, n);
+    core_t c = { .keys = keys, .n = n };
+
+    core_build (&c);
+    timed ("lookup", "hit", n, NULL, core_search, NULL, &c);
+    if (c.found != n)
+        fprintf (stderr, "error: lookup, %zu of %zu words found.\n", c.found, n);
+    c.keys = miss;
+    timed ("lookup", "miss", n, NULL, core_search, NULL, &c);
+    if (c.found)
+        fprintf (stderr, "error: lookup, %zu misses found.\n", c.found);
+    core_free (&c);
+
+    free_keys (miss, n);
+    free (keys);
+}
+
+/** prefix search (up to LMAX words) with prefixes of 1 - 4 chars of up to
+ *  1000 words drawn at random, tree built shuffled.
+ */
+static void bench_prefix (char **words, size_t n)
+{
+    enum { NPREFIX = 1000 };
+    char **keys = lookup_keys (words, n), *a[LMAX],
+         **prefix = malloc (NPREFIX * sizeof *prefix);
+    core_t c = { .keys = keys, .n = n, .a = a };
+
+    if (!prefix) {
+        fprintf (stderr, "error: memory exhausted, prefixes.\n");
+        exit (EXIT_FAILURE);
+    }
+    core_build (&c);
+
+    for (size_t len = 1; len <= 4; len++) {
+        char name[16];
+        size_t np = 0;
+        for (size_t i = 0; i < n && np < NPREFIX; i++) {
+            if (strlen (keys[i]) < len)
+                continue;
+            if (!(prefix[np] = malloc (len + 1))) {
+                fprintf (stderr, "error: memory exhausted, prefixes.\n");
+                exit (EXIT_FAILURE);
+            }
+            memcpy (prefix[np], keys[i], len);
+            prefix[np++][len] = 0;
+        }
+        if (!np)
+            break;
+        sprintf (name, "len%zu", len);
+        c.keys = prefix;
+        c.n = np;
+        timed ("prefix", name, np, NULL, core_prefix, NULL, &c);
+        for (size_t i = 0; i < np; i++)
+            free (prefix[i]);
+        c.keys = keys;
+        c.n = n;
+    }
+    core_free (&c);
+
+    free (prefix);
+    free (keys);
+}
+
+/** delete of every word in random order from a tree built shuffled. */
+static void bench_delete (char **words, size_t n)
+{
+    char **keys = lookup_keys (words, n);
+    core_t c = { .keys = keys, .n = n };
+
+    timed ("delete", "all", n, core_build, core_delete, core_free, &c);
+    if (!c.found)
+        fprintf (stderr, "error: delete, tree not empty.\n");
+
+    free (keys);
+}
+
+/** in-order traversal of all words, tree built shuffled. */
+static void bench_traverse (char **words, size_t n)
+{
+    char **keys = lookup_keys (words, n);
+    core_t c = { .keys = keys, .n = n };
+
+    core_build (&c);
+    timed ("traverse", "all", n, NULL, core_traverse, NULL, &c);
+    core_free (&c);
+
+    free (keys);
+}
+
+/** build (copy) and teardown, calloc/free per node vs. arena slabs. */
+static void bench_arena (char **words, size_t n)
+{
+    node_tst *root = NULL;
+    tst_arena *a = NULL;
+    double t1, t2, t3;
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, CPY)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    t2 = tvgetf();
+    tst_free_all (root);
+    t3 = tvgetf();
+    printf ("arena    malloc   build %.6f sec   free %.6f sec\n",
+            t2 - t1, t3 - t2);
+
+    if (!(a = tst_arena_create (0)))
+        exit (EXIT_FAILURE);
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_arena_ins_del (a, &words[i], INS, CPY)) {
+            fprintf (stderr, "error: memory exhausted, tst_arena_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    t2 = tvgetf();
+    tst_arena_destroy (a);
+    t3 = tvgetf();
+    printf ("arena    arena    build %.6f sec   free %.6f sec\n",
+            t2 - t1, t3 - t2);
+}
+
+/** bytes of heap in use (glibc mallinfo2, includes allocator overhead) */
+static size_t heapused (void)
+{
+    return mallinfo2().uordblks;
+}
+
+/** memory per word (reference mode), pointer nodes vs. compact nodes. */
+static void bench_layout (char **words, size_t n)
+{
+    node_tst *root = NULL;
+    tst_cpt *t = NULL;
+    size_t h1, h2;
+
+    h1 = heapused();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    h2 = heapused();
+    printf ("layout   pointer  %zu bytes   %.1f bytes/word\n",
+            h2 - h1, (double)(h2 - h1) / n);
+    tst_free (root);
+
+    h1 = heapused();
+    if (!(t = tst_cpt_create()))
+        exit (EXIT_FAILURE);
+    for (size_t i = 0; i < n; i++)
+        if (!tst_cpt_ins_del (t, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_cpt_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    h2 = heapused();
+    printf ("layout   compact  %zu bytes   %.1f bytes/word\n",
+            h2 - h1, (double)(h2 - h1) / n);
+    tst_cpt_free (t, 0);
+}
+
+/** lookup latency of hits and misses, pointer tree vs. frozen tree. */
+static void bench_frozen (char **words, size_t n)
+{
+    node_tst *root = NULL;
+    tst_frozen *f = NULL;
+    char **keys = lookup_keys (words, n), **miss = miss_keys (keys, n);
+    size_t found = 0;
+    double t1, t2;
+
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    t1 = tvgetf();
+    if (!(f = tst_freeze (root)))
+        exit (EXIT_FAILURE);
+    t2 = tvgetf();
+    printf ("frozen   freeze   %.6f sec\n", t2 - t1);
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        found += tst_search (root, keys[i]) != NULL;
+    t2 = tvgetf();
+    printf ("frozen   pointer  hit  %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        found += tst_search (root, miss[i]) != NULL;
+    t2 = tvgetf();
+    printf ("frozen   pointer  miss %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        found += tst_frozen_search (f, keys[i]) != NULL;
+    t2 = tvgetf();
+    printf ("frozen   frozen   hit  %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        found += tst_frozen_search (f, miss[i]) != NULL;
+    t2 = tvgetf();
+    printf ("frozen   frozen   miss %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+
+    if (found != 2 * n)
+        fprintf (stderr, "error: frozen, %zu of %zu words found.\n", found, 2 * n);
+
+    tst_frozen_free (f);
+    tst_free (root);
+    free_keys (miss, n);
+    free (keys);
+}
+
+/** startup, rebuild of tree from words vs. mapping saved image. */
+static void bench_image (char **words, size_t n)
+{
+    const char *img = "tst_bench.img";
+    node_tst *root = NULL;
+    tst_frozen *f = NULL;
+    size_t found = 0;
+    double t1, t2;
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, CPY)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    t2 = tvgetf();
+    printf ("image    rebuild  %.6f sec\n", t2 - t1);
+
+    t1 = tvgetf();
+    if (tst_save (root, img))
+        exit (EXIT_FAILURE);
+    t2 = tvgetf();
+    printf ("image    save     %.6f sec\n", t2 - t1);
+    tst_free_all (root);
+
+    t1 = tvgetf();
+    if (!(f = tst_frozen_map (img)))
+        exit (EXIT_FAILURE);
+    t2 = tvgetf();
+    printf ("image    map      %.6f sec\n", t2 - t1);
+
+    for (size_t i = 0; i < n; i++)
+        found += tst_frozen_search (f, words[i]) != NULL;
+    if (found != n)
+        fprintf (stderr, "error: image, %zu of %zu words found.\n", found, n);
+
+    tst_frozen_free (f);
+    remove (img);
+}
+
+/** insertion in file order vs. tst_build_sorted() and tst_rebalance() of
+ *  the insert-order tree, time and comparisons.
+ */
+static void bench_build (char **words, size_t n)
+{
+    node_tst *root = NULL, *bulk = NULL;
+    size_t ncmp = 0, nbulk = 0, nrebal = 0;
+    double t1, t2, t3;
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    t2 = tvgetf();
+    if (n && !tst_build_sorted (&bulk, words, n, REF)) {
+        fprintf (stderr, "error: memory exhausted, tst_build_sorted.\n");
+        exit (EXIT_FAILURE);
+    }
+    t3 = tvgetf();
+
+    for (size_t i = 0; i < n; i++) {
+        ncmp += tst_search_cmp (root, words[i]);
+        nbulk += tst_search_cmp (bulk, words[i]);
+    }
+    printf ("build    insert   %.6f sec   %.2f cmp/lookup\n",
+            t2 - t1, (double)ncmp / n);
+    printf ("build    bulk     %.6f sec   %.2f cmp/lookup\n",
+            t3 - t2, (double)nbulk / n);
+
+    t1 = tvgetf();
+    tst_rebalance (&root);
+    t2 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        nrebal += tst_search_cmp (root, words[i]);
+    printf ("build    rebal    %.6f sec   %.2f cmp/lookup\n",
+            t2 - t1, (double)nrebal / n);
+
+    tst_free (bulk);
+    tst_free (root);
+}
+
+/** nodes, heap use and lookup time of plain vs. path-compressed tree. */
+static void bench_path (char **words, size_t n)
+{
+    node_tst *root = NULL, *pc = NULL;
+    char **keys = lookup_keys (words, n), **miss = miss_keys (keys, n);
+    size_t found = 0, h1, h2, h3;
+    double t1, t2;
+
+    h1 = heapused();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    h2 = heapused();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_pc_ins_del (&pc, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_pc_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    h3 = heapused();
+    printf ("path     plain    %zu nodes   %zu bytes\n", tst_nodes (root), h2 - h1);
+    printf ("path     pc       %zu nodes   %zu bytes\n", tst_nodes (pc), h3 - h2);
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        found += tst_search (root, keys[i]) != NULL;
+    t2 = tvgetf();
+    printf ("path     plain    hit  %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        found += tst_search (root, miss[i]) != NULL;
+    t2 = tvgetf();
+    printf ("path     plain    miss %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        found += tst_pc_search (pc, keys[i]) != NULL;
+    t2 = tvgetf();
+    printf ("path     pc       hit  %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        found += tst_pc_search (pc, miss[i]) != NULL;
+    t2 = tvgetf();
+    printf ("path     pc       miss %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+
+    if (found != 2 * n)
+        fprintf (stderr, "error: path, %zu of %zu words found.\n", found, 2 * n);
+
+    tst_free (pc);
+    tst_free (root);
+    free_keys (miss, n);
+    free (keys);
+}
+
+/** traverse callbacks, sum key lengths so traversal is not elided. */
+static void sum_word (const void *node, void *data)
+{
+    *(size_t *)data += strlen (tst_get_string (node));
+}
+
+static void sum_key (const void *node, const char *key, void *data)
+{
+    *(size_t *)data += strlen (key);
+    (void)node;
+}
+
+/** heap use, build and traversal time of copy vs. keyless (TST_NOKEY) tree. */
+static void bench_keyless (char **words, size_t n)
+{
+    node_tst *root = NULL, *nokey = NULL;
+    size_t h1, h2, h3, sum1 = 0, sum2 = 0;
+    double t1, t2, t3;
+
+    h1 = heapused();
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, CPY)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    t2 = tvgetf();
+    h2 = heapused();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&nokey, &words[i], INS, TST_NOKEY)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    t3 = tvgetf();
+    h3 = heapused();
+    printf ("keyless  copy     %zu bytes   %.6f sec\n", h2 - h1, t2 - t1);
+    printf ("keyless  nokey    %zu bytes   %.6f sec\n", h3 - h2, t3 - t2);
+
+    t1 = tvgetf();
+    tst_traverse_fn (root, sum_word, &sum1);
+    t2 = tvgetf();
+    tst_traverse_key_fn (nokey, sum_key, &sum2);
+    t3 = tvgetf();
+    printf ("keyless  copy     traverse %.6f sec\n", t2 - t1);
+    printf ("keyless  nokey    traverse %.6f sec\n", t3 - t2);
+
+    if (sum1 != sum2)
+        fprintf (stderr, "error: keyless, key lengths %zu != %zu.\n", sum1, sum2);
+
+    tst_free (nokey);
+    tst_free_all (root);
+}
+
+/** page through completions of a one char prefix, tst_cursor_next() vs.
+ *  re-running tst_search_prefix() with a larger array for each page.
+ */
+static void bench_cursor (char **words, size_t n)
+{
+    enum { PAGE = 20, NPAGES = 200 };
+    node_tst *root = NULL;
+    tst_cursor *c = NULL;
+    char prefix[2] = "", **a = NULL;
+    size_t total1 = 0, total2 = 0;
+    double t1, t2, t3;
+
+    if (!n)
+        return;
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    prefix[0] = *words[n / 2];
+    if (!(a = malloc ((size_t)PAGE * NPAGES * sizeof *a))) {
+        fprintf (stderr, "error: memory exhausted, page array.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    t1 = tvgetf();
+    if (!(c = tst_cursor_open (root, prefix)))
+        exit (EXIT_FAILURE);
+    for (int pg = 0; pg < NPAGES; pg++) {
+        int got = tst_cursor_next (c, a, PAGE);
+        if (got <= 0)
+            break;
+        total1 += got;
+    }
+    tst_cursor_close (c);
+    t2 = tvgetf();
+    for (int pg = 0; pg < NPAGES; pg++) {   /* page k costs all k pages */
+        int got = 0;
+        tst_search_prefix (root, prefix, a, &got, (pg + 1) * PAGE);
+        if (got <= pg * PAGE)
+            break;
+        total2 += got - pg * PAGE;
+    }
+    t3 = tvgetf();
+
+    printf ("cursor   next     %zu words  %d/page  %.6f sec\n",
+            total1, PAGE, t2 - t1);
+    printf ("cursor   rerun    %zu words  %d/page  %.6f sec\n",
+            total2, PAGE, t3 - t2);
+
+    free (a);
+    tst_free (root);
+}
+
+/** top 10 by refcnt for 1 and 2 char prefixes with skewed word counts,
+ *  tst_topk_prefix() vs. enumerating all matches with tst_search_prefix().
+ */
+static void bench_topk (char **words, size_t n)
+{
+    enum { K = 10, NQ = 1000 };
+    node_tst *root = NULL;
+    char *top[K], **all = NULL;
+    size_t nall = 0;
+    double t1, t2;
+
+    if (!n)
+        return;
+    for (size_t i = 0; i < 2 * n; i++) {    /* each word, then skewed */
+        size_t w = i < n ? i : (size_t)rand_int (rand_int (n) + 1);
+        if (!tst_topk_ins_del (&root, &words[w], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_topk_ins_del.\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    if (!(all = malloc (n * sizeof *all))) {
+        fprintf (stderr, "error: memory exhausted, match array.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    for (size_t len = 1; len <= 2; len++) {
+        char prefix[NQ][3];
+        for (size_t q = 0; q < NQ; q++) {
+            const char *w = words[rand_int (n)];
+            memcpy (prefix[q], w, len);
+            prefix[q][len] = 0;
+        }
+
+        t1 = tvgetf();
+        for (size_t q = 0; q < NQ; q++) {
+            int got = 0;
+            tst_topk_prefix (root, prefix[q], top, &got, K);
+        }
+        t2 = tvgetf();
+        printf ("topk     %zu char   top%d  %8.1f us/query\n",
+                len, K, (t2 - t1) * 1e6 / NQ);
+
+        nall = 0;
+        t1 = tvgetf();
+        for (size_t q = 0; q < NQ; q++) {
+            int got = 0;
+            tst_search_prefix (root, prefix[q], all, &got, (int)n);
+            nall += got;
+        }
+        t2 = tvgetf();
+        printf ("topk     %zu char   all    %8.1f us/query  %zu matches/query\n",
+                len, (t2 - t1) * 1e6 / NQ, nall / NQ);
+    }
+
+    free (all);
+    tst_free (root);
+}
+
+/** Levenshtein distance of 'a' and 'b' (brute-force scan for bench_fuzzy). */
+static int levenshtein (const char *a, const char *b)
+{
+    int row[LMAX], tmp[LMAX];
+    size_t m = strlen (b);
+
+    if (m >= LMAX)
+        return INT_MAX;
+    for (size_t j = 0; j <= m; j++)
+        row[j] = j;
+    for (; *a; a++) {
+        tmp[0] = row[0] + 1;
+        for (size_t j = 1; j <= m; j++) {
+            int d = row[j - 1] + (b[j - 1] != *a);
+            if (row[j] + 1 < d)
+                d = row[j] + 1;
+            if (tmp[j - 1] + 1 < d)
+                d = tmp[j - 1] + 1;
+            tmp[j] = d;
+        }
+        memcpy (row, tmp, (m + 1) * sizeof *row);
+    }
+
+    return row[m];
+}
+
+/** words within distance 1 and 2 of misspelled words, tst_search_fuzzy()
+ *  and tst_search_fuzzy_prefix() vs. a Levenshtein scan of all words.
+ */
+static void bench_fuzzy (char **words, size_t n)
+{
+    enum { NQ = 200, NSCAN = 10 };
+    node_tst *root = NULL;
+    char query[NQ][WRDMAX], **out = NULL;
+    size_t nfound;
+    double t1, t2;
+
+    if (!n)
+        return;
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    if (!(out = malloc (n * sizeof *out))) {
+        fprintf (stderr, "error: memory exhausted, match array.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t q = 0; q < NQ; q++) {       /* substitute one char */
+        const char *w = words[rand_int (n)];
+        size_t len = strlen (w);
+        memcpy (query[q], w, len + 1);
+        query[q][rand_int (len)] = 'x';
+    }
+
+    for (int maxdist = 1; maxdist <= 2; maxdist++) {
+        nfound = 0;
+        t1 = tvgetf();
+        for (size_t q = 0; q < NQ; q++)
+            nfound += tst_search_fuzzy (root, query[q], maxdist, out, (int)n);
+        t2 = tvgetf();
+        printf ("fuzzy    dist %d   tree    %8.1f us/query  %.1f matches\n",
+                maxdist, (t2 - t1) * 1e6 / NQ, (double)nfound / NQ);
+
+        nfound = 0;
+        t1 = tvgetf();
+        for (size_t q = 0; q < NQ; q++)
+            nfound += tst_search_fuzzy_prefix (root, query[q], maxdist, out,
+                                                (int)n);
+        t2 = tvgetf();
+        printf ("fuzzy    dist %d   prefix  %8.1f us/query  %.1f matches\n",
+                maxdist, (t2 - t1) * 1e6 / NQ, (double)nfound / NQ);
+
+        nfound = 0;
+        t1 = tvgetf();
+        for (size_t q = 0; q < NSCAN; q++)
+            for (size_t i = 0; i < n; i++)
+                nfound += levenshtein (words[i], query[q]) <= maxdist;
+        t2 = tvgetf();
+        printf ("fuzzy    dist %d   scan    %8.1f us/query  %.1f matches\n",
+                maxdist, (t2 - t1) * 1e6 / NSCAN, (double)nfound / NSCAN);
+    }
+
+    free (out);
+    tst_free (root);
+}
+
+/** 's' matches 'pat' with '?' any char and '*' any run of chars
+ *  (brute-force scan for bench_pattern).
+ */
+static int globmatch (const char *pat, const char *s)
+{
+    const char *star = NULL, *mark = NULL;
+
+    while (*s) {
+        if (*pat == '*') {                  /* remember star, match empty */
+            star = pat++;
+            mark = s;
+        }
+        else if (*pat == '?' || *pat == *s) {
+            pat++;
+            s++;
+        }
+        else if (star) {                    /* star takes one more char */
+            pat = star + 1;
+            s = ++mark;
+        }
+        else
+            return 0;
+    }
+    while (*pat == '*')
+        pat++;
+
+    return !*pat;
+}
+
+/** patterns with '?' for two chars of a word and with '*' between its first
+ *  2 and last 3 chars, tst_search_pattern() vs. a match scan of all words.
+ */
+static void bench_pattern (char **words, size_t n)
+{
+    enum { NQ = 200, NSCAN = 10 };
+    const char *kind[] = { "?", "*" };
+    node_tst *root = NULL;
+    char query[2][NQ][WRDMAX], **out = NULL;
+    double t1, t2;
+
+    if (!n)
+        return;
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    if (!(out = malloc (n * sizeof *out))) {
+        fprintf (stderr, "error: memory exhausted, match array.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t q = 0; q < NQ; q++) {
+        const char *w;
+        size_t len;
+        do {                                /* words of 6 chars or more */
+            w = words[rand_int (n)];
+            len = strlen (w);
+        } while (len < 6);
+        memcpy (query[0][q], w, len + 1);   /* c?t */
+        query[0][q][rand_int (len)] = '?';
+        query[0][q][rand_int (len)] = '?';
+        sprintf (query[1][q], "%.2s*%s", w, w + len - 3);  /* ab*ing */
+    }
+
+    for (int k = 0; k < 2; k++) {
+        size_t nfound = 0;
+        t1 = tvgetf();
+        for (size_t q = 0; q < NQ; q++) {
+            int got = 0;
+            tst_search_pattern (root, query[k][q], out, &got, (int)n);
+            nfound += got;
+        }
+        t2 = tvgetf();
+        printf ("pattern  %s   tree    %8.1f us/query  %.1f matches\n",
+                kind[k], (t2 - t1) * 1e6 / NQ, (double)nfound / NQ);
+
+        nfound = 0;
+        t1 = tvgetf();
+        for (size_t q = 0; q < NSCAN; q++)
+            for (size_t i = 0; i < n; i++)
+                nfound += globmatch (query[k][q], words[i]);
+        t2 = tvgetf();
+        printf ("pattern  %s   scan    %8.1f us/query  %.1f matches\n",
+                kind[k], (t2 - t1) * 1e6 / NSCAN, (double)nfound / NSCAN);
+    }
+
+    free (out);
+    tst_free (root);
+}
+
+/** lookup throughput of trees of 1k, 100k and 1M keys (words, then words
+ *  with a numeric suffix), tst_search_batch() vs. tst_search() per key, on
+ *  a stream of keys drawn at random.
+ */
+static void bench_batch (char **words, size_t n)
+{
+    enum { NLOOKUP = 1000000 };
+    const size_t sizes[] = { 1000, 100000, 1000000 };
+    const char **order = malloc (NLOOKUP * sizeof *order);
+    void **results = malloc (NLOOKUP * sizeof *results);
+
+    if (!n)
+        return;
+    if (!order || !results) {
+        fprintf (stderr, "error: memory exhausted, batch lookups.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    for (size_t z = 0; z < sizeof sizes / sizeof *sizes; z++) {
+        size_t nkeys = sizes[z], found = 0;
+        char **keys = malloc (nkeys * sizeof *keys),
+            *buf = malloc (nkeys * LMAX / 16);
+        node_tst *root = NULL;
+        double t1, t2, tsingle, tbatch;
+        char *p = buf;
+
+        if (!keys || !buf) {
+            fprintf (stderr, "error: memory exhausted, batch keys.\n");
+            exit (EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < nkeys; i++) {    /* word, or word + suffix */
+            if (i < n)
+                keys[i] = words[i];
+            else {
+                keys[i] = p;
+                p += sprintf (p, "%.40s%zu", words[i % n], i / n) + 1;
+            }
+            if (!tst_ins_del (&root, &keys[i], INS, REF)) {
+                fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+                exit (EXIT_FAILURE);
+            }
+        }
+        for (size_t i = 0; i < NLOOKUP; i++)    /* random lookup stream */
+            order[i] = keys[rand_int (nkeys)];
+
+        t1 = tvgetf();
+        for (size_t i = 0; i < NLOOKUP; i++)
+            results[i] = tst_search (root, order[i]);
+        t2 = tvgetf();
+        tsingle = t2 - t1;
+
+        t1 = tvgetf();
+        found = tst_search_batch (root, order, NLOOKUP, results);
+        t2 = tvgetf();
+        tbatch = t2 - t1;
+
+        printf ("batch    %7zu keys  single %6.2f M/sec  batch %6.2f M/sec"
+                "  (%.2fx, %zu found)\n", nkeys, NLOOKUP / tsingle / 1e6,
+                NLOOKUP / tbatch / 1e6, tsingle / tbatch, found);
+
+        tst_free (root);
+        free (buf);
+        free (keys);
+    }
+
+    free (results);
+    free (order);
+}
+
+/** shared state for bench_conc threads, concurrent tree or plain tree
+ *  under a global lock.
+ */
+typedef struct {
+    tst_conc *c;
+    node_tst *root;
+    mtx_t lock;
+    char **words;
+    size_t n;
+    atomic_int stop;
+    atomic_ulong lookups;
+} conc_t;
+
+/** bench_conc reader, random lookups until stopped. */
+static int conc_reader (void *arg)
+{
+    conc_t *ct = arg;
+    unsigned long nlookup = 0;
+    unsigned x = (unsigned)(size_t)&nlookup | 1;    /* per thread seed */
+    int id = ct->c ? tst_conc_register (ct->c) : 0;
+
+    while (!atomic_load_explicit (&ct->stop, memory_order_relaxed)) {
+        for (int k = 0; k < 256; k++, nlookup++) {
+            const char *w;
+            x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+            w = ct->words[x % ct->n];
+            if (ct->c) {
+                tst_conc_read_begin (ct->c, id);
+                tst_conc_search (ct->c, w);
+                tst_conc_read_end (ct->c, id);
+            }
+            else {
+                mtx_lock (&ct->lock);
+                tst_search (ct->root, w);
+                mtx_unlock (&ct->lock);
+            }
+        }
+    }
+    if (ct->c)
+        tst_conc_unregister (ct->c, id);
+    atomic_fetch_add (&ct->lookups, nlookup);
+
+    return 0;
+}
+
+/** bench_conc writer, delete and insert words at odd index until stopped. */
+static int conc_writer (void *arg)
+{
+    conc_t *ct = arg;
+
+    for (size_t i = 1; !atomic_load (&ct->stop); i = (i + 2) % ct->n) {
+        for (int del = 1; del >= 0; del--) {
+            if (ct->c)
+                tst_conc_ins_del (ct->c, &ct->words[i], del);
+            else {
+                mtx_lock (&ct->lock);
+                tst_ins_del (&ct->root, &ct->words[i], del, REF);
+                mtx_unlock (&ct->lock);
+            }
+        }
+        thrd_yield();
+    }
+
+    return 0;
+}
+
+/** read throughput of 1 - 8 reader threads with one writer deleting and
+ *  inserting words, concurrent tree (tst_conc_*) vs. plain tree with a
+ *  global lock.
+ */
+static void bench_conc (char **words, size_t n)
+{
+    enum { MAXTHRD = 8 };
+    const double secs = 0.5;
+
+    if (n < 2)
+        return;
+
+    for (int kind = 0; kind < 2; kind++) {
+        for (int nthrd = 1; nthrd <= MAXTHRD; nthrd *= 2) {
+            conc_t ct = { .c = NULL, .root = NULL, .words = words, .n = n };
+            thrd_t rd[MAXTHRD], wr;
+            double t1, t2;
+
+            atomic_init (&ct.stop, 0);
+            atomic_init (&ct.lookups, 0);
+            if (kind == 0 && !(ct.c = tst_conc_create (REF)))
+                exit (EXIT_FAILURE);
+            if (kind == 1 && mtx_init (&ct.lock, mtx_plain) != thrd_success)
+                exit (EXIT_FAILURE);
+            for (size_t i = 0; i < n; i++) {
+                if (kind == 0 ? !tst_conc_ins_del (ct.c, &words[i], INS) :
+                        !tst_ins_del (&ct.root, &words[i], INS, REF)) {
+                    fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+                    exit (EXIT_FAILURE);
+                }
+            }
+
+            t1 = tvgetf();
+            for (int i = 0; i < nthrd; i++)
+                thrd_create (&rd[i], conc_reader, &ct);
+            thrd_create (&wr, conc_writer, &ct);
+            while (tvgetf() - t1 < secs)
+                thrd_sleep (&(struct timespec){ .tv_nsec = 10000000 }, NULL);
+            atomic_store (&ct.stop, 1);
+            for (int i = 0; i < nthrd; i++)
+                thrd_join (rd[i], NULL);
+            thrd_join (wr, NULL);
+            t2 = tvgetf();
+
+            printf ("conc     %-6s %d readers  %8.2f M lookups/sec\n",
+                    kind == 0 ? "epoch" : "mutex", nthrd,
+                    atomic_load (&ct.lookups) / (t2 - t1) / 1e6);
+
+            if (kind == 0)
+                tst_conc_destroy (ct.c);
+            else {
+                tst_free (ct.root);
+                mtx_destroy (&ct.lock);
+            }
+        }
+    }
+}
+
+/** persistent tree, snapshot per request of 100 edits (delete of a word in
+ *  the tree, insert otherwise) with the last 1, 10 or 100 snapshots held.
+ *  snapshot and edit time, memory held by the snapshots over the current
+ *  version.
+ */
+static void bench_snapshot (char **words, size_t n)
+{
+    enum { NREQ = 2000, NEDIT = 100, MAXHELD = 100, NSNAP = 1000000 };
+    const int held[] = { 1, 10, 100 };
+
+    if (!n)
+        return;
+
+    for (size_t z = 0; z < sizeof held / sizeof *held; z++) {
+        tst_pers *h = tst_pers_create (REF);
+        node_tst *snap[MAXHELD] = { NULL };
+        size_t h0, h1, h2;
+        double t1, t2, tedit = 0;
+
+        if (!h)
+            exit (EXIT_FAILURE);
+        h0 = heapused();
+        for (size_t i = 0; i < n; i++)
+            if (!tst_pers_ins_del (h, &words[i], INS)) {
+                fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+                exit (EXIT_FAILURE);
+            }
+
+        for (int r = 0; r < NREQ; r++) {
+            int k = r % held[z];
+            if (snap[k])
+                tst_snapshot_release (h, snap[k]);
+            snap[k] = tst_snapshot (h);
+            t1 = tvgetf();
+            for (int e = 0; e < NEDIT; e++) {
+                char **w = &words[rand_int (n)];
+                int del = tst_search (tst_pers_root (h), *w) != NULL;
+                if (!tst_pers_ins_del (h, w, del) && !del)
+                    exit (EXIT_FAILURE);
+            }
+            tedit += tvgetf() - t1;
+        }
+        h1 = heapused();
+        for (int k = 0; k < held[z]; k++)
+            tst_snapshot_release (h, snap[k]);
+        h2 = heapused();                    /* current version alone */
+
+        t1 = tvgetf();
+        for (int i = 0; i < NSNAP; i++)
+            tst_snapshot_release (h, tst_snapshot (h));
+        t2 = tvgetf();
+
+        printf ("snapshot %3d held  %5.1f ns/snapshot  %5.2f us/edit  "
+                "tree %5.1f MB  snapshots +%5.1f MB (%.1f%%)\n", held[z],
+                (t2 - t1) * 1e9 / NSNAP, tedit * 1e6 / NREQ / NEDIT,
+                (h2 - h0) / 1048576.0, (h1 - h2) / 1048576.0,
+                (double)(h1 - h2) * 100 / (h2 - h0));
+
+        tst_pers_destroy (h);
+    }
+}
+
+/** shared state for bench_shard writers, sharded tree or plain tree under
+ *  one lock, words split between writers by first byte.
+ */
+typedef struct {
+    tst_shard *t;
+    node_tst *root;
+    mtx_t lock;
+    char **words;
+    size_t n;
+    int nthrd;
+} shard_t;
+
+typedef struct {
+    shard_t *sh;
+    int id;
+} shard_arg;
+
+/** bench_shard writer, insert then delete the words whose first byte
+ *  falls to writer 'id'.
+ */
+static int shard_writer (void *arg)
+{
+    shard_arg *sa = arg;
+    shard_t *sh = sa->sh;
+
+    for (int del = INS; del <= DEL; del++)
+        for (size_t i = 0; i < sh->n; i++) {
+            char **w = &sh->words[i];
+            if ((unsigned char)**w % sh->nthrd != sa->id)
+                continue;
+            if (sh->t)
+                tst_shard_ins_del (sh->t, w, del, REF);
+            else {
+                mtx_lock (&sh->lock);
+                tst_ins_del (&sh->root, w, del, REF);
+                mtx_unlock (&sh->lock);
+            }
+        }
+
+    return 0;
+}
+
+/** first byte dispatch, lookup time for words inserted in file order in
+ *  one tree vs. the sharded tree, and insert/delete time of 4 writers
+ *  split by first byte on the sharded tree vs. one tree under one lock.
+ */
+static void bench_shard (char **words, size_t n)
+{
+    enum { NWRT = 4 };
+    node_tst *root = NULL;
+    tst_shard *t = tst_shard_create();
+    char **keys = NULL;
+    size_t cmp = 0;
+    double t1, t2;
+
+    if (!n || !t)
+        return;
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF) ||
+                !tst_shard_ins_del (t, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    keys = lookup_keys (words, n);
+    for (size_t i = 0; i < n; i++)          /* top-level walk before shard */
+        cmp += tst_search_cmp (root, keys[i]);
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_search (root, keys[i]))
+            exit (EXIT_FAILURE);
+    t2 = tvgetf();
+    printf ("shard    tree      %6.1f ns/lookup  %.1f cmp/lookup\n",
+            (t2 - t1) * 1e9 / n, (double)cmp / n);
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        if (!tst_shard_search (t, keys[i]))
+            exit (EXIT_FAILURE);
+    t2 = tvgetf();
+    printf ("shard    sharded   %6.1f ns/lookup  (locked)\n",
+            (t2 - t1) * 1e9 / n);
+
+    tst_shard_destroy (t, 0);
+    tst_free (root);
+    free (keys);
+
+    for (int kind = 0; kind < 2; kind++) {  /* 4 writers */
+        shard_t sh = { .t = NULL, .root = NULL, .words = words, .n = n,
+                        .nthrd = NWRT };
+        shard_arg sa[NWRT];
+        thrd_t tid[NWRT];
+
+        if (kind == 0 && !(sh.t = tst_shard_create()))
+            exit (EXIT_FAILURE);
+        if (kind == 1 && mtx_init (&sh.lock, mtx_plain) != thrd_success)
+            exit (EXIT_FAILURE);
+        t1 = tvgetf();
+        for (int i = 0; i < NWRT; i++) {
+            sa[i] = (shard_arg){ .sh = &sh, .id = i };
+            thrd_create (&tid[i], shard_writer, &sa[i]);
+        }
+        for (int i = 0; i < NWRT; i++)
+            thrd_join (tid[i], NULL);
+        t2 = tvgetf();
+        printf ("shard    %d writers %-8s %6.1f ns/op\n", NWRT,
+                kind == 0 ? "sharded" : "1 lock", (t2 - t1) * 1e9 / (2 * n));
+        if (kind == 0)
+            tst_shard_destroy (sh.t, 0);
+        else {
+            tst_free (sh.root);
+            mtx_destroy (&sh.lock);
+        }
+    }
+}
+
+/** tst_build_sorted() vs. tst_build_parallel() at 1 - 16 threads, copy
+ *  build of the words in file order, time and speedup over serial. the
+ *  heap is trimmed after each free so every build starts from the same
+ *  heap (reuse of a fragmented heap otherwise skews later builds).
+ */
+static void bench_parallel (char **words, size_t n)
+{
+    static const int nthreads[] = { 1, 2, 4, 8, 16 };
+    node_tst *root = NULL;
+    double t1, t2, serial;
+
+    t1 = tvgetf();
+    if (n && !tst_build_sorted (&root, words, n, CPY)) {
+        fprintf (stderr, "error: memory exhausted, tst_build_sorted.\n");
+        exit (EXIT_FAILURE);
+    }
+    t2 = tvgetf();
+    serial = t2 - t1;
+    tst_free_all (root);
+    malloc_trim (0);
+    printf ("parallel serial   %.6f sec\n", serial);
+
+    for (size_t i = 0; i < sizeof nthreads / sizeof *nthreads; i++) {
+        root = NULL;
+        t1 = tvgetf();
+        if (n && !tst_build_parallel (&root, words, n, CPY, nthreads[i])) {
+            fprintf (stderr, "error: memory exhausted, tst_build_parallel.\n");
+            exit (EXIT_FAILURE);
+        }
+        t2 = tvgetf();
+        tst_free_all (root);
+        malloc_trim (0);
+        printf ("parallel %2d thr   %.6f sec   %.2fx\n",
+                nthreads[i], t2 - t1, serial / (t2 - t1));
+    }
+}
+
+/** lookup time of tst_search() vs. tst_search_len() (lengths known) for
+ *  the words, then for URL-like keys of 200 - 400 chars (past the former
+ *  128 char limit) made of several words.
+ */
+static void bench_len (char **words, size_t n)
+{
+    enum { NLOOKUP = 1000000, URLMIN = 200 };
+    const size_t nurl = n < 100000 ? n : 100000;
+    char **urls;
+    size_t *lens, *order;
+
+    if (!n)
+        return;
+    urls = malloc (nurl * sizeof *urls);
+    lens = malloc (n * sizeof *lens);
+    order = malloc (NLOOKUP * sizeof *order);
+    if (!urls || !lens || !order) {
+        fprintf (stderr, "error: memory exhausted, len keys.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < nurl; i++) {     /* scheme, host, word path */
+        char url[LMAX];
+        int len = sprintf (url, "https://example.com");
+        for (size_t j = i; len < URLMIN; j = (j * 7 + 1) % n)
+            len += sprintf (url + len, "/%.40s", words[j]);
+        if (!(urls[i] = malloc (len + 1))) {
+            fprintf (stderr, "error: memory exhausted, len keys.\n");
+            exit (EXIT_FAILURE);
+        }
+        memcpy (urls[i], url, len + 1);
+    }
+
+    for (int set = 0; set < 2; set++) {
+        char **keys = set ? urls : words;
+        size_t nkeys = set ? nurl : n, found = 0, flen = 0;
+        node_tst *root = NULL;
+        double t1, t2, t3;
+
+        for (size_t i = 0; i < nkeys; i++) {
+            lens[i] = strlen (keys[i]);
+            if (!tst_ins_del (&root, &keys[i], INS, REF)) {
+                fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+                exit (EXIT_FAILURE);
+            }
+        }
+        for (size_t i = 0; i < NLOOKUP; i++)
+            order[i] = rand_int (nkeys);
+
+        t1 = tvgetf();
+        for (size_t i = 0; i < NLOOKUP; i++)
+            found += tst_search (root, keys[order[i]]) != NULL;
+        t2 = tvgetf();
+        for (size_t i = 0; i < NLOOKUP; i++)
+            flen += tst_search_len (root, keys[order[i]], lens[order[i]]) != NULL;
+        t3 = tvgetf();
+
+        printf ("len      %-5s  search %6.1f ns  search_len %6.1f ns  "
+                "(%zu/%zu found)\n", set ? "urls" : "words",
+                (t2 - t1) / NLOOKUP * 1e9, (t3 - t2) / NLOOKUP * 1e9,
+                found, flen);
+        tst_free (root);
+    }
+
+    for (size_t i = 0; i < nurl; i++)
+        free (urls[i]);
+    free (urls);
+    free (lens);
+    free (order);
+}
+
+/** load of a word file into a reference tree, fscanf(), malloc() and copy
+ *  of each word (as tst_test_ref) vs. tst_load_mapped(), in MB/sec of file
+ *  (file just written, so in the page cache). both are dominated by the
+ *  insertion of the words, the difference is the cost of reading them.
+ */
+static void bench_mapped (char **words, size_t n)
+{
+    const char *txt = "tst_bench.txt";
+    char word[WRDMAX], **ptrs = NULL;
+    size_t nptrs = 0, nread = 0, bytes = 0;
+    node_tst *root = NULL;
+    tst_mapped *m;
+    FILE *fp;
+    double t1, t2;
+
+    if (!(fp = fopen (txt, "w"))) {
+        fprintf (stderr, "error: file open failed '%s'.\n", txt);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+        bytes += fprintf (fp, "%s\n", words[i]);
+    fclose (fp);
+
+    t1 = tvgetf();
+    if (!(fp = fopen (txt, "r")))
+        exit (EXIT_FAILURE);
+    while (fscanf (fp, "%255s", word) == 1) {
+        size_t len = strlen (word);
+        if (nread == nptrs) {
+            void *tmp = realloc (ptrs, (nptrs ? 2 * nptrs : WRDMAX) * sizeof *ptrs);
+            if (!tmp)
+                exit (EXIT_FAILURE);
+            ptrs = tmp;
+            nptrs = nptrs ? 2 * nptrs : WRDMAX;
+        }
+        if (!(ptrs[nread] = malloc (len + 1)))
+            exit (EXIT_FAILURE);
+        memcpy (ptrs[nread], word, len + 1);
+        if (!tst_ins_del (&root, &ptrs[nread++], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    fclose (fp);
+    t2 = tvgetf();
+    printf ("mapped   fscanf   %.6f sec   %7.1f MB/sec   %zu words\n",
+            t2 - t1, bytes / (t2 - t1) / 1e6, nread);
+    tst_free (root);
+    root = NULL;
+    for (size_t i = 0; i < nread; i++)
+        free (ptrs[i]);
+    free (ptrs);
+    malloc_trim (0);                        /* same heap for both loads */
+
+    t1 = tvgetf();
+    if (!(m = tst_load_mapped (txt, &root)))
+        exit (EXIT_FAILURE);
+    t2 = tvgetf();
+    printf ("mapped   mmap     %.6f sec   %7.1f MB/sec   %zu words\n",
+            t2 - t1, bytes / (t2 - t1) / 1e6, tst_mapped_words (m));
+    tst_mapped_free (m);
+
+    remove (txt);
+}
+
+/** shape of the tree built in file order, shuffled and bulk loaded, and
+ *  the hot-path counters of a lookup of each word and a prefix search of
+ *  the first 2 chars of each (counters need make stats=-DTST_STATS).
+ */
+static void bench_stats (char **words, size_t n)
+{
+    const char *name[] = { "file", "shuffled", "bulk" };
+    char **keys = lookup_keys (words, n), *a[WRDMAX];
+
+    for (int t = 0; t < 3; t++) {
+        node_tst *root = NULL;
+        tst_counters_t c;
+        tst_stats_t st;
+        int na;
+
+        if (t < 2) {
+            char **src = t ? keys : words;
+            for (size_t i = 0; i < n; i++)
+                if (!tst_ins_del (&root, &src[i], INS, REF)) {
+                    fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+                    exit (EXIT_FAILURE);
+                }
+        }
+        else if (n && !tst_build_sorted (&root, words, n, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_build_sorted.\n");
+            exit (EXIT_FAILURE);
+        }
+
+        tst_stats (root, &st);
+        printf ("stats    %-8s %zu nodes   sibling height %zu   "
+                "path %.2f mean %zu worst\n", name[t], st.nodes, st.sib_max,
+                st.avg_cmps, st.worst_cmps);
+
+        tst_counters_reset();
+        for (size_t i = 0; i < n; i++)
+            tst_search (root, keys[i]);
+        for (size_t i = 0; i < n; i++) {
+            char pre[3] = { keys[i][0], keys[i][0] ? keys[i][1] : 0, 0 };
+            tst_search_prefix (root, pre, a, &na, WRDMAX);
+        }
+        tst_counters_get (&c);
+        if (c.search.calls)
+            printf ("stats    %-8s search %.2f nodes %.2f tests/call   "
+                    "prefix %.2f nodes %.2f tests/call\n", name[t],
+                    (double)c.search.nodes / c.search.calls,
+                    (double)c.search.cmps / c.search.calls,
+                    (double)c.prefix.nodes / c.prefix.calls,
+                    (double)c.prefix.cmps / c.prefix.calls);
+
+        tst_free (root);
+    }
+    free (keys);
+}
+
+/** search each key of 'c' in its wide tree (plain tree for level 0). */
+static void wide_search (core_t *c)
+{
+    for (size_t i = 0; i < c->n; i++)
+        c->found += (c->level ? tst_wide_search (c->root, c->keys[i])
+                              : tst_search (c->root, c->keys[i])) != NULL;
+}
+
+/** lookup time of a plain tree and of wide trees (sibling levels of 'min'
+ *  or more nodes searched as one key array) for a range of 'min', all
+ *  built in random order, with the wide levels, node bytes and mean path
+ *  of each tree.
+ */
+static void bench_wide (char **words, size_t n)
+{
+    const int mins[] = { 0, 4, 8, 16, 32 };
+    char **keys = lookup_keys (words, n), **miss = miss_keys (keys, n);
+
+    for (size_t m = 0; m < sizeof mins / sizeof *mins; m++) {
+        core_t c = { .keys = keys, .n = n, .level = mins[m] };
+        char name[16], hit[24], nohit[24];
+        tst_stats_t st;
+
+        for (size_t i = 0; i < n; i++)
+            if (!(c.level ? tst_wide_ins_del (&c.root, &keys[i], INS, REF,
+                                                c.level)
+                          : tst_ins_del (&c.root, &keys[i], INS, REF))) {
+                fprintf (stderr, "error: memory exhausted, tst_wide_insert.\n");
+                exit (EXIT_FAILURE);
+            }
+        if (c.level)
+            sprintf (name, "min%d", c.level);
+        else
+            strcpy (name, "plain");
+        sprintf (hit, "%s_hit", name);
+        sprintf (nohit, "%s_miss", name);
+
+        tst_stats (c.root, &st);
+        report_value ("wide", name, "wide", st.wide, "levels");
+        report_value ("wide", name, "nodes", st.node_bytes, "bytes");
+        report_value ("wide", name, "path", st.avg_cmps, "cmps");
+        timed ("wide", hit, n, NULL, wide_search, NULL, &c);
+        if (c.found != n)
+            fprintf (stderr, "error: wide, %zu of %zu words found.\n",
+                    c.found, n);
+        c.keys = miss;
+        timed ("wide", nohit, n, NULL, wide_search, NULL, &c);
+        if (c.found)
+            fprintf (stderr, "error: wide, %zu misses found.\n", c.found);
+
+        tst_free (c.root);
+    }
+
+    free_keys (miss, n);
+    free (keys);
+}
+
+/** search each key of 'c' in its burst tree (plain tree for level 0). */
+static void burst_search (core_t *c)
+{
+    for (size_t i = 0; i < c->n; i++)
+        c->found += (c->level ? tst_burst_search (c->root, c->keys[i])
+                              : tst_search (c->root, c->keys[i])) != NULL;
+}
+
+/** heap use and lookup time of a plain tree and of burst trees for a
+ *  range of bucket 'max', all built by reference in random order, with
+ *  the buckets and mean path of each tree.
+ */
+static void bench_burst (char **words, size_t n)
+{
+    const int maxs[] = { 0, 4, 8, 16, 32, 64 };
+    char **keys = lookup_keys (words, n), **miss = miss_keys (keys, n);
+
+    for (size_t m = 0; m < sizeof maxs / sizeof *maxs; m++) {
+        core_t c = { .keys = keys, .n = n, .level = maxs[m] };
+        char name[16], hit[24], nohit[24];
+        size_t h1 = heapused(), h2;
+        tst_stats_t st;
+
+        for (size_t i = 0; i < n; i++)
+            if (!(c.level ? tst_burst_ins_del (&c.root, &keys[i], INS, REF,
+                                                c.level)
+                          : tst_ins_del (&c.root, &keys[i], INS, REF))) {
+                fprintf (stderr, "error: memory exhausted, tst_burst_insert.\n");
+                exit (EXIT_FAILURE);
+            }
+        h2 = heapused();
+        if (c.level)
+            sprintf (name, "max%d", c.level);
+        else
+            strcpy (name, "plain");
+        sprintf (hit, "%s_hit", name);
+        sprintf (nohit, "%s_miss", name);
+
+        tst_stats (c.root, &st);
+        report_value ("burst", name, "buckets", st.buckets, "buckets");
+        report_value ("burst", name, "heap", h2 - h1, "bytes");
+        report_value ("burst", name, "path", st.avg_cmps, "cmps");
+        timed ("burst", hit, n, NULL, burst_search, NULL, &c);
+        if (c.found != n)
+            fprintf (stderr, "error: burst, %zu of %zu words found.\n",
+                    c.found, n);
+        c.keys = miss;
+        timed ("burst", nohit, n, NULL, burst_search, NULL, &c);
+        if (c.found)
+            fprintf (stderr, "error: burst, %zu misses found.\n", c.found);
+
+        tst_free (c.root);
+        malloc_trim (0);                    /* same heap for each tree */
+    }
+
+    free_keys (miss, n);
+    free (keys);
+}
+
+/** open addressing hash of word to value, the second lookup a tree
+ *  without values needs for a value held elsewhere.
+ */
+typedef struct {
+    char **key;
+    uint64_t *val;
+    size_t mask;
+} hmap_t;
+
+static size_t hmap_hash (const char *s)
+{
+    size_t h = 14695981039346656037u;       /* FNV-1a */
+
+    while (*s)
+        h = (h ^ (unsigned char)*s++) * 1099511628211u;
+
+    return h;
+}
+
+static uint64_t *hmap_slot (hmap_t *h, char *s)
+{
+    size_t i = hmap_hash (s) & h->mask;
+
+    while (h->key[i] && strcmp (h->key[i], s))
+        i = (i + 1) & h->mask;
+    h->key[i] = s;
+
+    return &h->val[i];
+}
+
+/** lookup of key and value with a map (value in the word node) vs. a tree
+ *  and a hash map of values, and counting with tst_map_upsert().
+ */
+static void bench_map (char **words, size_t n)
+{
+    char **keys = lookup_keys (words, n);
+    node_tst *root = NULL, *map = NULL;
+    hmap_t h = { NULL, NULL, 0 };
+    uint64_t sum1 = 0, sum2 = 0;
+    size_t sz = 2;
+    double t1, t2;
+
+    while (sz < 2 * n)
+        sz *= 2;
+    h.mask = sz - 1;
+    h.key = calloc (sz, sizeof *h.key);
+    h.val = calloc (sz, sizeof *h.val);
+    if (!h.key || !h.val) {
+        fprintf (stderr, "error: memory exhausted, hash map.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        tst_value v = { .u = i };
+        if (!tst_ins_del (&root, &keys[i], INS, REF) ||
+                !tst_map_put (&map, &keys[i], REF, v)) {
+            fprintf (stderr, "error: memory exhausted, tst_map_put.\n");
+            exit (EXIT_FAILURE);
+        }
+        *hmap_slot (&h, keys[i]) = i;
+    }
+    shuffle_ptrs (keys, n);
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++) {
+        char *s = tst_search (root, keys[i]);
+        if (s)
+            sum1 += *hmap_slot (&h, s);
+    }
+    t2 = tvgetf();
+    printf ("map      tree+hash %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++) {
+        const tst_value *v = tst_map_get (map, keys[i]);
+        if (v)
+            sum2 += v->u;
+    }
+    t2 = tvgetf();
+    printf ("map      map_get   %6.1f ns/lookup\n", (t2 - t1) * 1e9 / n);
+    if (sum1 != sum2)
+        fprintf (stderr, "error: map, value sums differ.\n");
+
+    t1 = tvgetf();
+    for (size_t i = 0; i < n; i++)
+        tst_map_upsert (&map, &keys[i], REF, NULL)->u++;
+    t2 = tvgetf();
+    printf ("map      upsert    %6.1f ns/update\n", (t2 - t1) * 1e9 / n);
+
+    free (h.key);
+    free (h.val);
+    tst_free (map);
+    tst_free (root);
+    free (keys);
+}
+
+/** match callback, sum match lengths so the scan is not elided. */
+static void sum_match (const node_tst *node, size_t off, size_t len,
+                        void *data)
+{
+    *(size_t *)data += len;
+    (void)node;
+    (void)off;
+}
+
+/** split the words in random order, run together, into longest matches,
+ *  tst_longest_scan() vs. tst_search() of shorter and shorter slices of
+ *  the text at each position, each from the root.
+ */
+static void bench_longest (char **words, size_t n)
+{
+    char **keys = lookup_keys (words, n), *text, *p, buf[WRDMAX];
+    node_tst *root = NULL;
+    size_t len = 0, maxlen = 0, m1 = 0, m2 = 0, sum1 = 0, sum2 = 0;
+    double t1, t2;
+
+    for (size_t i = 0; i < n; i++) {
+        size_t l = strlen (keys[i]);
+        if (l > maxlen)
+            maxlen = l;
+        len += l;
+        if (!tst_ins_del (&root, &keys[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    if (maxlen >= WRDMAX)
+        maxlen = WRDMAX - 1;
+    shuffle_ptrs (keys, n);
+    if (!(p = text = malloc (len + 1))) {
+        fprintf (stderr, "error: memory exhausted, text.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t l = strlen (keys[i]);
+        memcpy (p, keys[i], l);
+        p += l;
+    }
+    *p = 0;
+
+    t1 = tvgetf();
+    for (size_t off = 0; off < len;) {
+        size_t l = len - off < maxlen ? len - off : maxlen;
+        for (; l; l--) {
+            memcpy (buf, text + off, l);
+            buf[l] = 0;
+            if (tst_search (root, buf))
+                break;
+        }
+        if (l) {
+            m1++;
+            sum1 += l;
+            off += l;
+        }
+        else
+            off++;
+    }
+    t2 = tvgetf();
+    printf ("longest  search    %6.1f ns/match  %zu matches\n",
+            (t2 - t1) * 1e9 / m1, m1);
+
+    t1 = tvgetf();
+    m2 = tst_longest_scan (root, text, len, sum_match, &sum2);
+    t2 = tvgetf();
+    printf ("longest  scan      %6.1f ns/match  %zu matches\n",
+            (t2 - t1) * 1e9 / m2, m2);
+    if (m1 != m2 || sum1 != sum2)
+        fprintf (stderr, "error: longest, matches %zu != %zu.\n", m1, m2);
+
+    free (text);
+    tst_free (root);
+    free (keys);
+}
+
+/** available benchmarks, run in order if none named on command line. */
+static const bench_t benches[] = {
+    { "insert", bench_insert },
+    { "lookup", bench_lookup },
+    { "prefix", bench_prefix },
+    { "delete", bench_delete },
+    { "traverse", bench_traverse },
+    { "arena", bench_arena },
+    { "layout", bench_layout },
+    { "frozen", bench_frozen },
+    { "image", bench_image },
+    { "build", bench_build },
+    { "path", bench_path },
+    { "keyless", bench_keyless },
+    { "cursor", bench_cursor },
+    { "topk", bench_topk },
+    { "fuzzy", bench_fuzzy },
+    { "pattern", bench_pattern },
+    { "batch", bench_batch },
+    { "conc", bench_conc },
+    { "snapshot", bench_snapshot },
+    { "shard", bench_shard },
+    { "parallel", bench_parallel },
+    { "len", bench_len },
+    { "mapped", bench_mapped },
+    { "stats", bench_stats },
+    { "wide", bench_wide },
+    { "burst", bench_burst },
+    { "map", bench_map },
+    { "longest", bench_longest },
+};
+static const size_t nbenches = sizeof benches / sizeof *benches;
+
+/** usage, options before the words file, benchmark names after it. */
+static void usage (const char *prog)
+{
+    fprintf (stderr, "usage: %s [-r reps] [-w warmup] [-t] file [bench ...]\n"
+                    "  -r reps    timed runs of each case (1 - %d, default 5)\n"
+                    "  -w warmup  untimed runs before (default 1)\n"
+                    "  -t         tab-separated results: bench case metric "
+                    "value unit\n", prog, REPMAX);
+}
+
+int main (int argc, char **argv) {
+
+    char word[WRDMAX] = "",
+        **words = NULL;
+    size_t idx = 0, nptrs = WRDMAX;
+    int arg = 1;
+    FILE *fp;
+    struct rusage ru;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {  /* options */
+        if (!strcmp (argv[arg], "-t"))
+            cfg.tsv = 1;
+        else if (!strcmp (argv[arg], "-r") && arg + 1 < argc)
+            cfg.reps = atoi (argv[++arg]);
+        else if (!strcmp (argv[arg], "-w") && arg + 1 < argc)
+            cfg.warmup = atoi (argv[++arg]);
+        else {
+            usage (argv[0]);
+            return 1;
+        }
+    }
+    if (cfg.reps < 1 || cfg.reps > REPMAX || cfg.warmup < 0) {
+        usage (argv[0]);
+        return 1;
+    }
+
+    fp = arg < argc ? fopen (argv[arg], "r") : stdin;
+    if (!fp) {  /* validate file open for reading */
+        fprintf (stderr, "error: file open failed '%s'.\n", argv[arg]);
+        return 1;
+    }
+
+    if (!(words = calloc (nptrs, sizeof *words))) {
+        fprintf (stderr, "error: memory exhausted words ptrs.");
+        return 1;
+    }
+
+    while (fscanf (fp, "%255s", word) == 1) {   /* read words, 1 per-line */
+        size_t len = strlen (word);
+        if (!(words[idx] = malloc (len + 1))) {
+            fprintf (stderr, "error: memory exhausted, words[%zu]\n", idx);
+            return 1;
+        }
+        memcpy (words[idx], word, len + 1);
+        if (++idx == nptrs)         /* realloc as required */
+            words = xrealloc (words, sizeof *words, &nptrs);
+    }
+    if (fp != stdin) fclose (fp);   /* close file if not stdin */
+    if (cfg.tsv)
+        printf ("# tst_bench words %zu reps %d warmup %d\n",
+                idx, cfg.reps, cfg.warmup);
+    else
+        printf ("tst_bench, loaded %zu words.\n\n", idx);
+
+    for (size_t i = 0; i < nbenches; i++) {   /* run named or all benches */
+        int run = argc < arg + 2;
+        for (int j = arg + 1; j < argc && !run; j++)
+            run = strcmp (argv[j], benches[i].name) == 0;
+        if (run)
+            benches[i].fn (words, idx);
+    }
+
+    if (getrusage (RUSAGE_SELF, &ru) == 0)  /* ru_maxrss in KB (Linux) */
+        report_value ("rss", "process", "peak", ru.ru_maxrss, "KB");
+
+    for (size_t i = 0; i < idx; i++)
+        free (words[i]);
+    free (words);
+
+    return 0;
+}
@@ -0,0 +1,2198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ternary_st.h"
+
+/** constants insert, delete, max word(s) & stack nodes */
+enum { INS, DEL, WRDMAX = 256, STKMAX = 512, LMAX = 1024 };
+#define REF INS
+#define CPY DEL
+
+/** realloc 'ptr' of 'nelem' of 'psz' to 'nelem * 2' of 'psz'.
+ *  returns pointer to reallocated block of memory with new
+ *  memory initialized to 0/NULL. return must be assigned to
+ *  original pointer in caller.
+ */
+void *xrealloc (void *ptr, size_t psz, size_t *nelem)
+{
+    void *memptr = realloc ((char *)ptr, *nelem * 2 * psz);
+    if (!memptr) {
+        fprintf (stderr, "realloc() error: virtual memory exhausted.\n");
+        exit (EXIT_FAILURE);
+    }
+    /* zero new memory (optional) */
+    memset ((char *)memptr + *nelem * psz, 0, *nelem * psz);
+    *nelem *= 2;
+
+    return memptr;
+}
+
+/** rand_int for use with shuffle */
+static int rand_int (int n)
+{
+    int limit = RAND_MAX - RAND_MAX % n, rnd;
+
+    rnd = rand();
+    for (; rnd >= limit; )
+        rnd = rand();
+
+    return rnd % n;
+}
+
+static int cmp_str (const void *a, const void *b)
+{
+    return strcmp (*(char * const *)a, *(char * const *)b);
+}
+
+/** sorted copy of the pointers in 'words' with duplicates removed, the
+ *  number kept in 'nuniq', the expected contents of a tree of 'words'.
+ */
+static char **unique_words (char **words, size_t n, size_t *nuniq)
+{
+    char **u = malloc ((n ? n : 1) * sizeof *u);
+    size_t k = 0;
+
+    if (!u) {
+        fprintf (stderr, "error: memory exhausted, unique words.\n");
+        exit (EXIT_FAILURE);
+    }
+    memcpy (u, words, n * sizeof *u);
+    qsort (u, n, sizeof *u, cmp_str);
+    for (size_t i = 0; i < n; i++)
+        if (!k || strcmp (u[k - 1], u[i]))
+            u[k++] = u[i];
+    *nuniq = k;
+
+    return u;
+}
+
+/** compare 'n' words in 'got' (sorted here) with the 'nexp' words expected
+ *  in 'exp' (sorted). returns 0 if the same, 1 otherwise (reported as
+ *  'check' for 'query').
+ */
+static int same_words (const char *check, const char *query,
+                        char **got, size_t n, char **exp, size_t nexp)
+{
+    qsort (got, n, sizeof *got, cmp_str);
+    for (size_t i = 0; i < n && i < nexp; i++)
+        if (strcmp (got[i], exp[i])) {
+            fprintf (stderr, "error: %s '%s', got '%s' expected '%s'.\n",
+                    check, query, got[i], exp[i]);
+            return 1;
+        }
+    if (n != nexp) {
+        fprintf (stderr, "error: %s '%s', %zu words expected %zu.\n",
+                check, query, n, nexp);
+        return 1;
+    }
+
+    return 0;
+}
+
+/** a word of 'words' with one random edit (none, substitute, delete or
+ *  insert a char) in 'query' of WRDMAX chars.
+ */
+static void edited_word (char **words, size_t n, char *query)
+{
+    const char *w = words[rand_int (n)];
+    size_t len = strlen (w), at;
+
+    if (len + 2 > WRDMAX)
+        len = WRDMAX - 2;
+    memcpy (query, w, len);
+    query[len] = 0;
+    at = rand_int (len + 1);
+    switch (rand_int (4)) {
+        case 1: if (at < len) query[at] = 'a' + rand_int (26);
+                break;
+        case 2: if (at < len) memmove (query + at, query + at + 1, len - at);
+                break;
+        case 3: memmove (query + at + 1, query + at, len - at + 1);
+                query[at] = 'a' + rand_int (26);
+                break;
+    }
+}
+
+/** Levenshtein distance of 'a' and 'b', or if 'prefix' is non-zero the
+ *  least distance of any prefix of 'a' to 'b'.
+ */
+static int levenshtein (const char *a, const char *b, const int prefix)
+{
+    int row[LMAX], tmp[LMAX], best;
+    size_t m = strlen (b);
+
+    if (m >= LMAX)
+        return LMAX;
+    for (size_t j = 0; j <= m; j++)
+        row[j] = j;
+    best = m;
+    for (; *a; a++) {
+        tmp[0] = row[0] + 1;
+        for (size_t j = 1; j <= m; j++) {
+            int d = row[j - 1] + (b[j - 1] != *a);
+            if (row[j] + 1 < d)
+                d = row[j] + 1;
+            if (tmp[j - 1] + 1 < d)
+                d = tmp[j - 1] + 1;
+            tmp[j] = d;
+        }
+        memcpy (row, tmp, (m + 1) * sizeof *row);
+        if (row[m] < best)
+            best = row[m];
+    }
+
+    return prefix ? best : row[m];
+}
+
+/** tst_search_fuzzy() and tst_search_fuzzy_prefix() at distance 0 to 2 for
+ *  edited words vs. a Levenshtein scan of all words.
+ */
+static int check_fuzzy (char **words, size_t n)
+{
+    enum { NQ = 100 };
+    node_tst *root = NULL;
+    char query[WRDMAX], **u, **got, **exp;
+    size_t nu, nexp, nmatch = 0;
+    int fail = 0;
+
+    if (!n)
+        return 0;
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    u = unique_words (words, n, &nu);
+    got = malloc (nu * sizeof *got);
+    exp = malloc (nu * sizeof *exp);
+    if (!got || !exp) {
+        fprintf (stderr, "error: memory exhausted, match arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    for (size_t q = 0; q < NQ && !fail; q++) {
+        edited_word (words, n, query);
+        for (int maxdist = 0; maxdist <= 2 && !fail; maxdist++)
+            for (int prefix = 0; prefix <= 1 && !fail; prefix++) {
+                int ngot = prefix ?
+                    tst_search_fuzzy_prefix (root, query, maxdist, got, nu) :
+                    tst_search_fuzzy (root, query, maxdist, got, nu);
+                nexp = 0;
+                for (size_t i = 0; i < nu; i++)
+                    if (levenshtein (u[i], query, prefix) <= maxdist)
+                        exp[nexp++] = u[i];
+                if (ngot < 0) {
+                    fprintf (stderr, "error: fuzzy '%s', search failed.\n",
+                            query);
+                    fail = 1;
+                }
+                else
+                    fail = same_words (prefix ? "fuzzy prefix" : "fuzzy",
+                                        query, got, ngot, exp, nexp);
+                nmatch += nexp;
+            }
+    }
+    printf ("fuzzy    %d queries, %zu matches  %s\n", NQ, nmatch,
+            fail ? "FAILED" : "ok");
+
+    free (exp);
+    free (got);
+    free (u);
+    tst_free (root);
+
+    return fail;
+}
+
+/** naive match of 's' to pattern 'pat' ('?' any char, '*' any run). */
+static int globmatch (const char *pat, const char *s)
+{
+    if (!*pat)
+        return !*s;
+    if (*pat == '*')
+        return globmatch (pat + 1, s) || (*s && globmatch (pat, s + 1));
+
+    return *s && (*pat == '?' || *pat == *s) && globmatch (pat + 1, s + 1);
+}
+
+/** pattern from a word of 'words' in 'pat': chars replaced by '?' and a
+ *  run of chars (possibly empty) replaced by '*', at random.
+ */
+static void pattern_of (char **words, size_t n, char *pat)
+{
+    const char *w = words[rand_int (n)];
+    size_t len = strlen (w), i = 0, j = 0, from, to;
+    int star = rand_int (3);
+
+    if (len > 40)
+        len = 40;
+    from = rand_int (len + 1);
+    to = from + rand_int (len - from + 1);
+    for (; i <= len; i++) {
+        if (star && i == from) {
+            pat[j++] = '*';
+            i = to < len ? to : len;
+        }
+        if (i < len)
+            pat[j++] = rand_int (4) ? w[i] : '?';
+    }
+    pat[j] = 0;
+}
+
+/** tst_search_pattern() for patterns made from words vs. a naive match of
+ *  all words.
+ */
+static int check_pattern (char **words, size_t n)
+{
+    enum { NQ = 300 };
+    node_tst *root = NULL;
+    char pat[WRDMAX], **u, **got, **exp;
+    size_t nu, nexp, nmatch = 0;
+    int fail = 0;
+
+    if (!n)
+        return 0;
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&root, &words[i], INS, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_insert.\n");
+            exit (EXIT_FAILURE);
+        }
+    u = unique_words (words, n, &nu);
+    got = malloc (nu * sizeof *got);
+    exp = malloc (nu * sizeof *exp);
+    if (!got || !exp) {
+        fprintf (stderr, "error: memory exhausted, match arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    for (size_t q = 0; q < NQ && !fail; q++) {
+        int ngot = 0;
+        if (q < 2)                          /* every word, no word */
+            strcpy (pat, q ? "?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?" : "*");
+        else
+            pattern_of (words, n, pat);
+        if (!tst_search_pattern (root, pat, got, &ngot, nu))
+            ngot = 0;
+        nexp = 0;
+        for (size_t i = 0; i < nu; i++)
+            if (globmatch (pat, u[i]))
+                exp[nexp++] = u[i];
+        fail = same_words ("pattern", pat, got, ngot, exp, nexp);
+        nmatch += nexp;
+    }
+    printf ("pattern  %d queries, %zu matches  %s\n", NQ, nmatch,
+            fail ? "FAILED" : "ok");
+
+    free (exp);
+    free (got);
+    free (u);
+    tst_free (root);
+
+    return fail;
+}
+
+/** words of a tree in traversal order (see tst_traverse_fn()). */
+typedef struct {
+    char **w;
+    size_t n;
+} word_list;
+
+static void add_word (const void *node, void *data)
+{
+    word_list *l = data;
+
+    l->w[l->n++] = tst_get_string (node);
+}
+
+/** compare the words of trees 'a' and 'b' in traversal order and the
+ *  result of fuzzy and pattern searches of each. returns 0 if the same,
+ *  1 otherwise (reported as 'check').
+ */
+static int same_trees (const char *check, const node_tst *a,
+                        const node_tst *b, char **words, size_t n,
+                        char **got, char **exp, size_t nu)
+{
+    word_list la = { .w = got, .n = 0 }, lb = { .w = exp, .n = 0 };
+    char query[WRDMAX];
+
+    tst_traverse_fn (a, add_word, &la);
+    tst_traverse_fn (b, add_word, &lb);
+    for (size_t i = 0; i < la.n && i < lb.n; i++)
+        if (strcmp (la.w[i], lb.w[i])) {
+            fprintf (stderr, "error: %s traverse, got '%s' expected '%s'.\n",
+                    check, la.w[i], lb.w[i]);
+            return 1;
+        }
+    if (la.n != lb.n) {
+        fprintf (stderr, "error: %s traverse, %zu words expected %zu.\n",
+                check, la.n, lb.n);
+        return 1;
+    }
+
+    for (int q = 0; q < 10; q++) {
+        int na = 0, nb = 0;
+        edited_word (words, n, query);
+        na = tst_search_fuzzy (a, query, 1, got, nu);
+        nb = tst_search_fuzzy (b, query, 1, exp, nu);
+        if (na < 0 || nb < 0 ||
+                same_words (check, query, got, na, exp, nb))
+            return 1;
+        pattern_of (words, n, query);
+        if (!tst_search_pattern (a, query, got, &na, nu))
+            na = 0;
+        if (!tst_search_pattern (b, query, exp, &nb, nu))
+            nb = 0;
+        if (same_words (check, query, got, na, exp, nb))
+            return 1;
+    }
+
+    return 0;
+}
+
+/** tree checked against a plain tree by check_ops(), through its own
+ *  insert/delete, search and prefix search on handle 't'. 'root' (if not
+ *  NULL) gives the tree for traversal, fuzzy and pattern search, and
+ *  'rebalance' (if not NULL) is applied before they are compared again.
+ *  words held by copy ('cpy' non-zero) are deleted through the pointer the
+ *  tree returns, not the caller's word.
+ */
+typedef struct {
+    const char *name;
+    int cpy;
+    void *(*ins_del)(void *t, char * const *s, const int del);
+    void *(*search)(void *t, const char *s);
+    void *(*prefix)(void *t, const char *s, char **a, int *n, const int max);
+    const node_tst *(*root)(void *t);
+    void (*rebalance)(void *t);
+} op_tree;
+
+/** chars of the deep keys, DEEPN runs of DEEPC keys of 1 to DEEPN chars */
+enum { DEEPC = 127, DEEPN = 3 };
+
+/** deep key 'i' in 'key': the first i / DEEPC chars 127, then the char
+ *  i % DEEPC + 1. inserted in order each run is a linked list of DEEPC
+ *  siblings hanging off the last key of the run above.
+ */
+static void deep_key (const size_t i, char *key)
+{
+    size_t d = i / DEEPC;
+
+    memset (key, DEEPC, d);
+    key[d] = i % DEEPC + 1;
+    key[d + 1] = 0;
+}
+
+/** insert the deep keys in 'ot' in order, the path to the last longer
+ *  than STKMAX nodes, then delete them from the last. each delete must
+ *  remove its key. returns 0 on success, 1 otherwise.
+ */
+static int check_deep (const op_tree *ot, void *t)
+{
+    char key[DEEPN + 1], *k = key;
+
+    for (size_t i = 0; i < DEEPC * DEEPN; i++) {
+        deep_key (i, key);
+        if (!ot->ins_del (t, &k, INS)) {
+            fprintf (stderr, "error: %s deep insert %zu.\n", ot->name, i);
+            return 1;
+        }
+    }
+    for (size_t i = DEEPC * DEEPN; i--;) {
+        deep_key (i, key);
+        if (ot->cpy && !(k = ot->search (t, key)))
+            k = key;
+        if (ot->ins_del (t, &k, DEL) || ot->search (t, key)) {
+            fprintf (stderr, "error: %s deep delete %zu.\n", ot->name, i);
+            return 1;
+        }
+        k = key;
+    }
+
+    return 0;
+}
+
+/** search of the 'nu' unique words 'u' and of edited words, and prefix
+ *  search of prefixes of words, in tree 'ot' on handle 't' and in plain
+ *  tree 'plain' must agree. 'got' and 'exp' hold 'nu' words. returns 0 on
+ *  success, 1 otherwise.
+ */
+static int same_lookups (const op_tree *ot, void *t, const node_tst *plain,
+                        char **u, size_t nu, char **got, char **exp)
+{
+    enum { NQ = 200 };
+    char query[WRDMAX];
+
+    for (size_t i = 0; i < nu + NQ; i++) {
+        const char *x, *y;
+        if (i >= nu)
+            edited_word (u, nu, query);
+        else
+            strcpy (query, u[i]);
+        x = tst_search (plain, query);
+        y = ot->search (t, query);
+        if (!x != !y || (y && strcmp (y, query))) {
+            fprintf (stderr, "error: %s search '%s'.\n", ot->name, query);
+            return 1;
+        }
+    }
+    for (size_t q = 0; q < NQ; q++) {
+        const char *w = u[rand_int (nu)];
+        size_t len = strlen (w);
+        int na = 0, nb = 0;
+        if (len > 1)                        /* proper prefix */
+            len = 1 + rand_int (len - 1);
+        if (len >= WRDMAX)
+            len = WRDMAX - 1;
+        memcpy (query, w, len);
+        query[len] = 0;
+        if (!ot->prefix (t, query, got, &na, nu))
+            na = 0;
+        if (!tst_search_prefix (plain, query, exp, &nb, nu))
+            nb = 0;
+        if (same_words (ot->name, query, got, na, exp, nb))
+            return 1;
+    }
+
+    return 0;
+}
+
+/** random insert and delete of words in tree 'ot' (empty) and a plain tree
+ *  by reference, then delete of all. search, prefix search and (with a
+ *  root) traversal, fuzzy and pattern search of the two must agree. keys
+ *  with a path deeper than STKMAX are inserted and deleted first (see
+ *  check_deep()). returns 0 on success, 1 otherwise.
+ */
+static int check_ops (const op_tree *ot, void *t, char **words, size_t n)
+{
+    node_tst *plain = NULL;
+    char **u, **got, **exp;
+    size_t nu, nops = 0;
+    unsigned *cnt;
+    int fail;
+
+    if (!n)
+        return 0;
+    u = unique_words (words, n, &nu);
+    got = malloc (nu * sizeof *got);
+    exp = malloc (nu * sizeof *exp);
+    cnt = calloc (nu, sizeof *cnt);
+    if (!got || !exp || !cnt) {
+        fprintf (stderr, "error: memory exhausted, match arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    fail = check_deep (ot, t);
+    for (size_t k = 0; k < 4 * nu && !fail; k++) {
+        size_t i = rand_int (nu);
+        int del = !(rand_int (3) && cnt[i] < 2);
+        char *key = u[i];
+        void *x, *y;
+        if (del && !cnt[i])
+            continue;
+        if (del && ot->cpy)                 /* the tree's own copy */
+            key = ot->search (t, u[i]);
+        x = tst_ins_del (&plain, &u[i], del, REF);
+        y = key ? ot->ins_del (t, &key, del) : NULL;
+        if (!x != !y || (!del && y && strcmp (y, u[i]))) {
+            fprintf (stderr, "error: %s %s '%s'.\n", ot->name,
+                    del ? "delete" : "insert", u[i]);
+            fail = 1;
+        }
+        cnt[i] += del ? -1 : 1;
+        nops++;
+    }
+
+    if (!fail)
+        fail = same_lookups (ot, t, plain, u, nu, got, exp);
+    if (!fail && ot->root)
+        fail = same_trees (ot->name, ot->root (t), plain, words, n,
+                            got, exp, nu);
+    if (!fail && ot->root && ot->rebalance) {
+        ot->rebalance (t);
+        fail = same_trees (ot->name, ot->root (t), plain, words, n,
+                            got, exp, nu);
+    }
+
+    for (size_t i = 0; i < nu && !fail; i++)    /* delete all */
+        for (; cnt[i]; cnt[i]--) {
+            char *key = ot->cpy ? ot->search (t, u[i]) : u[i];
+            tst_ins_del (&plain, &u[i], DEL, REF);
+            if (!key || (ot->ins_del (t, &key, DEL) != NULL) != (cnt[i] > 1)) {
+                fprintf (stderr, "error: %s delete '%s'.\n", ot->name, u[i]);
+                fail = 1;
+                break;
+            }
+        }
+    if (!fail && ot->root && ot->root (t)) {
+        fprintf (stderr, "error: %s, tree not empty after delete.\n",
+                ot->name);
+        fail = 1;
+    }
+    printf ("%-8s %zu ops  %s\n", ot->name, nops, fail ? "FAILED" : "ok");
+
+    tst_free (plain);
+    free (cnt);
+    free (exp);
+    free (got);
+    free (u);
+
+    return fail;
+}
+
+/* arena-backed tree, words by copy */
+static void *arena_ins_del (void *t, char * const *s, const int del)
+{
+    return tst_arena_ins_del (t, s, del, CPY);
+}
+
+static const node_tst *arena_root (void *t)
+{
+    return tst_arena_root (t);
+}
+
+static void *arena_search (void *t, const char *s)
+{
+    return tst_search (tst_arena_root (t), s);
+}
+
+static void *arena_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    return tst_search_prefix (tst_arena_root (t), s, a, n, max);
+}
+
+static void arena_rebalance (void *t)
+{
+    tst_arena_rebalance (t);
+}
+
+/** arena tree (tst_arena_ins_del()) by copy vs. a plain tree, also after
+ *  tst_arena_rebalance().
+ */
+static int check_arena (char **words, size_t n)
+{
+    const op_tree ot = { "arena", CPY, arena_ins_del, arena_search,
+                        arena_prefix, arena_root, arena_rebalance };
+    tst_arena *a = tst_arena_create (0);
+    int fail;
+
+    if (!a) {
+        fprintf (stderr, "error: memory exhausted, tst_arena_create.\n");
+        exit (EXIT_FAILURE);
+    }
+    fail = check_ops (&ot, a, words, n);
+    tst_arena_destroy (a);
+
+    return fail;
+}
+
+/* compact tree, words by copy */
+static void *cpt_ins_del (void *t, char * const *s, const int del)
+{
+    return tst_cpt_ins_del (t, s, del, CPY);
+}
+
+static void *cpt_search (void *t, const char *s)
+{
+    return tst_cpt_search (t, s);
+}
+
+static void *cpt_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    return tst_cpt_search_prefix (t, s, a, n, max);
+}
+
+/** compact tree (tst_cpt_ins_del()) by copy vs. a plain tree. */
+static int check_cpt (char **words, size_t n)
+{
+    const op_tree ot = { "compact", CPY, cpt_ins_del, cpt_search,
+                        cpt_prefix, NULL, NULL };
+    tst_cpt *t = tst_cpt_create ();
+    int fail;
+
+    if (!t) {
+        fprintf (stderr, "error: memory exhausted, tst_cpt_create.\n");
+        exit (EXIT_FAILURE);
+    }
+    fail = check_ops (&ot, t, words, n);
+    tst_cpt_free (t, 1);
+
+    return fail;
+}
+
+/* frozen tree, lookups only */
+static void *frozen_search (void *t, const char *s)
+{
+    return tst_frozen_search (t, s);
+}
+
+static void *frozen_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    return tst_frozen_prefix (t, s, a, n, max);
+}
+
+/** plain tree by reference of about 2/3 of the unique words (some twice)
+ *  in 'plain', the words inserted in 'u' and their number in 'nu'. returns
+ *  pointer to array 'u' (caller frees).
+ */
+static char **subset_tree (char **words, size_t n, node_tst **plain,
+                            size_t *nu)
+{
+    char **u = unique_words (words, n, nu);
+    size_t m = 0;
+
+    for (size_t i = 0; i < *nu; i++) {
+        if (!rand_int (3))
+            continue;
+        for (int k = rand_int (4) ? 1 : 2; k; k--)
+            if (!tst_ins_del (plain, &u[i], INS, REF)) {
+                fprintf (stderr, "error: tst_ins_del, '%s'.\n", u[i]);
+                exit (EXIT_FAILURE);
+            }
+        u[m++] = u[i];
+    }
+    *nu = m;
+
+    return u;
+}
+
+/** frozen tree 'f' vs. plain tree 'plain' holding the 'nu' words 'u'.
+ *  returns 0 on success, 1 otherwise.
+ */
+static int check_frozen_tree (const char *name, tst_frozen *f,
+                            const node_tst *plain, char **u, size_t nu)
+{
+    const op_tree ot = { name, CPY, NULL, frozen_search, frozen_prefix,
+                        NULL, NULL };
+    char **got = malloc ((nu + 1) * sizeof *got),
+         **exp = malloc ((nu + 1) * sizeof *exp);
+    int fail;
+
+    if (!got || !exp) {
+        fprintf (stderr, "error: memory exhausted, match arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+    fail = !nu ? 0 : same_lookups (&ot, f, plain, u, nu, got, exp);
+    printf ("%-8s %zu words  %s\n", name, nu, fail ? "FAILED" : "ok");
+
+    free (exp);
+    free (got);
+
+    return fail;
+}
+
+/** tst_freeze() of a plain tree vs. the plain tree. */
+static int check_frozen (char **words, size_t n)
+{
+    node_tst *plain = NULL;
+    tst_frozen *f;
+    size_t nu;
+    char **u = subset_tree (words, n, &plain, &nu);
+    int fail;
+
+    if (!(f = tst_freeze (plain))) {
+        fprintf (stderr, "error: tst_freeze failed.\n");
+        exit (EXIT_FAILURE);
+    }
+    fail = check_frozen_tree ("frozen", f, plain, u, nu);
+
+    tst_frozen_free (f);
+    tst_free (plain);
+    free (u);
+
+    return fail;
+}
+
+/** tst_save() image of a plain tree mapped by tst_frozen_map() vs. the
+ *  plain tree, image file removed after.
+ */
+static int check_image (char **words, size_t n)
+{
+    const char *img = "tst_check.img";
+    node_tst *plain = NULL;
+    tst_frozen *f;
+    size_t nu;
+    char **u = subset_tree (words, n, &plain, &nu);
+    int fail;
+
+    if (tst_save (plain, img) || !(f = tst_frozen_map (img))) {
+        fprintf (stderr, "error: tst_save/tst_frozen_map '%s' failed.\n", img);
+        remove (img);
+        exit (EXIT_FAILURE);
+    }
+    fail = check_frozen_tree ("image", f, plain, u, nu);
+
+    tst_frozen_free (f);
+    remove (img);
+    tst_free (plain);
+    free (u);
+
+    return fail;
+}
+
+/* plain tree by copy, handle is pointer to root */
+static void *cpy_ins_del (void *t, char * const *s, const int del)
+{
+    return tst_ins_del (t, s, del, CPY);
+}
+
+static const node_tst *cpy_root (void *t)
+{
+    return *(node_tst **)t;
+}
+
+static void *cpy_search (void *t, const char *s)
+{
+    return tst_search (*(node_tst **)t, s);
+}
+
+static void *cpy_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    return tst_search_prefix (*(node_tst **)t, s, a, n, max);
+}
+
+static void cpy_rebalance (void *t)
+{
+    tst_rebalance (t);
+}
+
+/** plain tree by copy vs. a plain tree by reference, also after
+ *  tst_rebalance().
+ */
+static int check_rebalance (char **words, size_t n)
+{
+    const op_tree ot = { "rebal", CPY, cpy_ins_del, cpy_search,
+                        cpy_prefix, cpy_root, cpy_rebalance };
+    node_tst *root = NULL;
+    int fail = check_ops (&ot, &root, words, n);
+
+    tst_free_all (root);
+
+    return fail;
+}
+
+/* path-compressed tree by copy, handle is pointer to root */
+static void *pc_ins_del (void *t, char * const *s, const int del)
+{
+    return tst_pc_ins_del (t, s, del, CPY);
+}
+
+static void *pc_search (void *t, const char *s)
+{
+    return tst_pc_search (*(node_tst **)t, s);
+}
+
+static void *pc_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    return tst_pc_search_prefix (*(node_tst **)t, s, a, n, max);
+}
+
+/** path-compressed tree (tst_pc_ins_del()) by copy vs. a plain tree, the
+ *  tree must be empty after all words are deleted.
+ */
+static int check_pc (char **words, size_t n)
+{
+    const op_tree ot = { "path", CPY, pc_ins_del, pc_search, pc_prefix,
+                        NULL, NULL };
+    node_tst *root = NULL;
+    int fail = check_ops (&ot, &root, words, n);
+
+    if (!fail && root) {
+        fprintf (stderr, "error: path, tree not empty after delete.\n");
+        fail = 1;
+    }
+    tst_free_all (root);
+
+    return fail;
+}
+
+/** keyless tree (TST_NOKEY) with buffer for keys rebuilt from the path */
+typedef struct {
+    node_tst *root;
+    char *buf;
+    size_t bufsz;
+} keyless_tree;
+
+static void *keyless_ins_del (void *t, char * const *s, const int del)
+{
+    keyless_tree *k = t;
+    void *node = tst_ins_del (&k->root, s, del, TST_NOKEY);
+
+    if (!node || del)
+        return node;
+
+    return tst_search_key (k->root, *s, k->buf, k->bufsz);
+}
+
+static void *keyless_search (void *t, const char *s)
+{
+    keyless_tree *k = t;
+
+    return tst_search_key (k->root, s, k->buf, k->bufsz);
+}
+
+static void *keyless_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    keyless_tree *k = t;
+
+    return tst_search_prefix_key (k->root, s, k->buf, k->bufsz, a, n, max);
+}
+
+/** keyless tree (TST_NOKEY) vs. a plain tree, keys rebuilt from the path
+ *  by tst_search_key() and tst_search_prefix_key() into a buffer holding
+ *  all words. the tree must be empty after all words are deleted.
+ */
+static int check_keyless (char **words, size_t n)
+{
+    const op_tree ot = { "keyless", REF, keyless_ins_del, keyless_search,
+                        keyless_prefix, NULL, NULL };
+    keyless_tree k = { NULL, NULL, WRDMAX };
+    int fail;
+
+    for (size_t i = 0; i < n; i++)
+        k.bufsz += strlen (words[i]) + 1;
+    if (!(k.buf = malloc (k.bufsz))) {
+        fprintf (stderr, "error: memory exhausted, key buffer.\n");
+        exit (EXIT_FAILURE);
+    }
+    fail = check_ops (&ot, &k, words, n);
+    if (!fail && k.root) {
+        fprintf (stderr, "error: keyless, tree not empty after delete.\n");
+        fail = 1;
+    }
+
+    tst_free (k.root);
+    free (k.buf);
+
+    return fail;
+}
+
+/** tst_cursor_next() pages of 1 to 7 words for prefixes of words, edited
+ *  words and the empty prefix vs. tst_search_prefix() (traversal for the
+ *  empty prefix) in the same order.
+ */
+static int check_cursor (char **words, size_t n)
+{
+    enum { NQ = 200 };
+    node_tst *plain = NULL;
+    size_t nu, nwords = 0;
+    char **u = subset_tree (words, n, &plain, &nu),
+         **got = malloc ((nu + 8) * sizeof *got),
+         **exp = malloc ((nu + 1) * sizeof *exp),
+         query[WRDMAX];
+    int fail = 0;
+
+    if (!got || !exp) {
+        fprintf (stderr, "error: memory exhausted, match arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t q = 0; q <= NQ && nu && !fail; q++) {
+        const int page = 1 + q % 7;
+        tst_cursor *c;
+        size_t ngot = 0, nexp = 0;
+        int k;
+        if (q == NQ)                        /* all words */
+            *query = 0;
+        else {
+            edited_word (u, nu, query);
+            if (*query)                     /* prefix of edited word */
+                query[rand_int (strlen (query)) + 1] = 0;
+        }
+        if (!*query) {
+            word_list l = { .w = exp, .n = 0 };
+            tst_traverse_fn (plain, add_word, &l);
+            nexp = l.n;
+        }
+        else {
+            int m = 0;
+            if (tst_search_prefix (plain, query, exp, &m, nu))
+                nexp = m;
+        }
+        if (!(c = tst_cursor_open (plain, query))) {
+            fprintf (stderr, "error: tst_cursor_open '%s' failed.\n", query);
+            exit (EXIT_FAILURE);
+        }
+        while ((k = tst_cursor_next (c, got + ngot, page)) > 0)
+            ngot += k;
+        tst_cursor_close (c);
+        if (k < 0 || ngot != nexp) {
+            fprintf (stderr, "error: cursor '%s', %zu words expected %zu.\n",
+                    query, ngot, nexp);
+            fail = 1;
+        }
+        for (size_t i = 0; i < ngot && !fail; i++)
+            if (got[i] != exp[i]) {
+                fprintf (stderr, "error: cursor '%s', got '%s' expected "
+                        "'%s'.\n", query, got[i], exp[i]);
+                fail = 1;
+            }
+        nwords += ngot;
+    }
+    printf ("%-8s %d queries, %zu words  %s\n", "cursor", NQ + 1, nwords,
+            fail ? "FAILED" : "ok");
+
+    tst_free (plain);
+    free (exp);
+    free (got);
+    free (u);
+
+    return fail;
+}
+
+static int cmp_cnt (const void *a, const void *b)
+{
+    unsigned x = *(const unsigned *)a, y = *(const unsigned *)b;
+
+    return (x < y) - (x > y);               /* largest first */
+}
+
+/** tst_topk_prefix() of 'root' for prefixes of words, edited words and the
+ *  empty prefix at k 1 to 10 vs. the counts 'cnt' of the 'nu' sorted words
+ *  'u'. the counts returned must be the largest, largest first, and the
+ *  node for a prefix must hold the largest count below it. 'tmp' holds
+ *  'nu' counts. returns 0 on success, 1 otherwise.
+ */
+static int same_topk (const char *check, const node_tst *root, char **u,
+                        size_t nu, const unsigned *cnt, unsigned *tmp)
+{
+    enum { NQ = 50, K = 10 };
+    char query[WRDMAX], *top[K];
+
+    for (size_t q = 0; q <= NQ; q++) {
+        const int k = 1 + q % K;
+        const node_tst *node;
+        size_t len, m = 0;
+        int n = 0;
+        if (q == NQ)                        /* all words */
+            *query = 0;
+        else {
+            edited_word (u, nu, query);
+            if (*query)
+                query[rand_int (strlen (query)) + 1] = 0;
+        }
+        len = strlen (query);
+        for (size_t i = 0; i < nu; i++)
+            if (cnt[i] && !strncmp (u[i], query, len))
+                tmp[m++] = cnt[i];
+        qsort (tmp, m, sizeof *tmp, cmp_cnt);
+        if (!(node = tst_topk_prefix (root, query, top, &n, k)))
+            n = 0;
+        if (node && *query && tst_get_refcnt (node) != tmp[0]) {
+            fprintf (stderr, "error: %s '%s', subtree max %u expected %u.\n",
+                    check, query, tst_get_refcnt (node), tmp[0]);
+            return 1;
+        }
+        if ((size_t)n != (m < (size_t)k ? m : (size_t)k)) {
+            fprintf (stderr, "error: %s '%s' k %d, %d words expected %zu.\n",
+                    check, query, k, n, m < (size_t)k ? m : (size_t)k);
+            return 1;
+        }
+        for (int i = 0; i < n; i++) {
+            char **w = bsearch (&top[i], u, nu, sizeof *u, cmp_str);
+            if (!w || strncmp (top[i], query, len) || cnt[w - u] != tmp[i]) {
+                fprintf (stderr, "error: %s '%s' k %d, word %d '%s' count "
+                        "%u expected %u.\n", check, query, k, i, top[i],
+                        w ? cnt[w - u] : 0, tmp[i]);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/** top-k tree by copy (tst_topk_ins_del()) under random skewed inserts and
+ *  deletes (through the pointer the tree returns) vs. counts, then
+ *  tst_topk_index() of trees from tst_build_sorted() and tst_ins_del(),
+ *  which must leave the refcnt of a node not holding a word at 1.
+ */
+static int check_topk (char **words, size_t n)
+{
+    node_tst *root = NULL;
+    size_t nu, nops = 0;
+    char **u = unique_words (words, n, &nu), **all;
+    unsigned *cnt = calloc (nu + 1, sizeof *cnt),
+             *tmp = calloc (nu + 1, sizeof *tmp);
+    size_t nall = 0;
+    int fail = 0;
+
+    if (!cnt || !tmp || !(all = malloc ((8 * nu + 1) * sizeof *all))) {
+        fprintf (stderr, "error: memory exhausted, count arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t k = 0; k < 8 * nu && !fail; k++) {
+        size_t i = rand_int (rand_int (nu) + 1);    /* skewed */
+        int del = cnt[i] && !rand_int (4);
+        char *key = del ? tst_search (root, u[i]) : u[i];
+        void *ret = key ? tst_topk_ins_del (&root, &key, del, CPY) : NULL;
+        if (!key || (!del && !ret) || (del && !ret != (cnt[i] == 1))) {
+            fprintf (stderr, "error: topk %s '%s'.\n",
+                    del ? "delete" : "insert", u[i]);
+            fail = 1;
+        }
+        cnt[i] += del ? -1 : 1;
+        if (++nops % (2 * nu) == 0 && !fail)
+            fail = same_topk ("topk", root, u, nu, cnt, tmp);
+    }
+    tst_free_all (root);
+    root = NULL;
+
+    for (size_t i = 0; i < nu; i++)         /* same counts as words */
+        for (unsigned c = cnt[i]; c; c--)
+            all[nall++] = u[i];
+    for (int b = 0; b < 2 && !fail; b++) {  /* build, plain insert */
+        const char *check = b ? "topk ins" : "topk bld";
+        root = NULL;
+        if (!b)
+            fail = nall && !tst_build_sorted (&root, all, nall, REF);
+        for (size_t i = 0; b && i < nall && !fail; i++)
+            fail = !tst_ins_del (&root, &all[i], INS, REF);
+        if (fail)
+            fprintf (stderr, "error: %s, memory exhausted.\n", check);
+        if (!fail && root && tst_get_key (root) && tst_get_refcnt (root) != 1) {
+            fprintf (stderr, "error: %s, refcnt %u of node not holding a "
+                    "word.\n", check, tst_get_refcnt (root));
+            fail = 1;
+        }
+        if (!fail && tst_topk_index (root))
+            fail = 1;
+        if (!fail)
+            fail = same_topk (check, root, u, nu, cnt, tmp);
+        tst_free (root);
+    }
+    printf ("%-8s %zu ops  %s\n", "topk", nops, fail ? "FAILED" : "ok");
+
+    free (all);
+    free (tmp);
+    free (cnt);
+    free (u);
+
+    return fail;
+}
+
+/** tst_search_batch() of words and edited words in batches of 1 to 100
+ *  keys vs. tst_search() of each key.
+ */
+static int check_batch (char **words, size_t n)
+{
+    enum { NB = 100, BMAX = 100 };
+    node_tst *plain = NULL;
+    size_t nu, nkeys = 0, nfound = 0;
+    char **u = subset_tree (words, n, &plain, &nu),
+         (*query)[WRDMAX] = malloc (BMAX * sizeof *query);
+    const char *keys[BMAX];
+    void *res[BMAX];
+    int fail = 0;
+
+    if (!query) {
+        fprintf (stderr, "error: memory exhausted, batch keys.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t b = 0; b < NB && nu && !fail; b++) {
+        size_t m = 1 + rand_int (BMAX), found = 0;
+        for (size_t i = 0; i < m; i++) {
+            if (rand_int (2))
+                edited_word (u, nu, query[i]);
+            else
+                strcpy (query[i], words[rand_int (n)]);
+            keys[i] = query[i];
+        }
+        if (tst_search_batch (plain, keys, m, res) > m)
+            fail = 1;
+        for (size_t i = 0; i < m && !fail; i++) {
+            if (res[i] != tst_search (plain, keys[i])) {
+                fprintf (stderr, "error: batch '%s', result differs from "
+                        "tst_search().\n", keys[i]);
+                fail = 1;
+            }
+            found += res[i] != NULL;
+        }
+        if (!fail && tst_search_batch (plain, keys, m, res) != found) {
+            fprintf (stderr, "error: batch, found count not %zu.\n", found);
+            fail = 1;
+        }
+        nkeys += m;
+        nfound += found;
+    }
+    printf ("%-8s %zu keys, %zu found  %s\n", "batch", nkeys, nfound,
+            fail ? "FAILED" : "ok");
+
+    tst_free (plain);
+    free (query);
+    free (u);
+
+    return fail;
+}
+
+/** concurrent tree with the reader id of this thread */
+typedef struct {
+    tst_conc *c;
+    int id;
+} conc_tree;
+
+static void *conc_ins_del (void *t, char * const *s, const int del)
+{
+    return tst_conc_ins_del (((conc_tree *)t)->c, s, del);
+}
+
+static void *conc_search (void *t, const char *s)
+{
+    conc_tree *ct = t;
+    void *ret;
+
+    tst_conc_read_begin (ct->c, ct->id);
+    ret = tst_conc_search (ct->c, s);
+    tst_conc_read_end (ct->c, ct->id);
+
+    return ret;
+}
+
+static void *conc_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    conc_tree *ct = t;
+    void *ret;
+
+    tst_conc_read_begin (ct->c, ct->id);
+    ret = tst_conc_search_prefix (ct->c, s, a, n, max);
+    tst_conc_read_end (ct->c, ct->id);
+
+    return ret;
+}
+
+/** concurrent tree (tst_conc_ins_del()) by copy vs. a plain tree, from
+ *  one thread (words found are used before this thread deletes them).
+ */
+static int check_conc (char **words, size_t n)
+{
+    const op_tree ot = { "conc", CPY, conc_ins_del, conc_search,
+                        conc_prefix, NULL, NULL };
+    conc_tree ct = { tst_conc_create (CPY), -1 };
+    int fail;
+
+    if (!ct.c || (ct.id = tst_conc_register (ct.c)) < 0) {
+        fprintf (stderr, "error: tst_conc_create/register failed.\n");
+        exit (EXIT_FAILURE);
+    }
+    fail = check_ops (&ot, &ct, words, n);
+    tst_conc_unregister (ct.c, ct.id);
+    tst_conc_destroy (ct.c);
+
+    return fail;
+}
+
+/* current version of persistent tree, words by copy */
+static void *pers_ins_del (void *t, char * const *s, const int del)
+{
+    return tst_pers_ins_del (t, s, del);
+}
+
+static const node_tst *pers_root (void *t)
+{
+    return tst_pers_root (t);
+}
+
+static void *pers_search (void *t, const char *s)
+{
+    return tst_search (tst_pers_root (t), s);
+}
+
+static void *pers_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    return tst_search_prefix (tst_pers_root (t), s, a, n, max);
+}
+
+/** insert word at 'node' refcnt times by reference in tree at 'data'. */
+static void copy_word (const void *node, void *data)
+{
+    char *s = tst_get_string (node);
+
+    for (unsigned c = tst_get_refcnt (node); c; c--)
+        if (!tst_ins_del (data, &s, INS, REF)) {
+            fprintf (stderr, "error: tst_ins_del, '%s'.\n", s);
+            exit (EXIT_FAILURE);
+        }
+}
+
+/** persistent tree (tst_pers_ins_del()) by copy vs. a plain tree, then
+ *  NSNAP snapshots taken between rounds of random inserts and deletes
+ *  (through the pointer the tree returns) vs. plain copies of the tree at
+ *  each snapshot, after all words are deleted from the current version
+ *  and as the snapshots are released.
+ */
+static int check_pers (char **words, size_t n)
+{
+    enum { NSNAP = 4 };
+    const op_tree ot = { "pers", CPY, pers_ins_del, pers_search,
+                        pers_prefix, pers_root, NULL };
+    tst_pers *h = tst_pers_create (CPY);
+    node_tst *plain = NULL, *copy[NSNAP] = { NULL }, *snap[NSNAP] = { NULL };
+    size_t nu, nsnap = 0;
+    char **u = unique_words (words, n, &nu), **got, **exp;
+    unsigned *cnt;
+    int fail;
+
+    got = malloc ((nu + 1) * sizeof *got);
+    exp = malloc ((nu + 1) * sizeof *exp);
+    cnt = calloc (nu + 1, sizeof *cnt);
+    if (!h || !got || !exp || !cnt) {
+        fprintf (stderr, "error: memory exhausted, tst_pers_create.\n");
+        exit (EXIT_FAILURE);
+    }
+    fail = check_ops (&ot, h, words, n);
+
+    for (size_t v = 0; v < NSNAP && nu && !fail; v++) {
+        for (size_t k = 0; k < nu && !fail; k++) {
+            size_t i = rand_int (nu);
+            int del = cnt[i] && !rand_int (3);
+            char *key = del ? tst_search (tst_pers_root (h), u[i]) : u[i];
+            tst_ins_del (&plain, &u[i], del, REF);
+            if (!key || (!tst_pers_ins_del (h, &key, del)) != (del &&
+                    cnt[i] == 1)) {
+                fprintf (stderr, "error: pers %s '%s'.\n",
+                        del ? "delete" : "insert", u[i]);
+                fail = 1;
+            }
+            cnt[i] += del ? -1 : 1;
+        }
+        tst_traverse_fn (plain, copy_word, &copy[v]);
+        if (!(snap[v] = tst_snapshot (h)) != !copy[v]) {
+            fprintf (stderr, "error: tst_snapshot %zu failed.\n", v);
+            fail = 1;
+        }
+        nsnap++;
+    }
+    for (size_t i = 0; i < nu && !fail; i++)    /* delete all */
+        for (; cnt[i]; cnt[i]--) {
+            char *key = tst_search (tst_pers_root (h), u[i]);
+            if (!key || (tst_pers_ins_del (h, &key, DEL) != NULL) !=
+                    (cnt[i] > 1)) {
+                fprintf (stderr, "error: pers delete '%s'.\n", u[i]);
+                fail = 1;
+                break;
+            }
+        }
+    if (!fail && tst_pers_root (h)) {
+        fprintf (stderr, "error: pers, tree not empty after delete.\n");
+        fail = 1;
+    }
+    for (size_t r = 0; r < NSNAP; r++) {    /* release 1, 3, 0, 2 */
+        size_t v = (2 * r + 1) % (NSNAP + 1) % NSNAP;
+        for (size_t w = 0; w < NSNAP && !fail; w++)
+            if (snap[w])
+                fail = same_trees ("snapshot", snap[w], copy[w], words, n,
+                                    got, exp, nu);
+        if (snap[v])
+            tst_snapshot_release (h, snap[v]);
+        snap[v] = NULL;
+    }
+    printf ("%-8s %zu snapshots  %s\n", "pers", nsnap,
+            fail ? "FAILED" : "ok");
+
+    for (size_t v = 0; v < NSNAP; v++)
+        tst_free (copy[v]);
+    tst_pers_destroy (h);
+    tst_free (plain);
+    free (cnt);
+    free (exp);
+    free (got);
+    free (u);
+
+    return fail;
+}
+
+/* sharded tree, words by copy */
+static void *shard_ins_del (void *t, char * const *s, const int del)
+{
+    return tst_shard_ins_del (t, s, del, CPY);
+}
+
+static void *shard_search (void *t, const char *s)
+{
+    return tst_shard_search (t, s);
+}
+
+static void *shard_prefix (void *t, const char *s, char **a, int *n,
+                            const int max)
+{
+    return tst_shard_search_prefix (t, s, a, n, max);
+}
+
+/** sharded tree (tst_shard_ins_del()) by copy vs. a plain tree, then
+ *  tst_shard_traverse_fn() of part of the words vs. tst_traverse_fn() of
+ *  a plain tree in the same order.
+ */
+static int check_shard (char **words, size_t n)
+{
+    const op_tree ot = { "shard", CPY, shard_ins_del, shard_search,
+                        shard_prefix, NULL, NULL };
+    tst_shard *t = tst_shard_create ();
+    node_tst *plain = NULL;
+    size_t nu;
+    char **u, **got, **exp;
+    word_list lg, le;
+    int fail;
+
+    if (!t) {
+        fprintf (stderr, "error: memory exhausted, tst_shard_create.\n");
+        exit (EXIT_FAILURE);
+    }
+    fail = check_ops (&ot, t, words, n);
+
+    u = subset_tree (words, n, &plain, &nu);
+    got = malloc ((nu + 1) * sizeof *got);
+    exp = malloc ((nu + 1) * sizeof *exp);
+    if (!got || !exp) {
+        fprintf (stderr, "error: memory exhausted, match arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < nu && !fail; i++)
+        fail = !tst_shard_ins_del (t, &u[i], INS, CPY);
+    lg = (word_list){ .w = got, .n = 0 };
+    le = (word_list){ .w = exp, .n = 0 };
+    if (!fail) {
+        tst_shard_traverse_fn (t, add_word, &lg);
+        tst_traverse_fn (plain, add_word, &le);
+    }
+    for (size_t i = 0; i < lg.n && lg.n == le.n && !fail; i++)
+        fail = strcmp (got[i], exp[i]) != 0;
+    if (fail || lg.n != le.n) {
+        fprintf (stderr, "error: shard traversal, %zu words expected %zu.\n",
+                lg.n, le.n);
+        fail = 1;
+    }
+    printf ("%-8s %zu words traversed  %s\n", "shard", lg.n,
+            fail ? "FAILED" : "ok");
+
+    tst_shard_destroy (t, 1);
+    tst_free (plain);
+    free (exp);
+    free (got);
+    free (u);
+
+    return fail;
+}
+
+typedef struct {
+    const void **node;
+    size_t n;
+} node_list;
+
+static void add_node (const void *node, void *data)
+{
+    node_list *l = data;
+
+    l->node[l->n++] = node;
+}
+
+/** trees 'a' and 'b' hold the same words with the same refcnt in the same
+ *  order and have the same shape (tst_stats() identical). 'na' and 'nb'
+ *  hold a node per word. returns 0 if the same, 1 otherwise (reported as
+ *  'check').
+ */
+static int same_shape (const char *check, const node_tst *a,
+                        const node_tst *b, const void **na, const void **nb)
+{
+    node_list la = { na, 0 }, lb = { nb, 0 };
+    tst_stats_t sa, sb;
+
+    tst_traverse_fn (a, add_node, &la);
+    tst_traverse_fn (b, add_node, &lb);
+    for (size_t i = 0; i < la.n && la.n == lb.n; i++)
+        if (strcmp (tst_get_string (na[i]), tst_get_string (nb[i])) ||
+                tst_get_refcnt (na[i]) != tst_get_refcnt (nb[i])) {
+            fprintf (stderr, "error: %s, word %zu '%s' (%u) expected '%s' "
+                    "(%u).\n", check, i, tst_get_string (na[i]),
+                    tst_get_refcnt (na[i]), tst_get_string (nb[i]),
+                    tst_get_refcnt (nb[i]));
+            return 1;
+        }
+    if (la.n != lb.n || !tst_stats (a, &sa) || !tst_stats (b, &sb) ||
+            sa.nodes != sb.nodes || sa.sibtrees != sb.sibtrees ||
+            sa.depth_max != sb.depth_max || sa.sib_max != sb.sib_max ||
+            sa.worst_cmps != sb.worst_cmps || sa.avg_cmps != sb.avg_cmps ||
+            memcmp (sa.eq_depth, sb.eq_depth, sizeof sa.eq_depth) ||
+            memcmp (sa.sib_height, sb.sib_height, sizeof sa.sib_height)) {
+        fprintf (stderr, "error: %s, tree differs from tst_build_sorted().\n",
+                check);
+        return 1;
+    }
+
+    return 0;
+}
+
+/** tst_build_parallel() at 1, 2, 4 and 7 threads of the words, shuffled
+ *  words and sorted unique words, by reference and copy, vs.
+ *  tst_build_sorted() of the same words (same words, refcnt and shape).
+ */
+static int check_parallel (char **words, size_t n)
+{
+    const int nthreads[] = { 1, 2, 4, 7 };
+    size_t nu, nbuilds = 0;
+    char **u = unique_words (words, n, &nu),
+         **shuf = malloc ((n + 1) * sizeof *shuf);
+    const void **na = malloc ((n + 1) * sizeof *na),
+               **nb = malloc ((n + 1) * sizeof *nb);
+    int fail = 0;
+
+    if (!shuf || !na || !nb) {
+        fprintf (stderr, "error: memory exhausted, parallel arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+    memcpy (shuf, words, n * sizeof *shuf);
+    for (size_t i = n; i > 1; i--) {        /* Fisher-Yates */
+        size_t j = rand_int (i);
+        char *tmp = shuf[i - 1];
+        shuf[i - 1] = shuf[j];
+        shuf[j] = tmp;
+    }
+
+    for (int in = 0; in < 3 && !fail; in++) {
+        char **s = in == 0 ? words : in == 1 ? shuf : u;
+        size_t m = in == 2 ? nu : n;
+        for (int cpy = REF; cpy <= CPY && !fail; cpy++) {
+            node_tst *serial = NULL;
+            if (m && !tst_build_sorted (&serial, s, m, cpy)) {
+                fprintf (stderr, "error: tst_build_sorted failed.\n");
+                exit (EXIT_FAILURE);
+            }
+            for (size_t t = 0; t < sizeof nthreads / sizeof *nthreads &&
+                    !fail; t++, nbuilds++) {
+                node_tst *par = NULL;
+                if (m && !tst_build_parallel (&par, s, m, cpy, nthreads[t])) {
+                    fprintf (stderr, "error: tst_build_parallel failed.\n");
+                    exit (EXIT_FAILURE);
+                }
+                fail = same_shape ("parallel", par, serial, na, nb);
+                if (cpy)
+                    tst_free_all (par);
+                else
+                    tst_free (par);
+            }
+            if (cpy)
+                tst_free_all (serial);
+            else
+                tst_free (serial);
+        }
+    }
+    printf ("%-8s %zu builds  %s\n", "parallel", nbuilds,
+            fail ? "FAILED" : "ok");
+
+    free (nb);
+    free (na);
+    free (shuf);
+    free (u);
+
+    return fail;
+}
+
+/** length-delimited key (tst_ins_del_len()) and its count in the tree */
+typedef struct {
+    char *s;
+    size_t len;
+    unsigned cnt;
+} len_key;
+
+/** key 'i' of 'len' bytes from word 'w' of 'wl' chars: the word, the word
+ *  twice about a 0 or 0x01 byte, or the word repeated (separated by ' ' or
+ *  a 0 byte) to 'len' bytes. nul-terminated after 'len' bytes.
+ */
+static char *len_key_of (const size_t i, const char *w, const size_t wl,
+                        size_t *len)
+{
+    char *s;
+
+    switch (i % 4) {
+        case 0:  *len = wl; break;
+        case 3:  *len = 256 + rand_int (TST_KEYMAX - 512); break;
+        default: *len = 2 * wl + 1; break;
+    }
+    if (!(s = malloc (*len + 1))) {
+        fprintf (stderr, "error: memory exhausted, len keys.\n");
+        exit (EXIT_FAILURE);
+    }
+    memcpy (s, w, wl);
+    if (i % 4 == 1 || i % 4 == 2) {
+        s[wl] = i % 4 == 1 ? 0 : 1;
+        memcpy (s + wl + 1, w, wl);
+    }
+    else if (i % 4 == 3)
+        for (size_t j = 0; j < *len; j++)
+            s[j] = j % (wl + 1) < wl ? w[j % (wl + 1)] : i % 8 == 3 ? ' ' : 0;
+    s[*len] = 0;
+
+    return s;
+}
+
+/** compare keys 'a' of 'na' and 'b' of 'nb' bytes in byte order. */
+static int cmp_len (const char *a, const size_t na, const char *b,
+                    const size_t nb)
+{
+    int cmp = memcmp (a, b, na < nb ? na : nb);
+
+    return cmp ? cmp : (na > nb) - (na < nb);
+}
+
+/** found key 'p' for key 'k' is a copy of 'len' bytes, nul-terminated.
+ *  returns 0 if so, 1 otherwise (reported as 'op').
+ */
+static int same_len_key (const char *op, const char *p, const len_key *k)
+{
+    if (!p || memcmp (p, k->s, k->len) || p[k->len]) {
+        fprintf (stderr, "error: len %s, key of %zu bytes '%s' %s.\n", op,
+                k->len, k->s, p ? "differs" : "not found");
+        return 1;
+    }
+
+    return 0;
+}
+
+/** random insert and delete by copy of keys holding 0 and 0x01 bytes and
+ *  keys of up to TST_KEYMAX bytes with tst_ins_del_len(), deletes passing
+ *  the tree's own copy of the key. search, text key search, prefix
+ *  listing and delete of absent keys are checked against the counts kept.
+ */
+static int check_len (char **words, size_t n)
+{
+    enum { NK = 2000 };
+    size_t nu, nk, nops = 0, live = 0;
+    char **u = unique_words (words, n, &nu), **a;
+    size_t *lens;
+    len_key *k;
+    node_tst *root = NULL;
+    int fail = 0, na = 0;
+
+    nk = nu < NK ? nu : NK;
+    k = malloc ((nk ? nk : 1) * sizeof *k);
+    a = malloc ((nk ? nk : 1) * sizeof *a);
+    lens = malloc ((nk ? nk : 1) * sizeof *lens);
+    if (!k || !a || !lens) {
+        fprintf (stderr, "error: memory exhausted, len keys.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < nk; i++) {
+        k[i].s = len_key_of (i, u[i], strlen (u[i]), &k[i].len);
+        k[i].cnt = 0;
+    }
+
+    for (; nops < 6 * nk && !fail; nops++) {
+        len_key *ki = k + rand_int (nk);
+        char *p = tst_search_len (root, ki->s, ki->len);
+
+        if ((p != NULL) != (ki->cnt != 0)) {
+            fprintf (stderr, "error: len search, key of %zu bytes '%s' "
+                    "count %u.\n", ki->len, ki->s, ki->cnt);
+            fail = 1;
+        }
+        else if (rand_int (3) == 0 && ki->cnt) {    /* delete by tree copy */
+            if (same_len_key ("delete", p, ki))
+                fail = 1;
+            else if (!tst_ins_del_len (&root, &p, ki->len, DEL, CPY) !=
+                        (ki->cnt == 1)) {
+                fprintf (stderr, "error: len delete, key of %zu bytes '%s' "
+                        "return at count %u.\n", ki->len, ki->s, ki->cnt);
+                fail = 1;
+            }
+            live -= --ki->cnt == 0;
+        }
+        else if (rand_int (3) == 0 && !ki->cnt) {   /* delete absent key */
+            size_t nodes = tst_nodes (root);
+            if (tst_ins_del_len (&root, &ki->s, ki->len, DEL, CPY) ||
+                    tst_nodes (root) != nodes ||
+                    tst_search_len (root, ki->s, ki->len)) {
+                fprintf (stderr, "error: len delete, absent key of %zu bytes "
+                        "'%s' changed tree.\n", ki->len, ki->s);
+                fail = 1;
+            }
+        }
+        else {
+            char *ins = tst_ins_del_len (&root, &ki->s, ki->len, INS, CPY);
+            if (same_len_key ("insert", ins, ki) || (p && ins != p))
+                fail = 1;
+            live += ki->cnt++ == 0;
+        }
+    }
+
+    for (size_t i = 0; i < nk && !fail; i++) {
+        char *p = tst_search_len (root, k[i].s, k[i].len);
+        if (k[i].cnt && (same_len_key ("search", p, k + i) ||
+                (i % 4 == 0 && tst_search (root, k[i].s) != p)))
+            fail = 1;
+        else if (!k[i].cnt && p) {
+            fprintf (stderr, "error: len search, deleted key of %zu bytes "
+                    "'%s' found.\n", k[i].len, k[i].s);
+            fail = 1;
+        }
+    }
+    if (!fail && live && !tst_search_prefix_len (root, "", 0, a, lens, &na,
+                                                nk))
+        fail = 1;
+    for (int i = 1; i < na && !fail; i++)
+        if (cmp_len (a[i - 1], lens[i - 1], a[i], lens[i]) >= 0) {
+            fprintf (stderr, "error: len prefix, key %d '%s' out of order.\n",
+                    i, a[i]);
+            fail = 1;
+        }
+    if (!fail && (size_t)na != live) {
+        fprintf (stderr, "error: len prefix, %d keys expected %zu.\n", na,
+                live);
+        fail = 1;
+    }
+
+    for (size_t i = 0; i < nk && !fail; i++)     /* delete all, own copy */
+        for (; k[i].cnt && !fail; k[i].cnt--) {
+            char *p = tst_search_len (root, k[i].s, k[i].len);
+            if (same_len_key ("delete", p, k + i) ||
+                    !tst_ins_del_len (&root, &p, k[i].len, DEL, CPY) !=
+                    (k[i].cnt == 1))
+                fail = 1;
+        }
+    if (!fail && root) {
+        fprintf (stderr, "error: len, tree not empty after delete all.\n");
+        fail = 1;
+    }
+    printf ("%-8s %zu keys, %zu ops  %s\n", "len", nk, nops,
+            fail ? "FAILED" : "ok");
+
+    tst_free (root);
+    for (size_t i = 0; i < nk; i++)
+        free (k[i].s);
+    free (lens);
+    free (a);
+    free (k);
+    free (u);
+
+    return fail;
+}
+
+/** tst_load_mapped() of the words written one per line (CRLF line ends
+ *  and empty lines mixed in) vs. a plain tree of the words by reference
+ *  in the same order (same words, refcnt and shape), then after deleting
+ *  every other word from both by reference. word file removed after.
+ */
+static int check_mapped (char **words, size_t n)
+{
+    const char *path = "tst_check.words";
+    node_tst *root = NULL, *plain = NULL;
+    const void **na = malloc ((n + 1) * sizeof *na),
+               **nb = malloc ((n + 1) * sizeof *nb);
+    tst_mapped *m;
+    FILE *fp = fopen (path, "w");
+    int fail = 0;
+
+    if (!na || !nb) {
+        fprintf (stderr, "error: memory exhausted, mapped nodes.\n");
+        exit (EXIT_FAILURE);
+    }
+    if (!fp) {
+        fprintf (stderr, "error: file open failed '%s'.\n", path);
+        exit (EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++)
+        fprintf (fp, "%s%s%s", i % 7 ? "" : "\n", words[i],
+                i % 3 ? "\n" : "\r\n");
+    if (fclose (fp) || !(m = tst_load_mapped (path, &root))) {
+        fprintf (stderr, "error: tst_load_mapped '%s' failed.\n", path);
+        remove (path);
+        exit (EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++)
+        if (!tst_ins_del (&plain, &words[i], INS, REF)) {
+            fprintf (stderr, "error: mapped, plain insert failed.\n");
+            exit (EXIT_FAILURE);
+        }
+
+    if (tst_mapped_words (m) != n) {
+        fprintf (stderr, "error: mapped, %zu words loaded expected %zu.\n",
+                tst_mapped_words (m), n);
+        fail = 1;
+    }
+    if (!fail)
+        fail = same_shape ("mapped", root, plain, na, nb);
+    for (size_t i = 0; i < n && !fail; i += 2) {   /* delete by reference */
+        char *p = tst_search (root, words[i]),
+             *q = tst_search (plain, words[i]);
+        if (!p || !q) {
+            fprintf (stderr, "error: mapped delete, '%s' not found.\n",
+                    words[i]);
+            fail = 1;
+        }
+        else {
+            tst_ins_del (&root, &p, DEL, REF);
+            tst_ins_del (&plain, &q, DEL, REF);
+        }
+    }
+    if (!fail)
+        fail = same_shape ("mapped delete", root, plain, na, nb);
+    printf ("%-8s %zu words  %s\n", "mapped", n, fail ? "FAILED" : "ok");
+
+    tst_mapped_free (m);
+    remove (path);
+    tst_free (plain);
+    free (nb);
+    free (na);
+
+    return fail;
+}
+
+/** values expected in a map of the unique words 'u', each word's value
+ *  in 'val' if 'in' is set, and the words counted by a traversal.
+ */
+typedef struct {
+    char **u;
+    size_t nu, n;
+    uint64_t *val;
+    char *in;
+    int cpy, fail;
+} map_vals;
+
+/** traversal callback, the word of a map by copy must be expected with
+ *  the same value.
+ */
+static void map_word (const void *node, void *data)
+{
+    map_vals *mv = data;
+    char *s = tst_get_string (node), **w;
+
+    mv->n++;
+    if (mv->cpy == TST_NOKEY || mv->fail)
+        return;
+    w = bsearch (&s, mv->u, mv->nu, sizeof *mv->u, cmp_str);
+    if (!w || !mv->in[w - mv->u] || mv->val[w - mv->u] !=
+            tst_map_value (node)->u) {
+        fprintf (stderr, "error: map traverse, '%s' value differs.\n", s);
+        mv->fail = 1;
+    }
+}
+
+/** random put, upsert, update, get and delete of unique words in a map by
+ *  copy and a TST_NOKEY map vs. the values expected. get of every word,
+ *  traversal with tst_map_value() and delete of all words must agree.
+ */
+static int check_map (char **words, size_t n)
+{
+    const int cpys[] = { CPY, TST_NOKEY };
+    size_t nu, nops = 0;
+    char **u = unique_words (words, n, &nu), *in = calloc (nu + 1, 1);
+    uint64_t *val = malloc ((nu + 1) * sizeof *val);
+    int fail = 0;
+
+    if (!in || !val) {
+        fprintf (stderr, "error: memory exhausted, map values.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t c = 0; c < sizeof cpys / sizeof *cpys && !fail; c++) {
+        map_vals mv = { u, nu, 0, val, in, cpys[c], 0 };
+        node_tst *root = NULL;
+        size_t nin = 0;
+
+        memset (in, 0, nu);
+        for (size_t k = 0; k < 4 * nu && !fail; k++, nops++) {
+            size_t i = rand_int (nu);
+            uint64_t v = rand();
+            tst_value *p, got;
+            int found;
+
+            switch (rand_int (5)) {
+                case 0: p = tst_map_put (&root, &u[i], cpys[c],
+                                        (tst_value){ .u = v });
+                        fail = !p || p->u != v;
+                        val[i] = v, in[i] = 1;
+                        break;
+                case 1: p = tst_map_upsert (&root, &u[i], cpys[c], &found);
+                        fail = !p || found != in[i] || (!found && p->u);
+                        if (!fail)
+                            val[i] = p->u += v;
+                        in[i] = 1;
+                        break;
+                case 2: p = tst_map_update (root, u[i]);
+                        fail = !p != !in[i];
+                        if (p && !fail)
+                            val[i] = ++p->u;
+                        break;
+                case 3: fail = (tst_map_del (&root, u[i], cpys[c], &got) == 0)
+                                != in[i] || (in[i] && got.u != val[i]);
+                        in[i] = 0;
+                        break;
+                default: {
+                        const tst_value *g = tst_map_get (root, u[i]);
+                        fail = !g != !in[i] || (g && g->u != val[i]);
+                    }
+            }
+            if (fail)
+                fprintf (stderr, "error: map (cpy %d), op %zu on '%s'.\n",
+                        cpys[c], k, u[i]);
+        }
+
+        for (size_t i = 0; i < nu && !fail; i++) {
+            const tst_value *g = tst_map_get (root, u[i]);
+            if (!g != !in[i] || (g && g->u != val[i])) {
+                fprintf (stderr, "error: map (cpy %d) get '%s'.\n",
+                        cpys[c], u[i]);
+                fail = 1;
+            }
+            nin += in[i];
+        }
+        if (!fail) {
+            tst_traverse_fn (root, map_word, &mv);
+            if (!mv.fail && mv.n != nin) {
+                fprintf (stderr, "error: map (cpy %d) traverse, word count "
+                        "differs.\n", cpys[c]);
+                mv.fail = 1;
+            }
+            fail = mv.fail;
+        }
+        for (size_t i = 0; i < nu && !fail; i++)
+            if (in[i] && tst_map_del (&root, u[i], cpys[c], NULL)) {
+                fprintf (stderr, "error: map (cpy %d) delete '%s'.\n",
+                        cpys[c], u[i]);
+                fail = 1;
+            }
+        if (!fail && root) {
+            fprintf (stderr, "error: map (cpy %d), tree not empty after "
+                    "delete all.\n", cpys[c]);
+            fail = 1;
+        }
+        tst_free (root);
+    }
+    printf ("%-8s %zu ops  %s\n", "map", nops, fail ? "FAILED" : "ok");
+
+    free (val);
+    free (in);
+    free (u);
+
+    return fail;
+}
+
+/** length of the longest of the 'nu' words 'u' that is a prefix of the
+ *  first 'len' chars of 'text' (0 if none).
+ */
+static size_t longest_of (char **u, size_t nu, const char *text, size_t len)
+{
+    size_t best = 0;
+
+    for (size_t i = 0; i < nu; i++) {
+        size_t wl = strlen (u[i]);
+        if (wl > best && wl <= len && !strncmp (u[i], text, wl))
+            best = wl;
+    }
+
+    return best;
+}
+
+/** matches of a longest scan, offset and length of each. */
+typedef struct {
+    size_t (*m)[2];
+    size_t n;
+} scan_list;
+
+static void add_match (const node_tst *node, size_t off, size_t len,
+                        void *data)
+{
+    scan_list *l = data;
+
+    (void)node;
+    l->m[l->n][0] = off;
+    l->m[l->n++][1] = len;
+}
+
+/** tst_longest_prefix() and tst_longest_scan() of texts made of words and
+ *  edited words run together, on a plain, a path-compressed and a keyless
+ *  tree of part of the words, vs. a scan of the words for the longest
+ *  prefix (the word itself checked for the plain tree).
+ */
+static int check_longest (char **words, size_t n)
+{
+    enum { NQ = 300, TXTMAX = 4 * WRDMAX };
+    node_tst *root[3] = { NULL, NULL, NULL };
+    const char *name[3] = { "plain", "path", "keyless" };
+    size_t nu, nmatch = 0;
+    char **u = subset_tree (words, n, &root[0], &nu), text[TXTMAX];
+    scan_list got = { malloc (TXTMAX * sizeof *got.m), 0 },
+              exp = { malloc (TXTMAX * sizeof *exp.m), 0 };
+    int fail = 0;
+
+    if (!got.m || !exp.m) {
+        fprintf (stderr, "error: memory exhausted, scan matches.\n");
+        exit (EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < nu; i++)
+        if (!tst_pc_ins_del (&root[1], &u[i], INS, CPY) ||
+                !tst_ins_del (&root[2], &u[i], INS, TST_NOKEY)) {
+            fprintf (stderr, "error: longest, insert '%s' failed.\n", u[i]);
+            exit (EXIT_FAILURE);
+        }
+
+    for (size_t q = 0; q < NQ && nu && !fail; q++) {
+        size_t tl = 0, len;
+        for (int k = 1 + rand_int (4); k; k--) {    /* words run together */
+            char query[WRDMAX];
+            size_t ql;
+            if (rand_int (2))
+                edited_word (u, nu, query);
+            else
+                strcpy (query, words[rand_int (n)]);
+            ql = strlen (query);
+            if (tl + ql >= TXTMAX)
+                break;
+            memcpy (text + tl, query, ql + 1);
+            tl += ql;
+        }
+        len = rand_int (tl + 3);                    /* past the nul too */
+
+        exp.n = 0;                                  /* expected scan */
+        for (size_t off = 0, end = len < tl ? len : tl; off < end; ) {
+            size_t m = longest_of (u, nu, text + off, end - off);
+            if (m) {
+                exp.m[exp.n][0] = off;
+                exp.m[exp.n++][1] = m;
+            }
+            off += m ? m : 1;
+        }
+        nmatch += exp.n;
+
+        for (int t = 0; t < 3 && !fail; t++) {
+            size_t mlen = 0, best = longest_of (u, nu, text, len);
+            const node_tst *w = tst_longest_prefix (root[t], text, len, &mlen);
+            if (!w != !best || (w && mlen != best) || (w && t == 0 &&
+                    (strlen (tst_get_string (w)) != best ||
+                    strncmp (tst_get_string (w), text, best)))) {
+                fprintf (stderr, "error: longest %s, '%.*s' matched %zu "
+                        "expected %zu.\n", name[t], (int)len, text,
+                        w ? mlen : 0, best);
+                fail = 1;
+            }
+            got.n = 0;
+            if (!fail && (tst_longest_scan (root[t], text, len, add_match,
+                                            &got) != exp.n || got.n != exp.n ||
+                    memcmp (got.m, exp.m, got.n * sizeof *got.m))) {
+                fprintf (stderr, "error: longest %s scan, '%.*s' %zu matches "
+                        "expected %zu.\n", name[t], (int)len, text, got.n,
+                        exp.n);
+                fail = 1;
+            }
+        }
+    }
+    printf ("%-8s %d texts, %zu matches  %s\n", "longest", NQ, nmatch,
+            fail ? "FAILED" : "ok");
+
+    tst_free (root[0]);
+    tst_free_all (root[1]);
+    tst_free (root[2]);
+    free (exp.m);
+    free (got.m);
+    free (u);
+
+    return fail;
+}
+
+/** tree kept by its own insert/delete (see tst_wide_ins_del() and
+ *  tst_burst_ins_del()), checked at each level size in 'size'.
+ */
+typedef struct {
+    const char *name;
+    void *(*ins_del)(node_tst **, char * const *, const int, const int,
+                    const int);
+    void *(*search)(const node_tst *, const char *);
+    void *(*prefix)(const node_tst *, const char *, char **, int *,
+                    const int);
+    int size[3];
+} level_tree;
+
+/** random insert and delete of words in tree 'lt' and a plain tree, for
+ *  each level size. search, prefix search, traversal, fuzzy and pattern
+ *  search of the two must agree, also after tst_rebalance().
+ */
+static int check_level (const level_tree *lt, char **words, size_t n)
+{
+    enum { NQ = 200 };
+    char **u, **got, **exp, pre[WRDMAX], name[32];
+    size_t nu, nops = 0, nlevels = 0;
+    unsigned *cnt;
+    int fail = 0;
+
+    if (!n)
+        return 0;
+    u = unique_words (words, n, &nu);
+    got = malloc (nu * sizeof *got);
+    exp = malloc (nu * sizeof *exp);
+    cnt = malloc (nu * sizeof *cnt);
+    if (!got || !exp || !cnt) {
+        fprintf (stderr, "error: memory exhausted, match arrays.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    for (size_t t = 0; t < sizeof lt->size / sizeof *lt->size && !fail; t++) {
+        node_tst *plain = NULL, *tree = NULL;
+        const int size = lt->size[t];
+        tst_stats_t st;
+
+        sprintf (name, "%s %d", lt->name, size);
+        memset (cnt, 0, nu * sizeof *cnt);
+        for (size_t k = 0; k < 4 * nu && !fail; k++, nops++) {
+            size_t i = rand_int (nu);
+            int del = !(rand_int (3) && cnt[i] < 2);
+            void *x, *y;
+            if (del && !cnt[i])
+                continue;
+            x = tst_ins_del (&plain, &u[i], del, REF);
+            y = lt->ins_del (&tree, &u[i], del, REF, size);
+            if (!x != !y) {
+                fprintf (stderr, "error: %s %s '%s'.\n", name,
+                        del ? "delete" : "insert", u[i]);
+                fail = 1;
+            }
+            cnt[i] += del ? -1 : 1;
+        }
+
+        for (size_t i = 0; i < nu && !fail; i++)
+            if (!tst_search (plain, u[i]) != !lt->search (tree, u[i])) {
+                fprintf (stderr, "error: %s search '%s'.\n", name, u[i]);
+                fail = 1;
+            }
+        for (size_t q = 0; q < NQ && !fail; q++) {
+            const char *w = u[rand_int (nu)];
+            size_t len = strlen (w);
+            int na = 0, nb = 0;
+            if (len > 1)                    /* proper prefix */
+                len = 1 + rand_int (len - 1);
+            if (len >= WRDMAX)
+                len = WRDMAX - 1;
+            memcpy (pre, w, len);
+            pre[len] = 0;
+            lt->prefix (tree, pre, got, &na, nu);
+            tst_search_prefix (plain, pre, exp, &nb, nu);
+            fail = same_words (name, pre, got, na, exp, nb);
+        }
+        if (!fail)
+            fail = same_trees (name, tree, plain, words, n, got, exp, nu);
+        if (!fail && tst_rebalance (&tree))
+            fail = same_trees (name, tree, plain, words, n, got, exp, nu);
+        if (tst_stats (tree, &st))
+            nlevels += st.wide + st.buckets;
+
+        for (size_t i = 0; i < nu && !fail; i++)  /* delete all */
+            for (; cnt[i]; cnt[i]--) {
+                tst_ins_del (&plain, &u[i], DEL, REF);
+                lt->ins_del (&tree, &u[i], DEL, REF, size);
+            }
+        if (!fail && (plain || tree)) {
+            fprintf (stderr, "error: %s, tree not empty after delete.\n",
+                    name);
+            fail = 1;
+        }
+        tst_free (plain);
+        tst_free (tree);
+    }
+    printf ("%-8s %zu ops, %zu levels  %s\n", lt->name, nops, nlevels,
+            fail ? "FAILED" : "ok");
+
+    free (cnt);
+    free (exp);
+    free (got);
+    free (u);
+
+    return fail;
+}
+
+/** wide tree (tst_wide_ins_del()) at 'min' 2, 4 and 16 vs. a plain tree. */
+static int check_wide (char **words, size_t n)
+{
+    const level_tree wide = { "wide", tst_wide_ins_del, tst_wide_search,
+                                tst_wide_search_prefix, { 2, 4, 16 } };
+
+    return check_level (&wide, words, n);
+}
+
+/** burst tree (tst_burst_ins_del()) at 'max' 1, 4 and 32 vs. a plain tree. */
+static int check_burst (char **words, size_t n)
+{
+    const level_tree burst = { "burst", tst_burst_ins_del, tst_burst_search,
+                                tst_burst_search_prefix, { 1, 4, 32 } };
+
+    return check_level (&burst, words, n);
+}
+
+/** available checks, run in order if none named on command line. */
+static const struct {
+    const char *name;
+    int (*fn)(char **, size_t);
+} checks[] = {
+    { "arena", check_arena },
+    { "compact", check_cpt },
+    { "frozen", check_frozen },
+    { "image", check_image },
+    { "rebal", check_rebalance },
+    { "path", check_pc },
+    { "keyless", check_keyless },
+    { "cursor", check_cursor },
+    { "topk", check_topk },
+    { "fuzzy", check_fuzzy },
+    { "pattern", check_pattern },
+    { "batch", check_batch },
+    { "conc", check_conc },
+    { "pers", check_pers },
+    { "shard", check_shard },
+    { "parallel", check_parallel },
+    { "len", check_len },
+    { "mapped", check_mapped },
+    { "map", check_map },
+    { "longest", check_longest },
+    { "wide", check_wide },
+    { "burst", check_burst },
+};
+static const size_t nchecks = sizeof checks / sizeof *checks;
+
+int main (int argc, char **argv) {
+
+    char word[WRDMAX] = "",
+        **words = NULL;
+    size_t idx = 0, nptrs = WRDMAX;
+    int fail = 0;
+    FILE *fp = argc > 1 ? fopen (argv[1], "r") : stdin;
+
+    if (!fp) {  /* validate file open for reading */
+        fprintf (stderr, "error: file open failed '%s'.\n", argv[1]);
+        return 1;
+    }
+
+    if (!(words = calloc (nptrs, sizeof *words))) {
+        fprintf (stderr, "error: memory exhausted words ptrs.");
+        return 1;
+    }
+
+    while (fscanf (fp, "%255s", word) == 1) {   /* read words, 1 per-line */
+        size_t len = strlen (word);
+        if (!(words[idx] = malloc (len + 1))) {
+            fprintf (stderr, "error: memory exhausted, words[%zu]\n", idx);
+            return 1;
+        }
+        memcpy (words[idx], word, len + 1);
+        if (++idx == nptrs)         /* realloc as required */
+            words = xrealloc (words, sizeof *words, &nptrs);
+    }
+    if (fp != stdin) fclose (fp);   /* close file if not stdin */
+    printf ("tst_check, loaded %zu words.\n\n", idx);
+
+    for (size_t i = 0; i < nchecks; i++) {  /* run named or all checks */
+        int run = argc < 3;
+        for (int j = 2; j < argc && !run; j++)
+            run = strcmp (argv[j], checks[i].name) == 0;
+        if (run) {
+            srand (1);              /* fixed seed, same queries every run */
+            fail |= checks[i].fn (words, idx);
+        }
+    }
+
+    for (size_t i = 0; i < idx; i++)
+        free (words[i]);
+    free (words);
+
+    return fail;
+}
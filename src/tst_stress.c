@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 199309L     /* for clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <threads.h>
+#include <time.h>
+
+#include "ternary_st.h"
+
+/** constants insert, delete, max word(s), max readers */
+enum { INS, DEL, WRDMAX = 256, LMAX = 1024, RDRMAX = 64 };
+
+/** shared stress state. words at even index are inserted once and never
+ *  deleted (stable), words at odd index are inserted and deleted by the
+ *  writer while the readers search.
+ */
+typedef struct {
+    tst_conc *c;
+    char **words;
+    size_t n;
+    atomic_int stop;
+    atomic_ulong errors;
+} stress_t;
+
+/** per reader state. */
+typedef struct {
+    stress_t *st;
+    unsigned long long rnd;
+    unsigned long lookups, prefixes;
+} reader_t;
+
+/** xorshift random for each thread (rand() is shared state) */
+static size_t xrand (unsigned long long *x, size_t n)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+
+    return *x % n;
+}
+
+/** report failure 'msg' for word 'w' */
+static void fail (stress_t *st, const char *msg, const char *w)
+{
+    if (atomic_fetch_add (&st->errors, 1) < 10)
+        fprintf (stderr, "error: %s '%s'\n", msg, w);
+}
+
+/** reader thread, searches and prefix searches checking each result. a
+ *  stable word must always be found, a churned word found or not, and each
+ *  word returned is read (freed memory is caught with -fsanitize=address).
+ */
+static int reader (void *arg)
+{
+    reader_t *r = arg;
+    stress_t *st = r->st;
+    char *a[LMAX];
+    int id = tst_conc_register (st->c);
+
+    if (id < 0)
+        return 1;
+
+    while (!atomic_load (&st->stop)) {
+        size_t i = xrand (&r->rnd, st->n);
+        const char *w = st->words[i], *found;
+
+        tst_conc_read_begin (st->c, id);
+        found = tst_conc_search (st->c, w);
+        if (found ? strcmp (found, w) != 0 : i % 2 == 0)
+            fail (st, "tst_conc_search", w);
+        r->lookups++;
+
+        if (i % 16 == 0 && strlen (w) > 2) {    /* 2 char prefix */
+            char prefix[3] = { w[0], w[1], 0 };
+            int n = 0;
+            tst_conc_search_prefix (st->c, prefix, a, &n, LMAX);
+            for (int j = 0; j < n; j++)
+                if (strncmp (a[j], prefix, 2) ||
+                        (j && strcmp (a[j - 1], a[j]) >= 0))
+                    fail (st, "tst_conc_search_prefix", prefix);
+            r->prefixes++;
+        }
+        tst_conc_read_end (st->c, id);
+    }
+    tst_conc_unregister (st->c, id);
+
+    return 0;
+}
+
+int main (int argc, char **argv) {
+
+    char word[WRDMAX] = "",
+        **words = NULL;
+    size_t idx = 0, nptrs = WRDMAX, nrdr = argc > 2 ? strtoul (argv[2], 0, 0) : 4;
+    double secs = argc > 3 ? strtod (argv[3], NULL) : 2.0;
+    unsigned char *in = NULL;
+    int id;
+    unsigned long long wrnd = 88172645463325252ull;
+    unsigned long ins = 0, del = 0, lookups = 0, prefixes = 0;
+    FILE *fp = argc > 1 ? fopen (argv[1], "r") : stdin;
+    stress_t st = { .c = NULL };
+    reader_t rd[RDRMAX];
+    thrd_t tid[RDRMAX];
+    struct timespec t0, t1;
+
+    if (!fp) {  /* validate file open for reading */
+        fprintf (stderr, "error: file open failed '%s'.\n", argv[1]);
+        return 1;
+    }
+    if (nrdr < 1 || nrdr > RDRMAX) {
+        fprintf (stderr, "error: readers 1 - %d.\n", RDRMAX);
+        return 1;
+    }
+
+    if (!(words = malloc (nptrs * sizeof *words))) {
+        fprintf (stderr, "error: memory exhausted words ptrs.");
+        return 1;
+    }
+    while (fscanf (fp, "%255s", word) == 1) {   /* read words, 1 per-line */
+        size_t len = strlen (word);
+        if (!(words[idx] = malloc (len + 1))) {
+            fprintf (stderr, "error: memory exhausted, words[%zu]\n", idx);
+            return 1;
+        }
+        memcpy (words[idx], word, len + 1);
+        if (++idx == nptrs) {       /* realloc as required */
+            void *tmp = realloc (words, 2 * nptrs * sizeof *words);
+            if (!tmp) {
+                fprintf (stderr, "error: memory exhausted words ptrs.");
+                return 1;
+            }
+            words = tmp;
+            nptrs *= 2;
+        }
+    }
+    if (fp != stdin) fclose (fp);   /* close file if not stdin */
+    if (idx < 2) {
+        fprintf (stderr, "error: 2 or more words required.\n");
+        return 1;
+    }
+    printf ("tst_stress, loaded %zu words, %zu readers, %.1f sec.\n",
+            idx, nrdr, secs);
+
+    if (!(st.c = tst_conc_create (1)) || !(in = calloc (idx, 1)))
+        return 1;
+    st.words = words;
+    st.n = idx;
+    atomic_init (&st.stop, 0);
+    atomic_init (&st.errors, 0);
+
+    for (size_t i = 0; i < idx; i += 2)     /* stable words */
+        if (!tst_conc_ins_del (st.c, &words[i], INS))
+            return 1;
+
+    for (size_t i = 0; i < nrdr; i++) {
+        rd[i] = (reader_t){ .st = &st, .rnd = 2463534242ull * (i + 1) };
+        if (thrd_create (&tid[i], reader, &rd[i]) != thrd_success) {
+            fprintf (stderr, "error: thrd_create failed.\n");
+            return 1;
+        }
+    }
+
+    /* writer, toggle random churned words until time is up */
+    clock_gettime (CLOCK_MONOTONIC, &t0);
+    do {
+        for (int k = 0; k < 1000; k++) {
+            size_t i = xrand (&wrnd, idx / 2) * 2 + 1;
+            if (i >= idx)
+                continue;
+            if (!in[i]) {
+                if (!tst_conc_ins_del (st.c, &words[i], INS))
+                    fail (&st, "tst_conc_ins_del (INS)", words[i]);
+                ins++;
+            }
+            else {
+                if (tst_conc_ins_del (st.c, &words[i], DEL))
+                    fail (&st, "tst_conc_ins_del (DEL)", words[i]);
+                del++;
+            }
+            in[i] = !in[i];
+        }
+        clock_gettime (CLOCK_MONOTONIC, &t1);
+    } while (t1.tv_sec - t0.tv_sec + (t1.tv_nsec - t0.tv_nsec) / 1e9 < secs);
+
+    atomic_store (&st.stop, 1);
+    for (size_t i = 0; i < nrdr; i++) {
+        thrd_join (tid[i], NULL);
+        lookups += rd[i].lookups;
+        prefixes += rd[i].prefixes;
+    }
+
+    id = tst_conc_register (st.c);
+    tst_conc_read_begin (st.c, id);
+    for (size_t i = 0; i < idx; i++)        /* words in tree at end found */
+        if ((i % 2 == 0 || in[i]) && !tst_conc_search (st.c, words[i]))
+            fail (&st, "final tst_conc_search", words[i]);
+    tst_conc_read_end (st.c, id);
+    tst_conc_unregister (st.c, id);
+
+    printf ("%lu inserts, %lu deletes, %lu lookups, %lu prefix searches, "
+            "%lu errors.\n", ins, del, lookups, prefixes,
+            atomic_load (&st.errors));
+
+    tst_conc_destroy (st.c);
+    free (in);
+    for (size_t i = 0; i < idx; i++)
+        free (words[i]);
+    free (words);
+
+    return atomic_load (&st.errors) != 0;
+}
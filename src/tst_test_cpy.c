@@ -18,7 +18,7 @@ double tvgetf (void)
     struct timespec ts;
     double sec;
 
-    clock_gettime(CLOCK_REALTIME,&ts);
+    clock_gettime(CLOCK_MONOTONIC,&ts);
     sec = ts.tv_nsec;
     sec /= 1e9;
     sec += ts.tv_sec;
@@ -12,13 +12,13 @@ enum { INS, DEL, WRDMAX = 256, STKMAX = 512, LMAX = 1024 };
 #define REF INS
 #define CPY DEL
 
-/** timing helper function */
+/** timing helper function (monotonic clock) */
 double tvgetf (void)
 {
     struct timespec ts;
     double sec;
 
-    clock_gettime(CLOCK_REALTIME,&ts);
+    clock_gettime(CLOCK_MONOTONIC,&ts);
     sec = ts.tv_nsec;
     sec /= 1e9;
     sec += ts.tv_sec;
@@ -99,7 +99,28 @@ int main (int argc, char **argv) {
         }
     }
     t2 = tvgetf();
-    printf ("ternary_tree, loaded %d words in %.6f sec\n\n", idx, t2-t1);
+    printf ("ternary_tree, loaded %d words in %.6f sec\n", idx, t2-t1);
+
+    {   /* compare lookup cost with balanced bulk build of same words */
+        node_tst *bulk = NULL;
+        size_t ncmp = 0, nbulk = 0;
+        t1 = tvgetf();
+        if (idx && !tst_build_sorted (&bulk, words, idx, REF)) {
+            fprintf (stderr, "error: memory exhausted, tst_build_sorted.\n");
+            return 1;
+        }
+        t2 = tvgetf();
+        for (int i = 0; i < idx; i++) {
+            ncmp += tst_search_cmp (root, words[i]);
+            nbulk += tst_search_cmp (bulk, words[i]);
+        }
+        printf ("tst_build_sorted, built %d words in %.6f sec\n", idx, t2-t1);
+        if (idx)
+            printf ("comparisons per lookup: insert order %.2f, "
+                    "bulk build %.2f\n\n", (double)ncmp / idx,
+                    (double)nbulk / idx);
+        tst_free (bulk);
+    }
 
     for (;;) {
         size_t len;